@@ -1,13 +1,10 @@
-QT += widgets
+TEMPLATE = subdirs
 
-INCLUDEPATH += src
+# core — логика без интерфейса (тесты, проверка, компиляция, запуск);
+# app — само приложение; benchmarks — замеры горячих участков core.
+SUBDIRS += core \
+           app \
+           benchmarks
 
-SOURCES += src/main.cpp \
-           src/loginwindow.cpp \
-           src/TestCreationDialog.cpp \
-           src/codeeditor.cpp \
-           src/mainwindow.cpp
-HEADERS += src/mainwindow.h \
-           src/loginwindow.h \
-           src/TestCreationDialog.h \
-           src/codeeditor.h \
+app.depends = core
+benchmarks.depends = core
@@ -0,0 +1,27 @@
+TEMPLATE = app
+TARGET = Project
+
+QT += widgets concurrent
+
+include(../core/core.pri)
+
+SRC = $$PWD/../src
+
+SOURCES += $$SRC/main.cpp \
+           $$SRC/loginwindow.cpp \
+           $$SRC/TestCreationDialog.cpp \
+           $$SRC/codeeditor.cpp \
+           $$SRC/cpphighlighter.cpp \
+           $$SRC/benchmarkdialog.cpp \
+           $$SRC/stressdialog.cpp \
+           $$SRC/diagnosticschecker.cpp \
+           $$SRC/mainwindow.cpp
+HEADERS += $$SRC/mainwindow.h \
+           $$SRC/loginwindow.h \
+           $$SRC/TestCreationDialog.h \
+           $$SRC/codeeditor.h \
+           $$SRC/cpphighlighter.h \
+           $$SRC/codeblockdata.h \
+           $$SRC/benchmarkdialog.h \
+           $$SRC/stressdialog.h \
+           $$SRC/diagnosticschecker.h
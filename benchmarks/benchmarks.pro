@@ -0,0 +1,10 @@
+TEMPLATE = app
+TARGET = benchmarks
+
+QT += testlib
+CONFIG += console testcase
+CONFIG -= app_bundle
+
+include(../core/core.pri)
+
+SOURCES += hotpathbenchmark.cpp
@@ -0,0 +1,604 @@
+#include <QtTest>
+#include <QRandomGenerator>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include "compilecache.h"
+#include "compilejob.h"
+#include "forbiddenscanner.h"
+#include "forkserver.h"
+#include "nestingindex.h"
+#include "outputchecker.h"
+#include "resultstore.h"
+#include "symbolindex.h"
+#include "testarchive.h"
+#include "testcatalog.h"
+#include "testrunner.h"
+#include "testsuiterunner.h"
+
+// Замеры горячих участков core. Данные строятся из фиксированного seed,
+// поэтому результаты разных коммитов сравнимы между собой:
+//   benchmarks -median 5 -o before.csv,csv
+namespace {
+
+const quint32 Seed = 2025;
+
+const char TrivialProgram[] =
+    "#include <cstdio>\n"
+    "int main() {\n"
+    "    int a, b;\n"
+    "    if (std::scanf(\"%d %d\", &a, &b) != 2)\n"
+    "        return 1;\n"
+    "    std::printf(\"%d\\n\", a + b);\n"
+    "}\n";
+
+QByteArray numbersText(qsizetype bytes, QRandomGenerator &random)
+{
+    QByteArray text;
+    text.reserve(bytes + 64);
+    while (text.size() < bytes) {
+        text += QByteArray::number(random.bounded(1000000));
+        text += ' ';
+        text += QByteArray::number(random.generateDouble() * 1000.0, 'f', 6);
+        text += '\n';
+    }
+    return text;
+}
+
+
+QString sourceText(int lines)
+{
+    // Типичный код решения с комментариями и строками, в которых тоже
+    // встречаются запрещённые слова.
+    const QStringList snippet = {
+        "#include <vector>",
+        "// goto здесь только в комментарии",
+        "static int solve(const std::vector<int> &values) {",
+        "    int total = 0;",
+        "    for (int value : values)",
+        "        total += value * 2 + (value >> 1);",
+        "    const char *label = \"printf and malloc in a string\";",
+        "    return total + int(label[0]);",
+        "}",
+        "",
+    };
+
+    QString code;
+    for (int i = 0; i < lines; ++i)
+        code += snippet.at(i % snippet.size()) + '\n';
+    return code;
+}
+
+
+// Код решения, целиком обёрнутый в namespace: парная скобка для первой '{'
+// стоит в последней строке файла.
+QStringList nestedSourceLines(int lines)
+{
+    QStringList result = sourceText(lines).split('\n');
+    result.prepend("namespace {");
+    result.append("}");
+    return result;
+}
+
+
+bool waitForCompile(CompileJob &job)
+{
+    QSignalSpy spy(&job, &CompileJob::finished);
+    job.start();
+    return (spy.count() > 0 || spy.wait(120000)) && job.status() == CompileJob::Status::Succeeded;
+}
+
+
+bool waitForIndex(SymbolIndex &index)
+{
+    QSignalSpy spy(&index, &SymbolIndex::indexFinished);
+    return !index.isIndexing() || spy.wait(60000);
+}
+
+
+bool waitForLoad(ResultStore &store)
+{
+    QSignalSpy spy(&store, &ResultStore::loadFinished);
+    return store.isLoaded() || spy.wait(60000);
+}
+
+}
+
+
+class HotPathBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void loadJsonTests_data();
+    void loadJsonTests();
+    void loadArchive_data();
+    void loadArchive();
+
+    void scanForbidden_data();
+    void scanForbidden();
+
+    void compareOutput_data();
+    void compareOutput();
+
+    void indexSymbols_data();
+    void indexSymbols();
+    void editSymbols();
+    void completeSymbols();
+    void matchBrackets();
+    void editNesting();
+
+    void loadResults_data();
+    void loadResults();
+    void queryResults_data();
+    void queryResults();
+
+    void compileTrivial();
+    void compileTrivialCached();
+    void runTrivial();
+    void runReadsInput();
+    void runSuite_data();
+    void runSuite();
+
+private:
+    QString writeTests(int files, int caseKb);
+    QString writeResults(int runs);
+    bool ensureTrivialExecutable();
+
+    QTemporaryDir workDir;
+    QString compiler;
+    QString trivialSource;
+    QString trivialExecutable;
+};
+
+
+void HotPathBenchmark::initTestCase()
+{
+    QVERIFY(workDir.isValid());
+    compiler = QStandardPaths::findExecutable("g++");
+
+    trivialSource = workDir.filePath("trivial.cpp");
+    QFile file(trivialSource);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(TrivialProgram);
+}
+
+
+QString HotPathBenchmark::writeTests(int files, int caseKb)
+{
+    QString directory = workDir.filePath(QString("tests-%1x%2").arg(files).arg(caseKb));
+    if (QFileInfo::exists(directory))
+        return directory;
+    QDir().mkpath(directory);
+
+    QRandomGenerator random(Seed);
+    for (int i = 0; i < files; ++i) {
+        TestDefinition test;
+        test.name = QString("Тест %1").arg(i, 4, 10, QChar('0'));
+        test.description = "Сгенерирован для замеров загрузки.";
+        test.forbidden << "goto";
+        TestCase testCase;
+        testCase.input = numbersText(qsizetype(caseKb) * 1024, random);
+        testCase.expected = numbersText(qsizetype(caseKb) * 1024 / 4, random);
+        test.cases.append(testCase);
+        test.save(QDir(directory).filePath(test.name + ".json"));
+    }
+    return directory;
+}
+
+
+void HotPathBenchmark::loadJsonTests_data()
+{
+    QTest::addColumn<int>("files");
+    QTest::addColumn<int>("caseKb");
+
+    QTest::newRow("1000 x 1 KB") << 1000 << 1;
+    QTest::newRow("200 x 256 KB") << 200 << 256;
+}
+
+
+void HotPathBenchmark::loadJsonTests()
+{
+    QFETCH(int, files);
+    QFETCH(int, caseKb);
+    QString directory = writeTests(files, caseKb);
+
+    QBENCHMARK {
+        QList<TestCatalog::Entry> entries = TestCatalog::loadDirectory(directory);
+        QCOMPARE(entries.size(), files);
+    }
+}
+
+
+void HotPathBenchmark::loadArchive_data()
+{
+    loadJsonTests_data();
+}
+
+
+void HotPathBenchmark::loadArchive()
+{
+    QFETCH(int, files);
+    QFETCH(int, caseKb);
+
+    QList<TestDefinition> tests;
+    const QList<TestCatalog::Entry> entries = TestCatalog::loadDirectory(writeTests(files, caseKb));
+    for (const TestCatalog::Entry &entry : entries)
+        tests.append(entry.test);
+
+    QString archivePath = workDir.filePath(QString("suite-%1x%2.%3").arg(files).arg(caseKb)
+                                               .arg(QLatin1String(TestArchive::Extension)));
+    QVERIFY(TestArchive::write(archivePath, tests));
+
+    QBENCHMARK {
+        QList<TestDefinition> loaded;
+        QVERIFY(TestArchive::load(archivePath, &loaded));
+        QCOMPARE(loaded.size(), files);
+    }
+}
+
+
+void HotPathBenchmark::scanForbidden_data()
+{
+    QTest::addColumn<int>("lines");
+
+    QTest::newRow("10k lines") << 10000;
+    QTest::newRow("100k lines") << 100000;
+}
+
+
+void HotPathBenchmark::scanForbidden()
+{
+    QFETCH(int, lines);
+    QString code = sourceText(lines);
+    ForbiddenScanner scanner(QStringList() << "goto" << "printf" << "malloc" << "std::sort" << "#include <map>"
+                                           << "register" << "system");
+
+    QBENCHMARK {
+        QList<ForbiddenScanner::Violation> violations = scanner.scan(code);
+        QVERIFY(violations.isEmpty());
+    }
+}
+
+
+void HotPathBenchmark::compareOutput_data()
+{
+    QTest::addColumn<int>("mode");
+    QTest::addColumn<int>("megabytes");
+
+    const QList<QPair<OutputChecker::Mode, const char *>> modes = {
+        {OutputChecker::Mode::Exact, "exact"},
+        {OutputChecker::Mode::Tokens, "tokens"},
+        {OutputChecker::Mode::Float, "float"},
+    };
+    for (const auto &mode : modes) {
+        for (int megabytes : {4, 16})
+            QTest::addRow("%s %d MB", mode.second, megabytes) << int(mode.first) << megabytes;
+    }
+}
+
+
+void HotPathBenchmark::compareOutput()
+{
+    QFETCH(int, mode);
+    QFETCH(int, megabytes);
+
+    QRandomGenerator random(Seed);
+    QByteArray expected = numbersText(qsizetype(megabytes) * 1024 * 1024, random);
+    OutputChecker::Options options;
+    options.mode = OutputChecker::Mode(mode);
+    const qsizetype chunkSize = 64 * 1024;
+
+    QBENCHMARK {
+        OutputChecker checker(expected, options);
+        for (qsizetype offset = 0; offset < expected.size(); offset += chunkSize)
+            checker.feed(expected.constData() + offset, qMin(chunkSize, expected.size() - offset));
+        QVERIFY(checker.finish());
+    }
+}
+
+
+QString HotPathBenchmark::writeResults(int runs)
+{
+    QString directory = workDir.filePath(QString("results-%1").arg(runs));
+    if (QFileInfo::exists(directory))
+        return directory;
+
+    // 200 тестов и 1000 версий решений; примерно треть запусков с ошибкой.
+    QRandomGenerator random(Seed);
+    ResultStore store(directory);
+    if (!waitForLoad(store))
+        return QString();
+    for (int i = 0; i < runs; ++i) {
+        int source = random.bounded(1000);
+        ResultStore::Run run;
+        run.timestampMs = 1700000000000 + i * 1000LL;
+        run.sourceHash = ResultStore::hashSource(QByteArray::number(source));
+        run.sourcePath = QString("/home/student%1/main.cpp").arg(source % 100);
+        run.profile = "Release";
+        run.test = QString("Тест %1").arg(random.bounded(200), 4, 10, QChar('0'));
+        run.verdict = random.bounded(3) == 0 ? TestResult::Verdict::WrongAnswer : TestResult::Verdict::Passed;
+        run.wallUs = 1000 + random.bounded(100000);
+        run.cpuUs = run.wallUs;
+        run.peakRssKb = 2048 + random.bounded(65536);
+        store.append(run);
+    }
+    return directory;
+}
+
+
+void HotPathBenchmark::loadResults_data()
+{
+    QTest::addColumn<int>("runs");
+
+    QTest::newRow("100k runs") << 100000;
+    QTest::newRow("300k runs") << 300000;
+}
+
+
+void HotPathBenchmark::loadResults()
+{
+    QFETCH(int, runs);
+    QString directory = writeResults(runs);
+    QVERIFY(!directory.isEmpty());
+
+    QBENCHMARK {
+        ResultStore store(directory);
+        QVERIFY(waitForLoad(store));
+        QCOMPARE(store.runCount(), runs);
+    }
+}
+
+
+void HotPathBenchmark::queryResults_data()
+{
+    loadResults_data();
+}
+
+
+void HotPathBenchmark::queryResults()
+{
+    QFETCH(int, runs);
+    QString directory = writeResults(runs);
+    QVERIFY(!directory.isEmpty());
+
+    ResultStore store(directory);
+    QVERIFY(waitForLoad(store));
+    QBENCHMARK {
+        const QList<ResultStore::CaseStats> stats = store.caseStats();
+        QCOMPARE(stats.size(), 200);
+        QVERIFY(!store.history("/home/student7/main.cpp").isEmpty());
+    }
+}
+
+
+void HotPathBenchmark::indexSymbols_data()
+{
+    scanForbidden_data();
+}
+
+
+void HotPathBenchmark::indexSymbols()
+{
+    QFETCH(int, lines);
+    const QStringList text = sourceText(lines).split('\n');
+
+    QBENCHMARK {
+        SymbolIndex index(nullptr);
+        index.replaceLines(0, 0, text);
+        QVERIFY(waitForIndex(index));
+        QVERIFY(index.symbolCount() > 0);
+    }
+}
+
+
+void HotPathBenchmark::editSymbols()
+{
+    // Одна изменённая строка в файле на 20 тысяч строк: разбирается только она.
+    SymbolIndex index(nullptr);
+    index.replaceLines(0, 0, sourceText(20000).split('\n'));
+    QVERIFY(waitForIndex(index));
+
+    int round = 0;
+    QBENCHMARK {
+        index.replaceLines(10003, 1, QStringList() << QString("    int total%1 = 0;").arg(round++));
+        QVERIFY(waitForIndex(index));
+    }
+}
+
+
+void HotPathBenchmark::completeSymbols()
+{
+    SymbolIndex index(nullptr);
+    index.replaceLines(0, 0, sourceText(20000).split('\n'));
+    QVERIFY(waitForIndex(index));
+
+    QBENCHMARK {
+        QStringList candidates = index.complete("va", 50);
+        QVERIFY(candidates.contains("values"));
+    }
+}
+
+
+void HotPathBenchmark::matchBrackets()
+{
+    NestingIndex index;
+    const QStringList lines = nestedSourceLines(20000);
+    index.replaceLines(0, 0, lines);
+
+    QBENCHMARK {
+        NestingIndex::Match forward = index.findMatch(0, 10);
+        NestingIndex::Match backward = index.findMatch(index.lineCount() - 1, 0);
+        QVERIFY(forward.matched && forward.line == index.lineCount() - 1);
+        QVERIFY(backward.matched && backward.line == 0);
+    }
+}
+
+
+void HotPathBenchmark::editNesting()
+{
+    // Лишняя '}' в середине файла меняет глубину всех следующих строк, но
+    // пересчитываются только сводки на пути к её листу.
+    NestingIndex index;
+    index.replaceLines(0, 0, nestedSourceLines(20000));
+
+    int round = 0;
+    QBENCHMARK {
+        QString line = round++ % 2 ? "    int total = 0; }" : "    int total = 0;";
+        index.replaceLines(10004, 1, QStringList() << line);
+        QVERIFY(index.findMatch(0, 10).isValid());
+    }
+}
+
+
+void HotPathBenchmark::compileTrivial()
+{
+    if (compiler.isEmpty())
+        QSKIP("g++ не найден в PATH.");
+
+    QString executable = workDir.filePath("trivial-plain");
+    QBENCHMARK {
+        CompileJob job(trivialSource, executable);
+        job.setFlags(QStringList() << "-O0");
+        QVERIFY(waitForCompile(job));
+    }
+}
+
+
+void HotPathBenchmark::compileTrivialCached()
+{
+    if (compiler.isEmpty())
+        QSKIP("g++ не найден в PATH.");
+
+    CompileCache cache(workDir.filePath("cache"));
+    QString executable = workDir.filePath("trivial-cached");
+    {
+        CompileJob job(trivialSource, executable);
+        job.setCache(&cache);
+        QVERIFY(waitForCompile(job));
+    }
+
+    QBENCHMARK {
+        CompileJob job(trivialSource, executable);
+        job.setCache(&cache);
+        QVERIFY(waitForCompile(job));
+        QVERIFY(job.isFromCache());
+    }
+}
+
+
+bool HotPathBenchmark::ensureTrivialExecutable()
+{
+    if (!trivialExecutable.isEmpty())
+        return true;
+
+    QString executable = workDir.filePath("trivial");
+    CompileJob job(trivialSource, executable);
+    job.setFlags(QStringList() << "-O2");
+    if (!waitForCompile(job))
+        return false;
+    trivialExecutable = job.executableFile();
+    return true;
+}
+
+
+void HotPathBenchmark::runTrivial()
+{
+    if (compiler.isEmpty())
+        QSKIP("g++ не найден в PATH.");
+    QVERIFY(ensureTrivialExecutable());
+
+    TestDefinition test;
+    TestCase testCase;
+    testCase.input = "2 3\n";
+    testCase.expected = "5\n";
+    test.cases.append(testCase);
+
+    QBENCHMARK {
+        TestRunner runner(trivialExecutable, test, 0);
+        QSignalSpy spy(&runner, &TestRunner::finished);
+        runner.start();
+        QVERIFY(spy.count() > 0 || spy.wait(30000));
+        QVERIFY2(runner.result().passed(), qPrintable(runner.result().details));
+    }
+}
+
+
+void HotPathBenchmark::runReadsInput()
+{
+    // cat читает весь stdin: мегабайт не помещается в буфер канала, поэтому
+    // запуск зависнет, если started придёт только после выхода программы.
+    QString cat = QStandardPaths::findExecutable("cat");
+    if (cat.isEmpty())
+        QSKIP("cat не найден в PATH.");
+
+    TestDefinition test;
+    TestCase testCase;
+    QRandomGenerator random(Seed);
+    testCase.input = numbersText(1 << 20, random);
+    testCase.expected = testCase.input;
+    test.cases.append(testCase);
+
+    QBENCHMARK {
+        TestRunner runner(cat, test, 0);
+        QSignalSpy spy(&runner, &TestRunner::finished);
+        runner.start();
+        QVERIFY(spy.count() > 0 || spy.wait(30000));
+        QVERIFY2(runner.result().passed(), qPrintable(runner.result().details));
+        QVERIFY(runner.result().wallUs > 0);
+    }
+}
+
+
+void HotPathBenchmark::runSuite_data()
+{
+    QTest::addColumn<bool>("forkServer");
+
+    QTest::newRow("QProcess") << false;
+    QTest::newRow("fork-server") << true;
+}
+
+
+void HotPathBenchmark::runSuite()
+{
+    QFETCH(bool, forkServer);
+    if (compiler.isEmpty())
+        QSKIP("g++ не найден в PATH.");
+    if (forkServer && !ForkServer::isSupported())
+        QSKIP("Fork-server работает только в Linux.");
+    QVERIFY(ensureTrivialExecutable());
+
+    TestDefinition test;
+    for (int i = 0; i < 200; ++i) {
+        TestCase testCase;
+        testCase.input = QByteArray::number(i) + " 1\n";
+        testCase.expected = QByteArray::number(i + 1) + "\n";
+        test.cases.append(testCase);
+    }
+    const QList<TestDefinition> tests = {test};
+
+    auto runOnce = [&] {
+        TestSuiteRunner runner(trivialExecutable, tests);
+        if (forkServer)
+            runner.setForkServer(compiler);
+        QSignalSpy spy(&runner, &TestSuiteRunner::allFinished);
+        runner.start();
+        QVERIFY(spy.count() > 0 || spy.wait(120000));
+        QCOMPARE(runner.passedCount(), int(test.cases.size()));
+        if (forkServer)
+            QCOMPARE(runner.forkServerCaseCount(), int(test.cases.size()));
+    };
+
+    // Первый прогон собирает прослойку и прогревает кэш страниц.
+    runOnce();
+    if (QTest::currentTestFailed())
+        return;
+    QBENCHMARK {
+        runOnce();
+    }
+}
+
+QTEST_GUILESS_MAIN(HotPathBenchmark)
+
+#include "hotpathbenchmark.moc"
@@ -0,0 +1,12 @@
+# Подключение статической библиотеки core к приложению и бенчмаркам.
+QT += concurrent
+INCLUDEPATH += $$PWD/../src
+
+win32:CONFIG(release, debug|release): CORE_DIR = $$OUT_PWD/../core/release
+else:win32:CONFIG(debug, debug|release): CORE_DIR = $$OUT_PWD/../core/debug
+else: CORE_DIR = $$OUT_PWD/../core
+
+LIBS += -L$$CORE_DIR -lpstucore
+
+win32-msvc*: PRE_TARGETDEPS += $$CORE_DIR/pstucore.lib
+else: PRE_TARGETDEPS += $$CORE_DIR/libpstucore.a
@@ -0,0 +1,57 @@
+TEMPLATE = lib
+CONFIG += staticlib
+TARGET = pstucore
+
+QT = core gui concurrent
+
+SRC = $$PWD/../src
+INCLUDEPATH += $$SRC
+
+SOURCES += $$SRC/cpplexer.cpp \
+           $$SRC/forbiddenscanner.cpp \
+           $$SRC/stagetrace.cpp \
+           $$SRC/compilejob.cpp \
+           $$SRC/compilecache.cpp \
+           $$SRC/buildprofile.cpp \
+           $$SRC/pchmanager.cpp \
+           $$SRC/resourcelimits.cpp \
+           $$SRC/outputchecker.cpp \
+           $$SRC/testdefinition.cpp \
+           $$SRC/testarchive.cpp \
+           $$SRC/testrunner.cpp \
+           $$SRC/testsuiterunner.cpp \
+           $$SRC/testcatalog.cpp \
+           $$SRC/referenceresolver.cpp \
+           $$SRC/benchmark.cpp \
+           $$SRC/benchmarkrunner.cpp \
+           $$SRC/stresstester.cpp \
+           $$SRC/batchgrader.cpp \
+           $$SRC/projectbuilder.cpp \
+           $$SRC/forkserver.cpp \
+           $$SRC/resultstore.cpp \
+           $$SRC/symbolindex.cpp \
+           $$SRC/nestingindex.cpp
+HEADERS += $$SRC/cpplexer.h \
+           $$SRC/forbiddenscanner.h \
+           $$SRC/stagetrace.h \
+           $$SRC/compilejob.h \
+           $$SRC/compilecache.h \
+           $$SRC/buildprofile.h \
+           $$SRC/pchmanager.h \
+           $$SRC/resourcelimits.h \
+           $$SRC/outputchecker.h \
+           $$SRC/testdefinition.h \
+           $$SRC/testarchive.h \
+           $$SRC/testrunner.h \
+           $$SRC/testsuiterunner.h \
+           $$SRC/testcatalog.h \
+           $$SRC/referenceresolver.h \
+           $$SRC/benchmark.h \
+           $$SRC/benchmarkrunner.h \
+           $$SRC/stresstester.h \
+           $$SRC/batchgrader.h \
+           $$SRC/projectbuilder.h \
+           $$SRC/forkserver.h \
+           $$SRC/resultstore.h \
+           $$SRC/symbolindex.h \
+           $$SRC/nestingindex.h
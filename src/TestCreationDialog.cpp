@@ -1,18 +1,66 @@
 #include "TestCreationDialog.h"
+#include "testdefinition.h"
+#include "testarchive.h"
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QLabel>
 #include <QLineEdit>
 #include <QTextEdit>
 #include <QPushButton>
-#include <QFile>
-#include <QJsonDocument>
-#include <QJsonObject>
-#include <QJsonArray>
+#include <QSpinBox>
+#include <QFormLayout>
+#include <QComboBox>
+#include <QDoubleValidator>
+#include <QDoubleSpinBox>
+#include <QListWidget>
+#include <QGroupBox>
 #include <QDir>
+#include <QFileInfo>
 #include <QMessageBox>
+#include <QFileDialog>
 #include <QCoreApplication>
 
+namespace {
+
+ResourceLimits overridesOf(const ResourceLimits &limits, const ResourceLimits &shared)
+{
+    ResourceLimits overrides;
+    overrides.timeLimitMs = limits.timeLimitMs != shared.timeLimitMs ? limits.timeLimitMs : -1;
+    overrides.cpuLimitMs = limits.cpuLimitMs != shared.cpuLimitMs ? limits.cpuLimitMs : -1;
+    overrides.memoryLimitMb = limits.memoryLimitMb != shared.memoryLimitMb ? limits.memoryLimitMb : -1;
+    overrides.outputLimitKb = limits.outputLimitKb != shared.outputLimitKb ? limits.outputLimitKb : -1;
+    overrides.processLimit = limits.processLimit != shared.processLimit ? limits.processLimit : -1;
+    return overrides;
+}
+
+
+ResourceLimits resolveOverrides(const ResourceLimits &overrides, const ResourceLimits &shared)
+{
+    ResourceLimits limits = shared;
+    if (overrides.timeLimitMs >= 0)
+        limits.timeLimitMs = overrides.timeLimitMs;
+    if (overrides.cpuLimitMs >= 0)
+        limits.cpuLimitMs = overrides.cpuLimitMs;
+    if (overrides.memoryLimitMb >= 0)
+        limits.memoryLimitMb = overrides.memoryLimitMb;
+    if (overrides.outputLimitKb >= 0)
+        limits.outputLimitKb = overrides.outputLimitKb;
+    if (overrides.processLimit >= 0)
+        limits.processLimit = overrides.processLimit;
+    return limits;
+}
+
+
+TestCase emptyCase()
+{
+    TestCase testCase;
+    testCase.limits = overridesOf(ResourceLimits(), ResourceLimits());
+    return testCase;
+}
+
+}
+
+
 TestCreationDialog::TestCreationDialog(QWidget *parent)
     : QDialog(parent) {
     setWindowTitle("Создание теста");
@@ -21,9 +69,60 @@ TestCreationDialog::TestCreationDialog(QWidget *parent)
     nameEdit = new QLineEdit(this);
     descriptionEdit = new QTextEdit(this);
     forbiddenEdit = new QLineEdit(this);
+    referenceEdit = new QLineEdit(this);
+    referenceEdit->setPlaceholderText("не задано — ожидаемый вывод вводится вручную");
+    referenceEdit->setClearButtonEnabled(true);
     inputEdit = new QTextEdit(this);
     expectedOutputEdit = new QTextEdit(this);
 
+    auto createLimitEdit = [this](int minimum, int maximum, const QString &suffix, const QString &special) {
+        auto *spinBox = new QSpinBox(this);
+        spinBox->setRange(minimum, maximum);
+        spinBox->setSuffix(suffix);
+        spinBox->setSpecialValueText(special);
+        return spinBox;
+    };
+
+    timeLimitEdit = createLimitEdit(1, 600000, " мс", QString());
+    cpuLimitEdit = createLimitEdit(0, 600000, " мс", "без ограничения");
+    memoryLimitEdit = createLimitEdit(0, 65536, " МБ", "без ограничения");
+    outputLimitEdit = createLimitEdit(0, 1048576, " КБ", "без ограничения");
+    processLimitEdit = createLimitEdit(0, 4096, QString(), "без ограничения");
+
+    ResourceLimits defaults;
+    timeLimitEdit->setValue(defaults.timeLimitMs);
+
+    checkerModeEdit = new QComboBox(this);
+    for (OutputChecker::Mode mode : {OutputChecker::Mode::Exact, OutputChecker::Mode::Tokens, OutputChecker::Mode::Float})
+        checkerModeEdit->addItem(OutputChecker::Options::modeName(mode), int(mode));
+
+    OutputChecker::Options checkerDefaults;
+    auto *toleranceValidator = new QDoubleValidator(0.0, 1e9, 15, this);
+    toleranceValidator->setLocale(QLocale::c());
+    absToleranceEdit = new QLineEdit(QString::number(checkerDefaults.absTolerance), this);
+    absToleranceEdit->setValidator(toleranceValidator);
+    relToleranceEdit = new QLineEdit(QString::number(checkerDefaults.relTolerance), this);
+    relToleranceEdit->setValidator(toleranceValidator);
+
+    auto updateToleranceEdits = [this] {
+        bool floatMode = checkerModeEdit->currentData().toInt() == int(OutputChecker::Mode::Float);
+        absToleranceEdit->setEnabled(floatMode);
+        relToleranceEdit->setEnabled(floatMode);
+    };
+    connect(checkerModeEdit, &QComboBox::currentIndexChanged, this, updateToleranceEdits);
+    updateToleranceEdits();
+
+    caseList = new QListWidget(this);
+    caseList->setMaximumWidth(140);
+
+    weightEdit = new QDoubleSpinBox(this);
+    weightEdit->setRange(0.0, 1000.0);
+    weightEdit->setDecimals(2);
+    weightEdit->setValue(1.0);
+
+    caseTimeLimitEdit = createLimitEdit(-1, 600000, " мс", "как у теста");
+    caseMemoryLimitEdit = createLimitEdit(-1, 65536, " МБ", "как у теста");
+
     layout->addWidget(new QLabel("Название теста:"));
     layout->addWidget(nameEdit);
 
@@ -33,11 +132,53 @@ TestCreationDialog::TestCreationDialog(QWidget *parent)
     layout->addWidget(new QLabel("Запрещённые конструкции (через запятую):"));
     layout->addWidget(forbiddenEdit);
 
-    layout->addWidget(new QLabel("Входные данные:"));
-    layout->addWidget(inputEdit);
-
-    layout->addWidget(new QLabel("Ожидаемый вывод:"));
-    layout->addWidget(expectedOutputEdit);
+    auto *referenceLayout = new QHBoxLayout();
+    auto *chooseReferenceButton = new QPushButton("Обзор...", this);
+    referenceLayout->addWidget(referenceEdit);
+    referenceLayout->addWidget(chooseReferenceButton);
+    layout->addWidget(new QLabel("Эталонное решение (ожидаемый вывод вычисляется при запуске):"));
+    layout->addLayout(referenceLayout);
+
+    auto *checkerLayout = new QFormLayout();
+    checkerLayout->addRow("Сравнение вывода:", checkerModeEdit);
+    checkerLayout->addRow("Абсолютная погрешность:", absToleranceEdit);
+    checkerLayout->addRow("Относительная погрешность:", relToleranceEdit);
+    layout->addLayout(checkerLayout);
+
+    auto *limitsLayout = new QFormLayout();
+    limitsLayout->addRow("Реальное время:", timeLimitEdit);
+    limitsLayout->addRow("Процессорное время:", cpuLimitEdit);
+    limitsLayout->addRow("Память:", memoryLimitEdit);
+    limitsLayout->addRow("Объём вывода:", outputLimitEdit);
+    limitsLayout->addRow("Число процессов:", processLimitEdit);
+    layout->addWidget(new QLabel("Ограничения (процессорное время, память, вывод и процессы — только Linux):"));
+    layout->addLayout(limitsLayout);
+
+    auto *casesGroupBox = new QGroupBox("Случаи", this);
+    auto *casesLayout = new QHBoxLayout(casesGroupBox);
+
+    auto *caseListLayout = new QVBoxLayout();
+    auto *addCaseButton = new QPushButton("Добавить", this);
+    auto *removeCaseButton = new QPushButton("Удалить", this);
+    caseListLayout->addWidget(caseList);
+    caseListLayout->addWidget(addCaseButton);
+    caseListLayout->addWidget(removeCaseButton);
+    casesLayout->addLayout(caseListLayout);
+
+    auto *caseLayout = new QVBoxLayout();
+    caseLayout->addWidget(new QLabel("Входные данные:"));
+    caseLayout->addWidget(inputEdit);
+    caseLayout->addWidget(new QLabel("Ожидаемый вывод:"));
+    caseLayout->addWidget(expectedOutputEdit);
+
+    auto *caseFormLayout = new QFormLayout();
+    caseFormLayout->addRow("Вес:", weightEdit);
+    caseFormLayout->addRow("Реальное время:", caseTimeLimitEdit);
+    caseFormLayout->addRow("Память:", caseMemoryLimitEdit);
+    caseLayout->addLayout(caseFormLayout);
+    casesLayout->addLayout(caseLayout);
+
+    layout->addWidget(casesGroupBox);
 
     auto *buttonLayout = new QHBoxLayout();
 
@@ -51,6 +192,13 @@ TestCreationDialog::TestCreationDialog(QWidget *parent)
 
     connect(saveButton, &QPushButton::clicked, this, &TestCreationDialog::saveTest);
     connect(cancelButton, &QPushButton::clicked, this, &TestCreationDialog::reject);
+    connect(addCaseButton, &QPushButton::clicked, this, &TestCreationDialog::addCase);
+    connect(removeCaseButton, &QPushButton::clicked, this, &TestCreationDialog::removeCase);
+    connect(caseList, &QListWidget::currentRowChanged, this, &TestCreationDialog::selectCase);
+    connect(chooseReferenceButton, &QPushButton::clicked, this, &TestCreationDialog::chooseReference);
+    connect(referenceEdit, &QLineEdit::textChanged, this, &TestCreationDialog::updateExpectedEdit);
+
+    addCase();
 }
 
 
@@ -59,42 +207,158 @@ TestCreationDialog::TestCreationDialog(const QString &filePath, QWidget *parent)
     loadTest(filePath);
 }
 
+
+TestCreationDialog::TestCreationDialog(const TestDefinition &test, QWidget *parent)
+    : TestCreationDialog(parent) {
+    showTest(test);
+}
+
 void TestCreationDialog::loadTest(const QString &filePath) {
-    QFile file(filePath);
-    if (!file.open(QIODevice::ReadOnly)) {
-        QMessageBox::critical(this, "Ошибка", "Не удалось открыть файл теста.");
+    TestDefinition test;
+    QString error;
+    if (!TestDefinition::load(filePath, &test, &error)) {
+        QMessageBox::critical(this, "Ошибка", error);
         reject();
         return;
     }
 
-    QJsonDocument doc = QJsonDocument::fromJson(file.readAll());
-    file.close();
+    showTest(test);
+}
 
-    if (!doc.isObject()) {
-        QMessageBox::critical(this, "Ошибка", "Неверный формат файла теста.");
-        reject();
-        return;
-    }
 
-    QJsonObject obj = doc.object();
+void TestCreationDialog::showTest(const TestDefinition &test) {
+    // Изменённый тест сохраняется в свой же файл, даже если тот назван не
+    // по имени теста (например, stress-<seed>.json). Тесты из архива сюда
+    // не попадают: архив так не перезаписать.
+    if (!TestArchive::isArchive(test.filePath))
+        existingPath = test.filePath;
+    nameEdit->setText(test.name);
+    descriptionEdit->setText(test.description);
+    forbiddenEdit->setText(test.forbidden.join(", "));
+    referenceEdit->setText(test.reference);
+
+    timeLimitEdit->setValue(test.limits.timeLimitMs);
+    cpuLimitEdit->setValue(test.limits.cpuLimitMs);
+    memoryLimitEdit->setValue(test.limits.memoryLimitMb);
+    outputLimitEdit->setValue(test.limits.outputLimitKb);
+    processLimitEdit->setValue(test.limits.processLimit);
+
+    checkerModeEdit->setCurrentIndex(checkerModeEdit->findData(int(test.checker.mode)));
+    absToleranceEdit->setText(QString::number(test.checker.absTolerance));
+    relToleranceEdit->setText(QString::number(test.checker.relTolerance));
+
+    currentCase = -1;
+    cases.clear();
+    caseList->clear();
+    for (TestCase testCase : std::as_const(test.cases)) {
+        testCase.limits = overridesOf(testCase.limits, test.limits);
+        cases.append(testCase);
+        caseList->addItem(QString());
+    }
+    if (cases.isEmpty()) {
+        cases.append(emptyCase());
+        caseList->addItem(QString());
+    }
+    renumberCases();
+    caseList->setCurrentRow(0);
+}
 
-    QString testName = obj.value("name").toString();
-    QString description = obj.value("description").toString();
-    QJsonArray forbiddenArray = obj.value("forbidden").toArray();
-    QString input = obj.value("input").toString();
-    QString expected = obj.value("expected").toString();
 
-    nameEdit->setText(testName);
-    descriptionEdit->setText(description);
+void TestCreationDialog::addCase() {
+    storeCurrentCase();
 
-    QStringList forbiddenList;
-    for (const QJsonValue &val : forbiddenArray) {
-        forbiddenList << val.toString();
+    TestCase testCase = emptyCase();
+    if (currentCase >= 0) {
+        testCase.limits = cases.at(currentCase).limits;
+        testCase.weight = cases.at(currentCase).weight;
     }
-    forbiddenEdit->setText(forbiddenList.join(", "));
 
-    inputEdit->setText(input);
-    expectedOutputEdit->setText(expected);
+    cases.append(testCase);
+    caseList->addItem(QString());
+    renumberCases();
+    caseList->setCurrentRow(cases.size() - 1);
+}
+
+
+void TestCreationDialog::removeCase() {
+    if (cases.size() <= 1 || currentCase < 0)
+        return;
+
+    int removed = currentCase;
+    currentCase = -1;
+    cases.removeAt(removed);
+    delete caseList->takeItem(removed);
+    renumberCases();
+
+    caseList->setCurrentRow(qMin(removed, cases.size() - 1));
+}
+
+
+void TestCreationDialog::selectCase(int row) {
+    storeCurrentCase();
+    currentCase = row;
+    if (row >= 0)
+        showCase(row);
+}
+
+
+void TestCreationDialog::storeCurrentCase() {
+    if (currentCase < 0 || currentCase >= cases.size())
+        return;
+
+    TestCase &testCase = cases[currentCase];
+    testCase.input = inputEdit->toPlainText().toUtf8();
+    testCase.expected = expectedOutputEdit->toPlainText().toUtf8();
+    testCase.weight = weightEdit->value();
+    testCase.limits.timeLimitMs = caseTimeLimitEdit->value();
+    testCase.limits.memoryLimitMb = caseMemoryLimitEdit->value();
+}
+
+
+void TestCreationDialog::showCase(int index) {
+    const TestCase &testCase = cases.at(index);
+    inputEdit->setPlainText(QString::fromUtf8(testCase.input));
+    expectedOutputEdit->setPlainText(QString::fromUtf8(testCase.expected));
+    weightEdit->setValue(testCase.weight);
+    caseTimeLimitEdit->setValue(testCase.limits.timeLimitMs);
+    caseMemoryLimitEdit->setValue(testCase.limits.memoryLimitMb);
+}
+
+
+void TestCreationDialog::chooseReference() {
+    QString testsDir = QCoreApplication::applicationDirPath() + "/tests";
+    QString path = QFileDialog::getOpenFileName(this, "Эталонное решение", testsDir, "C++ Files (*.cpp *.cc *.cxx)");
+    if (path.isEmpty())
+        return;
+
+    // Эталон внутри каталога тестов хранится относительным путём, чтобы
+    // каталог можно было переносить целиком.
+    QString relative = QDir(testsDir).relativeFilePath(path);
+    referenceEdit->setText(relative.startsWith("..") ? QDir::toNativeSeparators(path) : relative);
+}
+
+
+void TestCreationDialog::updateExpectedEdit() {
+    bool fromReference = !referenceEdit->text().trimmed().isEmpty();
+    expectedOutputEdit->setReadOnly(fromReference);
+    expectedOutputEdit->setPlaceholderText(fromReference ? "Вычисляется эталонным решением" : QString());
+}
+
+
+void TestCreationDialog::renumberCases() {
+    for (int i = 0; i < caseList->count(); ++i)
+        caseList->item(i)->setText(QString("Случай %1").arg(i + 1));
+}
+
+
+ResourceLimits TestCreationDialog::sharedLimits() const {
+    ResourceLimits limits;
+    limits.timeLimitMs = timeLimitEdit->value();
+    limits.cpuLimitMs = cpuLimitEdit->value();
+    limits.memoryLimitMb = memoryLimitEdit->value();
+    limits.outputLimitKb = outputLimitEdit->value();
+    limits.processLimit = processLimitEdit->value();
+    return limits;
 }
 
 
@@ -105,43 +369,49 @@ void TestCreationDialog::saveTest() {
         return;
     }
 
-    QString description = descriptionEdit->toPlainText();
-    QString forbiddenText = forbiddenEdit->text();
-    QStringList forbiddenList = forbiddenText.split(",", Qt::SkipEmptyParts);
+    storeCurrentCase();
+
+    TestDefinition test;
+    test.name = name;
+    test.description = descriptionEdit->toPlainText();
+    test.reference = referenceEdit->text().trimmed();
 
+    QStringList forbiddenList = forbiddenEdit->text().split(",", Qt::SkipEmptyParts);
     for (QString &item : forbiddenList)
         item = item.trimmed();
-
-    QString input = inputEdit->toPlainText();
-    QString expected = expectedOutputEdit->toPlainText();
-
-    QJsonObject obj;
-    obj["name"] = name;
-    obj["description"] = description;
-
-    QJsonArray forbiddenArray;
-    for (const QString &s : forbiddenList)
-        forbiddenArray.append(s);
-
-    obj["forbidden"] = forbiddenArray;
-    obj["input"] = input;
-    obj["expected"] = expected;
-
-    QJsonDocument doc(obj);
+    test.forbidden = forbiddenList;
+
+    test.limits = sharedLimits();
+
+    test.checker.mode = OutputChecker::Mode(checkerModeEdit->currentData().toInt());
+    bool ok = false;
+    double absTolerance = absToleranceEdit->text().toDouble(&ok);
+    if (ok)
+        test.checker.absTolerance = absTolerance;
+    double relTolerance = relToleranceEdit->text().toDouble(&ok);
+    if (ok)
+        test.checker.relTolerance = relTolerance;
+
+    for (TestCase testCase : std::as_const(cases)) {
+        testCase.limits = resolveOverrides(testCase.limits, test.limits);
+        test.cases.append(testCase);
+    }
 
     QDir dir(QCoreApplication::applicationDirPath() + "/tests");
     if (!dir.exists())
         dir.mkpath(".");
 
-    QString filePath = dir.filePath(name + ".json");
-    QFile file(filePath);
-    if (!file.open(QIODevice::WriteOnly)) {
-        QMessageBox::critical(this, "Ошибка", "Не удалось записать файл теста.");
+    test.filePath = existingPath.isEmpty() ? dir.filePath(name + ".json") : existingPath;
+    if (!test.reference.isEmpty() && !QFileInfo::exists(test.referencePath())) {
+        QMessageBox::warning(this, "Ошибка валидации", "Файл эталонного решения не найден.");
         return;
     }
 
-    file.write(doc.toJson(QJsonDocument::Indented));
-    file.close();
+    QString error;
+    if (!test.save(test.filePath, &error)) {
+        QMessageBox::critical(this, "Ошибка", error);
+        return;
+    }
 
     QMessageBox::information(this, "Сохранено", "Тест успешно сохранён.");
     accept();
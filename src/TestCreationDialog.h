@@ -2,9 +2,15 @@
 #define TESTCREATIONDIALOG_H
 
 #include <QDialog>
+#include <QList>
+#include "testdefinition.h"
 
 class QLineEdit;
 class QTextEdit;
+class QSpinBox;
+class QDoubleSpinBox;
+class QComboBox;
+class QListWidget;
 
 class TestCreationDialog : public QDialog
 {
@@ -13,18 +19,49 @@ class TestCreationDialog : public QDialog
 public:
     explicit TestCreationDialog(QWidget *parent = nullptr);
     explicit TestCreationDialog(const QString &filePath, QWidget *parent = nullptr);
+    explicit TestCreationDialog(const TestDefinition &test, QWidget *parent = nullptr);
 
 private slots:
     void saveTest();
+    void addCase();
+    void removeCase();
+    void selectCase(int row);
+    void chooseReference();
+    void updateExpectedEdit();
 
 private:
     void loadTest(const QString &filePath);
+    void showTest(const TestDefinition &test);
+    void storeCurrentCase();
+    void showCase(int index);
+    void renumberCases();
+    ResourceLimits sharedLimits() const;
 
     QLineEdit *nameEdit;
     QTextEdit *descriptionEdit;
     QLineEdit *forbiddenEdit;
+    QLineEdit *referenceEdit;
     QTextEdit *inputEdit;
     QTextEdit *expectedOutputEdit;
+    QSpinBox *timeLimitEdit;
+    QSpinBox *cpuLimitEdit;
+    QSpinBox *memoryLimitEdit;
+    QSpinBox *outputLimitEdit;
+    QSpinBox *processLimitEdit;
+    QComboBox *checkerModeEdit;
+    QLineEdit *absToleranceEdit;
+    QLineEdit *relToleranceEdit;
+    QListWidget *caseList;
+    QDoubleSpinBox *weightEdit;
+    QSpinBox *caseTimeLimitEdit;
+    QSpinBox *caseMemoryLimitEdit;
+
+    // Ограничения случаев хранятся как переопределения: -1 — «как у теста».
+    QList<TestCase> cases;
+    int currentCase = -1;
+
+    // Файл редактируемого теста; пусто для нового теста.
+    QString existingPath;
 };
 
 #endif // TESTCREATIONDIALOG_H
@@ -0,0 +1,415 @@
+#include "batchgrader.h"
+#include "compilejob.h"
+#include "testcatalog.h"
+#include "testsuiterunner.h"
+#include "referenceresolver.h"
+#include "forkserver.h"
+#include "resultstore.h"
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <algorithm>
+
+namespace {
+
+const QStringList SourcePatterns = {"*.cpp", "*.cc", "*.cxx"};
+
+QString csvField(const QString &text)
+{
+    if (!text.contains(',') && !text.contains('"') && !text.contains('\n'))
+        return text;
+    QString escaped = text;
+    escaped.replace("\"", "\"\"");
+    return "\"" + escaped + "\"";
+}
+
+}
+
+
+BatchGrader::BatchGrader(const Options &options, QObject *parent)
+    : QObject(parent),
+      options(options),
+      compileCache(QCoreApplication::applicationDirPath() + "/cache"),
+      log(stderr)
+{
+    if (!options.resultsDir.isEmpty()) {
+        resultStore = new ResultStore(options.resultsDir, this);
+        if (!resultStore->ownsDirectory()) {
+            // Одновременная запись двух процессов перепутала бы номера в
+            // словаре истории.
+            log << "История запусков " << options.resultsDir << " открыта другим процессом; запуски не "
+                << "записываются. Укажите другой каталог в --results или --no-results." << Qt::endl;
+            delete resultStore;
+            resultStore = nullptr;
+            return;
+        }
+        connect(resultStore, &ResultStore::errorOccurred, this, [this](const QString &message) {
+            log << message << Qt::endl;
+        });
+    }
+}
+
+
+void BatchGrader::start()
+{
+    const QList<TestCatalog::Entry> entries = TestCatalog::loadDirectory(options.testsDir);
+    for (const TestCatalog::Entry &entry : entries) {
+        if (!entry.isValid()) {
+            log << entry.fileName << ": " << entry.error << Qt::endl;
+            continue;
+        }
+        tests.append(entry.test);
+        maxScore += entry.test.totalWeight();
+    }
+    if (tests.isEmpty()) {
+        log << "В каталоге " << options.testsDir << " нет тестов." << Qt::endl;
+        emit finished(1);
+        return;
+    }
+
+    submissions = findSubmissions();
+    if (submissions.isEmpty()) {
+        log << "В каталоге " << options.submissionsDir << " нет решений." << Qt::endl;
+        emit finished(1);
+        return;
+    }
+
+    if (!buildDir.isValid()) {
+        log << "Не удалось создать временный каталог: " << buildDir.errorString() << Qt::endl;
+        emit finished(1);
+        return;
+    }
+
+    log << "Решений: " << submissions.size() << ", тестов: " << tests.size()
+        << ", процессов одновременно: " << options.jobs << Qt::endl;
+    log << "Профиль " << options.profile.summary() << Qt::endl;
+    QString forkServerReason;
+    if (options.forkServer && !ForkServer::canServe(options.profile, &forkServerReason)) {
+        log << forkServerReason << Qt::endl;
+        options.forkServer = false;
+    }
+
+    if (!ReferenceResolver::isNeeded(tests)) {
+        startNext();
+        return;
+    }
+
+    // Ожидаемые выводы эталонов нужны всем решениям, поэтому вычисляются
+    // один раз до первой компиляции.
+    auto *resolver = new ReferenceResolver(tests, options.profile, this);
+    resolver->setCompileCache(&compileCache);
+    resolver->setMaxParallel(options.jobs);
+    connect(resolver, &ReferenceResolver::message, this, [this](const QString &text) {
+        log << text.trimmed() << Qt::endl;
+    });
+    connect(resolver, &ReferenceResolver::finished, this, [this, resolver](bool ok) {
+        resolver->deleteLater();
+        if (!ok) {
+            log << resolver->errorMessage() << Qt::endl;
+            emit finished(1);
+            return;
+        }
+
+        log << "Выводы эталонов: из кэша " << resolver->cachedCount() << ", вычислено "
+            << resolver->computedCount() << Qt::endl;
+        tests = resolver->tests();
+        startNext();
+    });
+    resolver->start();
+}
+
+
+QList<BatchGrader::Submission> BatchGrader::findSubmissions()
+{
+    // Решение — либо отдельный исходник, либо каталог студента с main.cpp
+    // или единственным исходником.
+    QList<Submission> found;
+    QDir dir(options.submissionsDir);
+    const QFileInfoList infos = dir.entryInfoList(QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name);
+
+    for (const QFileInfo &info : infos) {
+        Submission submission;
+        if (info.isFile()) {
+            if (!QDir::match(SourcePatterns, info.fileName()))
+                continue;
+            submission.name = info.completeBaseName();
+            submission.source = info.filePath();
+        } else {
+            QDir studentDir(info.filePath());
+            const QStringList sources = studentDir.entryList(SourcePatterns, QDir::Files, QDir::Name);
+            if (sources.contains("main.cpp")) {
+                submission.source = studentDir.filePath("main.cpp");
+            } else if (sources.size() == 1) {
+                submission.source = studentDir.filePath(sources.first());
+            } else {
+                log << info.fileName() << ": пропущено, не найден main.cpp или единственный исходник." << Qt::endl;
+                continue;
+            }
+            submission.name = info.fileName();
+        }
+        found.append(submission);
+    }
+
+    return found;
+}
+
+
+void BatchGrader::startNext()
+{
+    while (activeCount < options.jobs && nextIndex < submissions.size()) {
+        int index = nextIndex++;
+        ++activeCount;
+
+#ifdef Q_OS_WIN
+        QString executable = buildDir.filePath(QString("s%1.exe").arg(index));
+#else
+        QString executable = buildDir.filePath(QString("s%1").arg(index));
+#endif
+
+        auto *job = new CompileJob(submissions.at(index).source, executable, this);
+        job->setCompiler(options.profile.compiler);
+        job->setFlags(options.profile.compileFlags());
+        job->setCache(&compileCache);
+
+        connect(job, &CompileJob::finished, this, [this, job, index, executable](CompileJob::Status status) {
+            Submission &submission = submissions[index];
+            submission.compileMs = job->elapsedMs();
+            submission.compileLog = job->errorOutput();
+            submission.compiled = status == CompileJob::Status::Succeeded;
+            job->deleteLater();
+
+            if (submission.compiled)
+                runTests(index, executable);
+            else
+                submissionFinished(index);
+        });
+
+        job->start();
+    }
+}
+
+
+void BatchGrader::runTests(int index, const QString &executable)
+{
+    Submission &submission = submissions[index];
+
+    QByteArray sourceBytes;
+    QFile sourceFile(submission.source);
+    if (sourceFile.open(QIODevice::ReadOnly))
+        sourceBytes = sourceFile.readAll();
+    QString code = QString::fromUtf8(sourceBytes);
+    QByteArray sourceHash = ResultStore::hashSource(sourceBytes);
+
+    QList<TestDefinition> runnable;
+    QList<int> runnableIndexes;
+    for (int testIndex = 0; testIndex < tests.size(); ++testIndex) {
+        const TestDefinition &test = tests.at(testIndex);
+        const QList<ForbiddenScanner::Violation> violations = test.findForbidden(code);
+        if (violations.isEmpty()) {
+            runnable.append(test);
+            runnableIndexes.append(testIndex);
+            continue;
+        }
+
+        for (int caseIndex = 0; caseIndex < test.cases.size(); ++caseIndex) {
+            TestResult result;
+            result.verdict = TestResult::Verdict::Forbidden;
+            result.caseIndex = caseIndex;
+            result.details = "Код содержит запрещённый элемент " + ForbiddenScanner::describe(violations.first());
+            submission.cases.append({testIndex, result});
+            if (resultStore)
+                resultStore->record(sourceHash, submission.source, options.profile.name, test.name, result);
+        }
+    }
+
+    auto *runner = new TestSuiteRunner(executable, runnable, this);
+    runners.append(runner);
+    rebalance();
+    runner->setAddressSpaceLimit(!options.profile.usesAddressSanitizer());
+    if (options.forkServer)
+        runner->setForkServer(options.profile.compiler);
+    connect(runner, &TestSuiteRunner::message, this, [this](const QString &text) {
+        log << text;
+        log.flush();
+    });
+
+    connect(runner, &TestSuiteRunner::caseFinished, this,
+            [this, index, runnableIndexes, sourceHash](int testIndex, const TestDefinition &test,
+                                                       const TestResult &result) {
+        Submission &submission = submissions[index];
+        submission.cases.append({runnableIndexes.at(testIndex), result});
+        if (resultStore)
+            resultStore->record(sourceHash, submission.source, options.profile.name, test.name, result);
+        if (result.passed())
+            submission.score += test.cases.at(result.caseIndex).weight;
+    });
+
+    connect(runner, &TestSuiteRunner::allFinished, this, [this, runner, index, executable] {
+        runners.removeOne(runner);
+        runner->deleteLater();
+        QFile::remove(executable);
+        submissionFinished(index);
+    });
+
+    runner->start();
+}
+
+
+void BatchGrader::submissionFinished(int index)
+{
+    Submission &submission = submissions[index];
+    std::sort(submission.cases.begin(), submission.cases.end(), [](const CaseRecord &a, const CaseRecord &b) {
+        if (a.testIndex != b.testIndex)
+            return a.testIndex < b.testIndex;
+        return a.result.caseIndex < b.result.caseIndex;
+    });
+
+    --activeCount;
+    ++doneCount;
+
+    log << "[" << doneCount << "/" << submissions.size() << "] " << submission.name << ": ";
+    if (submission.compiled)
+        log << "баллы " << submission.score << " из " << maxScore << Qt::endl;
+    else
+        log << "ошибка компиляции" << Qt::endl;
+
+    startNext();
+    rebalance();
+    if (activeCount == 0 && nextIndex >= submissions.size())
+        finishAll();
+}
+
+
+void BatchGrader::rebalance()
+{
+    if (runners.isEmpty())
+        return;
+
+    // Пока очередь решений не исчерпана, каждому прогону достаётся один
+    // процесс. На хвосте места, не занятые компиляцией, делятся между
+    // оставшимися прогонами и перераспределяются после каждого решения.
+    int count = int(runners.size());
+    int slots = count;
+    if (nextIndex >= submissions.size())
+        slots = qMax(count, options.jobs - (activeCount - count));
+
+    for (int i = 0; i < count; ++i)
+        runners.at(i)->setMaxParallel(slots / count + (i < slots % count ? 1 : 0));
+}
+
+
+void BatchGrader::finishAll()
+{
+    QString error;
+    if (!writeReport(&error)) {
+        log << error << Qt::endl;
+        emit finished(1);
+        return;
+    }
+
+    log << "Отчёт записан в " << options.reportPath << Qt::endl;
+    emit finished(0);
+}
+
+
+bool BatchGrader::writeReport(QString *error) const
+{
+    QSaveFile file(options.reportPath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        *error = "Не удалось открыть " + options.reportPath + ": " + file.errorString();
+        return false;
+    }
+
+    file.write(options.format == ReportFormat::Csv ? csvReport() : jsonReport());
+    if (!file.commit()) {
+        *error = "Не удалось записать " + options.reportPath + ": " + file.errorString();
+        return false;
+    }
+    return true;
+}
+
+
+QByteArray BatchGrader::jsonReport() const
+{
+    QJsonArray testsArray;
+    for (const TestDefinition &test : tests)
+        testsArray.append(test.name);
+
+    QJsonArray submissionsArray;
+    for (const Submission &submission : submissions) {
+        QJsonObject submissionObj;
+        submissionObj["name"] = submission.name;
+        submissionObj["source"] = submission.source;
+        submissionObj["compiled"] = submission.compiled;
+        submissionObj["compileMs"] = submission.compileMs;
+        if (!submission.compiled)
+            submissionObj["compileLog"] = submission.compileLog;
+        submissionObj["score"] = submission.score;
+
+        QJsonArray resultsArray;
+        for (const CaseRecord &record : submission.cases) {
+            const TestResult &result = record.result;
+            QJsonObject resultObj;
+            resultObj["test"] = tests.at(record.testIndex).name;
+            resultObj["case"] = result.caseIndex + 1;
+            resultObj["verdict"] = TestResult::verdictCode(result.verdict);
+            resultObj["wallMs"] = result.wallMs;
+            if (result.usage.valid) {
+                resultObj["cpuMs"] = result.usage.cpuMs();
+                resultObj["memoryKb"] = result.usage.peakRssKb;
+            }
+            resultObj["exitCode"] = result.exitCode;
+            if (!result.details.isEmpty())
+                resultObj["details"] = result.details;
+            resultsArray.append(resultObj);
+        }
+        submissionObj["results"] = resultsArray;
+        submissionsArray.append(submissionObj);
+    }
+
+    QJsonObject profileObj = options.profile.toJson();
+    profileObj["commandLine"] = options.profile.summary();
+
+    QJsonObject root;
+    root["profile"] = profileObj;
+    root["tests"] = testsArray;
+    root["maxScore"] = maxScore;
+    root["submissions"] = submissionsArray;
+    return QJsonDocument(root).toJson();
+}
+
+
+QByteArray BatchGrader::csvReport() const
+{
+    QString profile = csvField(options.profile.name);
+    QString text = "profile,submission,test,case,verdict,wall_ms,cpu_ms,memory_kb,exit_code,points\n";
+    for (const Submission &submission : submissions) {
+        if (!submission.compiled) {
+            text += profile + "," + csvField(submission.name) + ",,,CE,,,,,0\n";
+            continue;
+        }
+
+        for (const CaseRecord &record : submission.cases) {
+            const TestDefinition &test = tests.at(record.testIndex);
+            const TestResult &result = record.result;
+            QStringList fields;
+            fields << profile
+                   << csvField(submission.name)
+                   << csvField(test.name)
+                   << QString::number(result.caseIndex + 1)
+                   << TestResult::verdictCode(result.verdict)
+                   << QString::number(result.wallMs)
+                   << (result.usage.valid ? QString::number(result.usage.cpuMs()) : QString())
+                   << (result.usage.valid ? QString::number(result.usage.peakRssKb) : QString())
+                   << QString::number(result.exitCode)
+                   << QString::number(result.passed() ? test.cases.at(result.caseIndex).weight : 0);
+            text += fields.join(',') + "\n";
+        }
+    }
+    return text.toUtf8();
+}
@@ -0,0 +1,89 @@
+#ifndef BATCHGRADER_H
+#define BATCHGRADER_H
+
+#include <QObject>
+#include <QList>
+#include <QStringList>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include "compilecache.h"
+#include "testrunner.h"
+#include "buildprofile.h"
+
+class CompileJob;
+class ResultStore;
+class TestSuiteRunner;
+
+// Пакетная проверка без интерфейса: каждое решение из каталога компилируется
+// и прогоняется на всех тестах, одновременно работает не больше jobs
+// процессов. Итог записывается в JSON или CSV.
+class BatchGrader : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum class ReportFormat { Json, Csv };
+
+    struct Options
+    {
+        QString submissionsDir;
+        QString testsDir;
+        QString reportPath;
+        ReportFormat format = ReportFormat::Json;
+        int jobs = 1;
+        BuildProfile profile;
+        bool forkServer = false;
+        QString resultsDir; // история запусков, пусто — не записывать
+    };
+
+    explicit BatchGrader(const Options &options, QObject *parent = nullptr);
+
+public slots:
+    void start();
+
+signals:
+    void finished(int exitCode);
+
+private:
+    struct CaseRecord
+    {
+        int testIndex;
+        TestResult result;
+    };
+
+    struct Submission
+    {
+        QString name;
+        QString source;
+        bool compiled = false;
+        qint64 compileMs = 0;
+        QString compileLog;
+        double score = 0;
+        QList<CaseRecord> cases;
+    };
+
+    QList<Submission> findSubmissions();
+    void startNext();
+    void runTests(int index, const QString &executable);
+    void submissionFinished(int index);
+    void rebalance();
+    bool writeReport(QString *error) const;
+    QByteArray jsonReport() const;
+    QByteArray csvReport() const;
+    void finishAll();
+
+    Options options;
+    QList<TestDefinition> tests;
+    double maxScore = 0;
+    QList<Submission> submissions;
+    QTemporaryDir buildDir;
+    CompileCache compileCache;
+    QTextStream log;
+    int nextIndex = 0;
+    int activeCount = 0;
+    int doneCount = 0;
+    ResultStore *resultStore = nullptr;
+    QList<TestSuiteRunner *> runners;
+};
+
+#endif // BATCHGRADER_H
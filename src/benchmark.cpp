@@ -0,0 +1,166 @@
+#include "benchmark.h"
+#include <QCoreApplication>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QSaveFile>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+QJsonArray toJsonArray(const QList<double> &samples)
+{
+    QJsonArray array;
+    for (double sample : samples)
+        array.append(sample);
+    return array;
+}
+
+
+QList<double> toSamples(const QJsonValue &value)
+{
+    QList<double> samples;
+    const QJsonArray array = value.toArray();
+    for (const QJsonValue &item : array)
+        samples.append(item.toDouble());
+    return samples;
+}
+
+}
+
+
+BenchmarkStats BenchmarkStats::compute(QList<double> samples)
+{
+    BenchmarkStats stats;
+    stats.count = samples.size();
+    if (samples.isEmpty())
+        return stats;
+
+    std::sort(samples.begin(), samples.end());
+    int n = samples.size();
+    stats.min = samples.first();
+    stats.median = n % 2 ? samples.at(n / 2) : (samples.at(n / 2 - 1) + samples.at(n / 2)) / 2;
+    stats.p95 = samples.at(qBound(0, int(std::ceil(0.95 * n)) - 1, n - 1));
+
+    double sum = 0;
+    for (double sample : samples)
+        sum += sample;
+    stats.mean = sum / n;
+
+    if (n > 1) {
+        double squares = 0;
+        for (double sample : samples)
+            squares += (sample - stats.mean) * (sample - stats.mean);
+        stats.stddev = std::sqrt(squares / (n - 1));
+    }
+    return stats;
+}
+
+
+bool BenchmarkResult::load(const QString &filePath, BenchmarkResult *result, QString *error)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (error)
+            *error = "Не удалось открыть файл замеров " + filePath + ".";
+        return false;
+    }
+
+    QJsonParseError parseError;
+    QJsonDocument doc = QJsonDocument::fromJson(file.readAll(), &parseError);
+    if (parseError.error != QJsonParseError::NoError || !doc.isObject()) {
+        if (error)
+            *error = "Неверный формат файла замеров " + filePath + ".";
+        return false;
+    }
+
+    *result = fromJson(doc.object());
+    return true;
+}
+
+
+BenchmarkResult BenchmarkResult::fromJson(const QJsonObject &obj)
+{
+    BenchmarkResult result;
+    result.label = obj.value("label").toString();
+    result.testName = obj.value("test").toString();
+    result.sourceHash = obj.value("sourceHash").toString();
+    result.profile = BuildProfile::fromJson(obj.value("profile").toObject());
+    result.timestamp = QDateTime::fromString(obj.value("timestamp").toString(), Qt::ISODate);
+    result.warmupRuns = obj.value("warmupRuns").toInt();
+    result.runs = obj.value("runs").toInt();
+    result.pinnedCpu = obj.value("pinnedCpu").toInt(-1);
+
+    const QJsonArray casesArray = obj.value("cases").toArray();
+    for (const QJsonValue &value : casesArray) {
+        QJsonObject caseObj = value.toObject();
+        BenchmarkCase benchmarkCase;
+        benchmarkCase.caseIndex = caseObj.value("case").toInt();
+        benchmarkCase.failure = caseObj.value("failure").toString();
+        benchmarkCase.wallMs = toSamples(caseObj.value("wallMs"));
+        benchmarkCase.cpuMs = toSamples(caseObj.value("cpuMs"));
+        benchmarkCase.peakRssKb = toSamples(caseObj.value("peakRssKb"));
+        result.cases.append(benchmarkCase);
+    }
+    return result;
+}
+
+
+QJsonObject BenchmarkResult::toJson() const
+{
+    QJsonObject obj;
+    obj["label"] = label;
+    obj["test"] = testName;
+    obj["sourceHash"] = sourceHash;
+    obj["profile"] = profile.toJson();
+    obj["timestamp"] = timestamp.toString(Qt::ISODate);
+    obj["warmupRuns"] = warmupRuns;
+    obj["runs"] = runs;
+    obj["pinnedCpu"] = pinnedCpu;
+
+    QJsonArray casesArray;
+    for (const BenchmarkCase &benchmarkCase : cases) {
+        QJsonObject caseObj;
+        caseObj["case"] = benchmarkCase.caseIndex;
+        if (!benchmarkCase.failure.isEmpty())
+            caseObj["failure"] = benchmarkCase.failure;
+        caseObj["wallMs"] = toJsonArray(benchmarkCase.wallMs);
+        caseObj["cpuMs"] = toJsonArray(benchmarkCase.cpuMs);
+        caseObj["peakRssKb"] = toJsonArray(benchmarkCase.peakRssKb);
+        casesArray.append(caseObj);
+    }
+    obj["cases"] = casesArray;
+    return obj;
+}
+
+
+bool BenchmarkResult::save(const QString &filePath, QString *error) const
+{
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        if (error)
+            *error = "Не удалось записать файл замеров " + filePath + ".";
+        return false;
+    }
+    file.write(QJsonDocument(toJson()).toJson(QJsonDocument::Indented));
+    if (!file.commit()) {
+        if (error)
+            *error = "Не удалось записать файл замеров " + filePath + ".";
+        return false;
+    }
+    return true;
+}
+
+
+QString BenchmarkResult::title() const
+{
+    QString text = label.isEmpty() ? testName : label + " — " + testName;
+    return text + " (" + timestamp.toString("dd.MM.yyyy HH:mm") + ", " + profile.name + ")";
+}
+
+
+QString BenchmarkResult::defaultDirectory()
+{
+    return QCoreApplication::applicationDirPath() + "/benchmarks";
+}
@@ -0,0 +1,62 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <QDateTime>
+#include <QJsonObject>
+#include <QList>
+#include <QString>
+#include "buildprofile.h"
+
+// Сводка по выборке замеров. p95 берётся по методу ближайшего ранга,
+// stddev — выборочное (делитель n - 1).
+struct BenchmarkStats
+{
+    int count = 0;
+    double min = 0;
+    double median = 0;
+    double p95 = 0;
+    double mean = 0;
+    double stddev = 0;
+
+    static BenchmarkStats compute(QList<double> samples);
+};
+
+// Замеры одного случая теста. Если хотя бы один запуск не прошёл, замеры
+// случая прекращаются, а причина записывается в failure.
+struct BenchmarkCase
+{
+    int caseIndex = 0;
+    QString failure;
+    QList<double> wallMs;
+    QList<double> cpuMs;
+    QList<double> peakRssKb;
+
+    BenchmarkStats wallStats() const { return BenchmarkStats::compute(wallMs); }
+    BenchmarkStats cpuStats() const { return BenchmarkStats::compute(cpuMs); }
+    BenchmarkStats memoryStats() const { return BenchmarkStats::compute(peakRssKb); }
+};
+
+// Результат бенчмарка; сохраняется в JSON вместе с сырыми замерами, чтобы
+// две версии решения можно было сравнить позже.
+struct BenchmarkResult
+{
+    QString label;
+    QString testName;
+    QString sourceHash;
+    BuildProfile profile;
+    QDateTime timestamp;
+    int warmupRuns = 0;
+    int runs = 0;
+    int pinnedCpu = -1;
+    QList<BenchmarkCase> cases;
+
+    static bool load(const QString &filePath, BenchmarkResult *result, QString *error = nullptr);
+    static BenchmarkResult fromJson(const QJsonObject &obj);
+    QJsonObject toJson() const;
+    bool save(const QString &filePath, QString *error = nullptr) const;
+
+    QString title() const;
+    static QString defaultDirectory();
+};
+
+#endif // BENCHMARK_H
@@ -0,0 +1,307 @@
+#include "benchmarkdialog.h"
+#include <QDir>
+#include <QFileDialog>
+#include <QFormLayout>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QLineEdit>
+#include <QMessageBox>
+#include <QProgressBar>
+#include <QPushButton>
+#include <QSpinBox>
+#include <QTableWidget>
+#include <QThread>
+#include <QVBoxLayout>
+
+namespace {
+
+QTableWidgetItem *numberItem(const QString &text)
+{
+    auto *item = new QTableWidgetItem(text);
+    item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+    return item;
+}
+
+
+const BenchmarkCase *findCase(const BenchmarkResult &result, int caseIndex)
+{
+    for (const BenchmarkCase &benchmarkCase : result.cases) {
+        if (benchmarkCase.caseIndex == caseIndex)
+            return &benchmarkCase;
+    }
+    return nullptr;
+}
+
+}
+
+
+BenchmarkDialog::BenchmarkDialog(QWidget *parent)
+    : QDialog(parent)
+{
+    setWindowTitle("Бенчмарк");
+    resize(900, 500);
+    auto *layout = new QVBoxLayout(this);
+
+    testLabel = new QLabel(this);
+    layout->addWidget(testLabel);
+
+    warmupEdit = new QSpinBox(this);
+    warmupEdit->setRange(0, 100);
+    warmupEdit->setValue(2);
+    runsEdit = new QSpinBox(this);
+    runsEdit->setRange(1, 1000);
+    runsEdit->setValue(10);
+    cpuEdit = new QSpinBox(this);
+    cpuEdit->setRange(-1, qMax(1, QThread::idealThreadCount()) - 1);
+    cpuEdit->setSpecialValueText("не закреплять");
+    cpuEdit->setValue(-1);
+#ifndef Q_OS_LINUX
+    cpuEdit->setEnabled(false);
+#endif
+    labelEdit = new QLineEdit(this);
+    labelEdit->setPlaceholderText("например, «до оптимизации»");
+
+    auto *form = new QFormLayout();
+    form->addRow("Прогревочных запусков:", warmupEdit);
+    form->addRow("Замеряемых запусков:", runsEdit);
+    form->addRow("Ядро процессора:", cpuEdit);
+    form->addRow("Метка:", labelEdit);
+    layout->addLayout(form);
+
+    runButton = new QPushButton("Запустить", this);
+    cancelButton = new QPushButton("Отменить", this);
+    cancelButton->setEnabled(false);
+    auto *openButton = new QPushButton("Открыть сохранённый…", this);
+    compareButton = new QPushButton("Сравнить с…", this);
+    compareButton->setEnabled(false);
+
+    auto *buttonLayout = new QHBoxLayout();
+    buttonLayout->addWidget(runButton);
+    buttonLayout->addWidget(cancelButton);
+    buttonLayout->addStretch();
+    buttonLayout->addWidget(openButton);
+    buttonLayout->addWidget(compareButton);
+    layout->addLayout(buttonLayout);
+
+    progressBar = new QProgressBar(this);
+    progressBar->setValue(0);
+    layout->addWidget(progressBar);
+
+    resultLabel = new QLabel(this);
+    resultLabel->setWordWrap(true);
+    resultLabel->setTextInteractionFlags(Qt::TextSelectableByMouse);
+    layout->addWidget(resultLabel);
+
+    table = new QTableWidget(0, 0, this);
+    table->verticalHeader()->setVisible(false);
+    table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    table->setSelectionBehavior(QAbstractItemView::SelectRows);
+    layout->addWidget(table);
+
+    connect(runButton, &QPushButton::clicked, this, &BenchmarkDialog::requestRun);
+    connect(cancelButton, &QPushButton::clicked, this, &BenchmarkDialog::cancelRequested);
+    connect(openButton, &QPushButton::clicked, this, &BenchmarkDialog::openSaved);
+    connect(compareButton, &QPushButton::clicked, this, &BenchmarkDialog::compareWith);
+}
+
+
+void BenchmarkDialog::setTestName(const QString &name)
+{
+    testLabel->setText("Тест: " + name);
+}
+
+
+void BenchmarkDialog::setRunning(bool running)
+{
+    runButton->setEnabled(!running);
+    cancelButton->setEnabled(running);
+    if (running)
+        progressBar->setValue(0);
+}
+
+
+void BenchmarkDialog::setProgress(int finishedRuns, int totalRuns)
+{
+    progressBar->setMaximum(qMax(1, totalRuns));
+    progressBar->setValue(finishedRuns);
+}
+
+
+void BenchmarkDialog::showResult(const BenchmarkResult &result, const QString &filePath)
+{
+    primary = result;
+    hasPrimary = true;
+    hasBaseline = false;
+    compareButton->setEnabled(true);
+    resultLabel->setText(filePath.isEmpty() ? result.title()
+                                            : result.title() + "\nСохранено: " + QDir::toNativeSeparators(filePath));
+    rebuildTable();
+}
+
+
+void BenchmarkDialog::requestRun()
+{
+    BenchmarkRunner::Options options;
+    options.warmupRuns = warmupEdit->value();
+    options.runs = runsEdit->value();
+    options.pinnedCpu = cpuEdit->value();
+    emit runRequested(options, labelEdit->text().trimmed());
+}
+
+
+void BenchmarkDialog::openSaved()
+{
+    QString filePath = QFileDialog::getOpenFileName(this, "Открыть замеры", BenchmarkResult::defaultDirectory(),
+                                                    "Замеры (*.json)");
+    if (filePath.isEmpty())
+        return;
+
+    BenchmarkResult result;
+    QString error;
+    if (!BenchmarkResult::load(filePath, &result, &error)) {
+        QMessageBox::warning(this, "Ошибка", error);
+        return;
+    }
+    showResult(result, filePath);
+}
+
+
+void BenchmarkDialog::compareWith()
+{
+    QString filePath = QFileDialog::getOpenFileName(this, "Сравнить с замерами",
+                                                    BenchmarkResult::defaultDirectory(), "Замеры (*.json)");
+    if (filePath.isEmpty())
+        return;
+
+    QString error;
+    if (!BenchmarkResult::load(filePath, &baseline, &error)) {
+        QMessageBox::warning(this, "Ошибка", error);
+        return;
+    }
+    if (baseline.testName != primary.testName) {
+        QMessageBox::information(this, "Другой тест",
+                                 QString("Замеры сделаны на тесте «%1», а не «%2»; случаи сопоставляются по номерам.")
+                                     .arg(baseline.testName, primary.testName));
+    }
+    hasBaseline = true;
+    resultLabel->setText("A: " + primary.title() + "\nB: " + baseline.title());
+    rebuildTable();
+}
+
+
+void BenchmarkDialog::rebuildTable()
+{
+    table->clear();
+    table->setRowCount(0);
+    if (!hasPrimary)
+        return;
+
+    if (hasBaseline)
+        showComparison();
+    else
+        showSingle();
+    table->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
+}
+
+
+void BenchmarkDialog::showSingle()
+{
+    table->setColumnCount(9);
+    table->setHorizontalHeaderLabels(QStringList() << "Случай" << "Замеров" << "Мин, мс" << "Медиана, мс"
+                                                   << "p95, мс" << "σ, мс" << "CPU медиана, мс" << "CPU σ, мс"
+                                                   << "Пик памяти, КБ");
+
+    for (const BenchmarkCase &benchmarkCase : std::as_const(primary.cases)) {
+        int row = table->rowCount();
+        table->insertRow(row);
+        table->setItem(row, 0, new QTableWidgetItem(QString::number(benchmarkCase.caseIndex + 1)));
+
+        if (!benchmarkCase.failure.isEmpty()) {
+            auto *failureItem = new QTableWidgetItem(benchmarkCase.failure);
+            failureItem->setForeground(Qt::red);
+            failureItem->setToolTip(benchmarkCase.failure);
+            table->setItem(row, 1, failureItem);
+            table->setSpan(row, 1, 1, table->columnCount() - 1);
+            continue;
+        }
+
+        BenchmarkStats wall = benchmarkCase.wallStats();
+        BenchmarkStats cpu = benchmarkCase.cpuStats();
+        BenchmarkStats memory = benchmarkCase.memoryStats();
+        table->setItem(row, 1, numberItem(QString::number(wall.count)));
+        table->setItem(row, 2, numberItem(formatMs(wall.min)));
+        table->setItem(row, 3, numberItem(formatMs(wall.median)));
+        table->setItem(row, 4, numberItem(formatMs(wall.p95)));
+        table->setItem(row, 5, numberItem(formatMs(wall.stddev)));
+        table->setItem(row, 6, numberItem(cpu.count ? formatMs(cpu.median) : "—"));
+        table->setItem(row, 7, numberItem(cpu.count ? formatMs(cpu.stddev) : "—"));
+        table->setItem(row, 8, numberItem(memory.count ? QString::number(qint64(memory.median)) : "—"));
+    }
+}
+
+
+void BenchmarkDialog::showComparison()
+{
+    table->setColumnCount(10);
+    table->setHorizontalHeaderLabels(QStringList() << "Случай" << "Медиана A, мс" << "Медиана B, мс" << "A / B"
+                                                   << "p95 A, мс" << "p95 B, мс" << "CPU A, мс" << "CPU B, мс"
+                                                   << "Память A, КБ" << "Память B, КБ");
+
+    for (const BenchmarkCase &current : std::as_const(primary.cases)) {
+        int row = table->rowCount();
+        table->insertRow(row);
+        table->setItem(row, 0, new QTableWidgetItem(QString::number(current.caseIndex + 1)));
+
+        const BenchmarkCase *other = findCase(baseline, current.caseIndex);
+        QString failure;
+        if (!current.failure.isEmpty())
+            failure = "A: " + current.failure;
+        else if (!other)
+            failure = "B: случай отсутствует";
+        else if (!other->failure.isEmpty())
+            failure = "B: " + other->failure;
+        if (!failure.isEmpty()) {
+            auto *failureItem = new QTableWidgetItem(failure);
+            failureItem->setForeground(Qt::red);
+            failureItem->setToolTip(failure);
+            table->setItem(row, 1, failureItem);
+            table->setSpan(row, 1, 1, table->columnCount() - 1);
+            continue;
+        }
+
+        BenchmarkStats wallA = current.wallStats();
+        BenchmarkStats wallB = other->wallStats();
+        BenchmarkStats cpuA = current.cpuStats();
+        BenchmarkStats cpuB = other->cpuStats();
+        BenchmarkStats memoryA = current.memoryStats();
+        BenchmarkStats memoryB = other->memoryStats();
+
+        table->setItem(row, 1, numberItem(formatMs(wallA.median)));
+        table->setItem(row, 2, numberItem(formatMs(wallB.median)));
+
+        auto *ratioItem = numberItem("—");
+        if (wallB.median > 0) {
+            double ratio = wallA.median / wallB.median;
+            ratioItem->setText(QString::number(ratio, 'f', 2) + "×");
+            // Разница меньше разброса замеров не подсвечивается.
+            double noise = qMax(wallA.stddev, wallB.stddev);
+            if (qAbs(wallA.median - wallB.median) > noise)
+                ratioItem->setForeground(ratio < 1 ? QColor(Qt::darkGreen) : QColor(Qt::red));
+        }
+        table->setItem(row, 3, ratioItem);
+
+        table->setItem(row, 4, numberItem(formatMs(wallA.p95)));
+        table->setItem(row, 5, numberItem(formatMs(wallB.p95)));
+        table->setItem(row, 6, numberItem(cpuA.count ? formatMs(cpuA.median) : "—"));
+        table->setItem(row, 7, numberItem(cpuB.count ? formatMs(cpuB.median) : "—"));
+        table->setItem(row, 8, numberItem(memoryA.count ? QString::number(qint64(memoryA.median)) : "—"));
+        table->setItem(row, 9, numberItem(memoryB.count ? QString::number(qint64(memoryB.median)) : "—"));
+    }
+}
+
+
+QString BenchmarkDialog::formatMs(double value)
+{
+    return QString::number(value, 'f', value < 10 ? 3 : 1);
+}
@@ -0,0 +1,61 @@
+#ifndef BENCHMARKDIALOG_H
+#define BENCHMARKDIALOG_H
+
+#include <QDialog>
+#include "benchmarkrunner.h"
+
+class QLabel;
+class QLineEdit;
+class QSpinBox;
+class QPushButton;
+class QProgressBar;
+class QTableWidget;
+
+// Настройки бенчмарка и таблица статистики. Показывает один результат или,
+// если выбран второй сохранённый, сравнение двух версий решения по случаям.
+class BenchmarkDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit BenchmarkDialog(QWidget *parent = nullptr);
+
+    void setTestName(const QString &name);
+    void setRunning(bool running);
+    void setProgress(int finishedRuns, int totalRuns);
+    void showResult(const BenchmarkResult &result, const QString &filePath);
+
+signals:
+    void runRequested(const BenchmarkRunner::Options &options, const QString &label);
+    void cancelRequested();
+
+private slots:
+    void requestRun();
+    void openSaved();
+    void compareWith();
+
+private:
+    void rebuildTable();
+    void showSingle();
+    void showComparison();
+    static QString formatMs(double value);
+
+    QLabel *testLabel;
+    QSpinBox *warmupEdit;
+    QSpinBox *runsEdit;
+    QSpinBox *cpuEdit;
+    QLineEdit *labelEdit;
+    QPushButton *runButton;
+    QPushButton *cancelButton;
+    QPushButton *compareButton;
+    QProgressBar *progressBar;
+    QLabel *resultLabel;
+    QTableWidget *table;
+
+    BenchmarkResult primary;
+    BenchmarkResult baseline;
+    bool hasPrimary = false;
+    bool hasBaseline = false;
+};
+
+#endif // BENCHMARKDIALOG_H
@@ -0,0 +1,106 @@
+#include "benchmarkrunner.h"
+
+BenchmarkRunner::BenchmarkRunner(const QString &executable, const TestDefinition &test, const Options &options,
+                                 QObject *parent)
+    : QObject(parent),
+      executable(executable),
+      test(test),
+      options(options)
+{
+    benchmark.testName = test.name;
+    benchmark.warmupRuns = options.warmupRuns;
+    benchmark.runs = options.runs;
+    benchmark.pinnedCpu = options.pinnedCpu;
+}
+
+
+void BenchmarkRunner::start()
+{
+    if (running)
+        return;
+
+    running = true;
+    benchmark.timestamp = QDateTime::currentDateTime();
+    benchmark.cases.clear();
+    caseIndex = 0;
+    runIndex = 0;
+    finished = 0;
+    currentCase = BenchmarkCase();
+    startRun();
+}
+
+
+void BenchmarkRunner::cancel()
+{
+    if (!running)
+        return;
+
+    cancelled = true;
+    if (active)
+        active->cancel();
+}
+
+
+void BenchmarkRunner::startRun()
+{
+    if (cancelled || caseIndex >= test.cases.size()) {
+        running = false;
+        emit allFinished();
+        return;
+    }
+
+    auto *runner = new TestRunner(executable, test, caseIndex, this);
+    ResourceLimits limits = runner->testCase().limits;
+    limits.limitAddressSpace = options.addressSpaceLimit;
+    limits.pinnedCpu = options.pinnedCpu;
+    runner->setLimits(limits);
+    active = runner;
+
+    connect(runner, &TestRunner::finished, this, [this, runner] {
+        active = nullptr;
+        runner->deleteLater();
+        ++finished;
+
+        const TestResult &result = runner->result();
+        if (cancelled) {
+            startRun();
+            return;
+        }
+
+        currentCase.caseIndex = caseIndex;
+        if (!result.passed()) {
+            currentCase.failure = TestResult::verdictName(result.verdict);
+            if (!result.details.isEmpty())
+                currentCase.failure += ": " + result.details;
+            // Оставшиеся запуски случая не выполняются, но прогресс учитывает их.
+            finished += options.warmupRuns + options.runs - runIndex - 1;
+            finishCase();
+        } else {
+            if (runIndex >= options.warmupRuns) {
+                currentCase.wallMs.append(result.wallUs / 1000.0);
+                if (result.usage.valid) {
+                    currentCase.cpuMs.append(result.usage.cpuUs() / 1000.0);
+                    currentCase.peakRssKb.append(result.usage.peakRssKb);
+                }
+            }
+            if (++runIndex >= options.warmupRuns + options.runs)
+                finishCase();
+        }
+
+        emit progress(finished, totalRuns());
+        startRun();
+    });
+
+    runner->start();
+}
+
+
+void BenchmarkRunner::finishCase()
+{
+    benchmark.cases.append(currentCase);
+    emit caseFinished(currentCase);
+
+    currentCase = BenchmarkCase();
+    runIndex = 0;
+    ++caseIndex;
+}
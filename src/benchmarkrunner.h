@@ -0,0 +1,59 @@
+#ifndef BENCHMARKRUNNER_H
+#define BENCHMARKRUNNER_H
+
+#include <QObject>
+#include "benchmark.h"
+#include "testrunner.h"
+
+// Многократный прогон решения на случаях одного теста. Запуски идут строго
+// по одному, чтобы не мешать друг другу: сначала прогревочные (не
+// учитываются), затем замеряемые.
+class BenchmarkRunner : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Options
+    {
+        int warmupRuns = 2;
+        int runs = 10;
+        int pinnedCpu = -1;
+        bool addressSpaceLimit = true;
+    };
+
+    BenchmarkRunner(const QString &executable, const TestDefinition &test, const Options &options,
+                    QObject *parent = nullptr);
+
+    const BenchmarkResult &result() const { return benchmark; }
+    int totalRuns() const { return test.cases.size() * (options.warmupRuns + options.runs); }
+    int finishedRuns() const { return finished; }
+    bool isRunning() const { return running; }
+    bool wasCancelled() const { return cancelled; }
+
+public slots:
+    void start();
+    void cancel();
+
+signals:
+    void progress(int finishedRuns, int totalRuns);
+    void caseFinished(const BenchmarkCase &benchmarkCase);
+    void allFinished();
+
+private:
+    void startRun();
+    void finishCase();
+
+    QString executable;
+    TestDefinition test;
+    Options options;
+    BenchmarkResult benchmark;
+    BenchmarkCase currentCase;
+    TestRunner *active = nullptr;
+    int caseIndex = 0;
+    int runIndex = 0;
+    int finished = 0;
+    bool running = false;
+    bool cancelled = false;
+};
+
+#endif // BENCHMARKRUNNER_H
@@ -0,0 +1,235 @@
+#include "buildprofile.h"
+#include <QCoreApplication>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QSaveFile>
+#include <QFile>
+#include <QStandardPaths>
+
+namespace {
+
+QJsonArray toJsonArray(const QStringList &list)
+{
+    QJsonArray array;
+    for (const QString &item : list)
+        array.append(item);
+    return array;
+}
+
+
+QStringList toStringList(const QJsonValue &value)
+{
+    QStringList list;
+    const QJsonArray array = value.toArray();
+    for (const QJsonValue &item : array) {
+        QString text = item.toString().trimmed();
+        if (!text.isEmpty())
+            list << text;
+    }
+    return list;
+}
+
+}
+
+
+BuildProfile BuildProfile::fromJson(const QJsonObject &obj)
+{
+    BuildProfile profile;
+    profile.name = obj.value("name").toString();
+    profile.compiler = obj.value("compiler").toString(profile.compiler);
+    profile.standard = obj.value("std").toString(profile.standard);
+    profile.optimization = obj.value("optimization").toString(profile.optimization);
+    profile.nativeArch = obj.value("nativeArch").toBool();
+    profile.debugInfo = obj.value("debugInfo").toBool();
+    profile.sanitizers = toStringList(obj.value("sanitizers"));
+    profile.linker = obj.value("linker").toString();
+    profile.extraFlags = toStringList(obj.value("flags"));
+    return profile;
+}
+
+
+QJsonObject BuildProfile::toJson() const
+{
+    QJsonObject obj;
+    obj["name"] = name;
+    obj["compiler"] = compiler;
+    obj["std"] = standard;
+    obj["optimization"] = optimization;
+    obj["nativeArch"] = nativeArch;
+    obj["debugInfo"] = debugInfo;
+    obj["sanitizers"] = toJsonArray(sanitizers);
+    obj["linker"] = linker;
+    obj["flags"] = toJsonArray(extraFlags);
+    return obj;
+}
+
+
+QStringList BuildProfile::compileFlags() const
+{
+    QStringList flags = objectFlags();
+    // Недоступный компоновщик пропускается, чтобы профиль работал на любой машине.
+    if (!linker.isEmpty() && linkerAvailable(linker))
+        flags.insert(flags.size() - extraFlags.size(), "-fuse-ld=" + linker);
+    return flags;
+}
+
+
+QStringList BuildProfile::objectFlags() const
+{
+    QStringList flags;
+    if (!standard.isEmpty())
+        flags << "-std=" + standard;
+    if (!optimization.isEmpty())
+        flags << "-O" + optimization;
+    if (nativeArch)
+        flags << "-march=native";
+    if (debugInfo)
+        flags << "-g";
+    if (!sanitizers.isEmpty())
+        flags << "-fsanitize=" + sanitizers.join(',') << "-fno-omit-frame-pointer";
+    flags << extraFlags;
+    return flags;
+}
+
+
+QStringList BuildProfile::linkFlags() const
+{
+    QStringList flags;
+    if (!sanitizers.isEmpty())
+        flags << "-fsanitize=" + sanitizers.join(',');
+    if (!linker.isEmpty() && linkerAvailable(linker))
+        flags << "-fuse-ld=" + linker;
+    flags << extraFlags;
+    return flags;
+}
+
+
+QStringList BuildProfile::syntaxCheckFlags() const
+{
+    QStringList flags;
+    if (!standard.isEmpty())
+        flags << "-std=" + standard;
+    flags << extraFlags;
+    return flags;
+}
+
+
+bool BuildProfile::usesAddressSanitizer() const
+{
+    return sanitizers.contains("address") || sanitizers.contains("hwaddress");
+}
+
+
+QString BuildProfile::summary() const
+{
+    return name + ": " + compiler + " " + compileFlags().join(' ');
+}
+
+
+bool BuildProfile::linkerAvailable(const QString &linker)
+{
+    static QHash<QString, bool> known;
+    auto it = known.constFind(linker);
+    if (it != known.constEnd())
+        return it.value();
+
+    // GCC ищет ld.<имя> рядом с собой и в PATH.
+    bool available = !QStandardPaths::findExecutable("ld." + linker).isEmpty()
+                     || !QStandardPaths::findExecutable(linker).isEmpty();
+    known.insert(linker, available);
+    return available;
+}
+
+
+bool BuildProfiles::load(const QString &filePath, QList<BuildProfile> *profiles, QString *current, QString *error)
+{
+    QFile file(filePath);
+    if (!file.exists()) {
+        *profiles = defaults();
+        *current = profiles->first().name;
+        return save(filePath, *profiles, *current, error);
+    }
+
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (error)
+            *error = "Не удалось открыть файл профилей " + filePath + ".";
+        return false;
+    }
+
+    QJsonParseError parseError;
+    QJsonDocument doc = QJsonDocument::fromJson(file.readAll(), &parseError);
+    if (parseError.error != QJsonParseError::NoError || !doc.isObject()) {
+        if (error)
+            *error = "Неверный формат файла профилей " + filePath + ".";
+        return false;
+    }
+
+    profiles->clear();
+    const QJsonArray array = doc.object().value("profiles").toArray();
+    for (const QJsonValue &value : array) {
+        BuildProfile profile = BuildProfile::fromJson(value.toObject());
+        if (!profile.name.isEmpty())
+            profiles->append(profile);
+    }
+    if (profiles->isEmpty())
+        *profiles = defaults();
+
+    *current = doc.object().value("current").toString(profiles->first().name);
+    return true;
+}
+
+
+bool BuildProfiles::save(const QString &filePath, const QList<BuildProfile> &profiles, const QString &current,
+                         QString *error)
+{
+    QJsonArray array;
+    for (const BuildProfile &profile : profiles)
+        array.append(profile.toJson());
+
+    QJsonObject root;
+    root["current"] = current;
+    root["profiles"] = array;
+
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        if (error)
+            *error = "Не удалось записать файл профилей " + filePath + ".";
+        return false;
+    }
+    file.write(QJsonDocument(root).toJson());
+    if (!file.commit()) {
+        if (error)
+            *error = "Не удалось записать файл профилей " + filePath + ".";
+        return false;
+    }
+    return true;
+}
+
+
+QList<BuildProfile> BuildProfiles::defaults()
+{
+    BuildProfile fastCompile;
+    fastCompile.name = "Быстрая сборка";
+    fastCompile.optimization = "0";
+    fastCompile.linker = BuildProfile::linkerAvailable("mold") ? "mold" : "lld";
+
+    BuildProfile fastRun;
+    fastRun.name = "Быстрый запуск";
+    fastRun.optimization = "2";
+    fastRun.nativeArch = true;
+
+    BuildProfile sanitized;
+    sanitized.name = "Отладка с санитайзерами";
+    sanitized.optimization = "1";
+    sanitized.debugInfo = true;
+    sanitized.sanitizers << "address" << "undefined";
+
+    return QList<BuildProfile>() << fastCompile << fastRun << sanitized;
+}
+
+
+QString BuildProfiles::defaultPath()
+{
+    return QCoreApplication::applicationDirPath() + "/profiles.json";
+}
@@ -0,0 +1,50 @@
+#ifndef BUILDPROFILE_H
+#define BUILDPROFILE_H
+
+#include <QJsonObject>
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+// Именованный набор флагов компиляции. Профили хранятся в profiles.json
+// рядом с программой; при первом запуске туда записываются стандартные.
+struct BuildProfile
+{
+    QString name;
+    QString compiler = "g++";
+    QString standard = "c++17";
+    QString optimization = "0";
+    bool nativeArch = false;
+    bool debugInfo = false;
+    QStringList sanitizers;
+    QString linker; // пусто — компоновщик по умолчанию
+    QStringList extraFlags;
+
+    static BuildProfile fromJson(const QJsonObject &obj);
+    QJsonObject toJson() const;
+
+    // Флаги сборки одной командой: компиляция и компоновка.
+    QStringList compileFlags() const;
+    // Флаги раздельной сборки: компиляция в объектный файл (-c) и компоновка
+    // объектов. Санитайзеры нужны на обоих шагах, -fuse-ld — только при компоновке.
+    QStringList objectFlags() const;
+    QStringList linkFlags() const;
+    QStringList syntaxCheckFlags() const;
+    bool usesAddressSanitizer() const;
+    QString summary() const;
+
+    static bool linkerAvailable(const QString &linker);
+};
+
+class BuildProfiles
+{
+public:
+    static bool load(const QString &filePath, QList<BuildProfile> *profiles, QString *current,
+                     QString *error = nullptr);
+    static bool save(const QString &filePath, const QList<BuildProfile> &profiles, const QString &current,
+                     QString *error = nullptr);
+    static QList<BuildProfile> defaults();
+    static QString defaultPath();
+};
+
+#endif // BUILDPROFILE_H
@@ -0,0 +1,22 @@
+#ifndef CODEBLOCKDATA_H
+#define CODEBLOCKDATA_H
+
+#include <QTextBlock>
+#include <QTextBlockUserData>
+#include "cpplexer.h"
+
+// Данные, которые редактор хранит при каждом блоке (строке) документа.
+class CodeBlockData : public QTextBlockUserData
+{
+public:
+    CppLexer::State lexState; // состояние лексера на конце блока
+    int highlightPass = 0;
+    bool folded = false; // следующие строки до парной '}' скрыты
+
+    static CodeBlockData *of(const QTextBlock &block)
+    {
+        return static_cast<CodeBlockData *>(block.userData());
+    }
+};
+
+#endif // CODEBLOCKDATA_H
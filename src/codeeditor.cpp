@@ -1,7 +1,57 @@
 #include "codeeditor.h"
+#include "codeblockdata.h"
+#include "cpphighlighter.h"
+#include "symbolindex.h"
+#include <QAbstractItemView>
+#include <QCompleter>
 #include <QKeyEvent>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QPaintEvent>
+#include <QResizeEvent>
+#include <QScrollBar>
+#include <QStringListModel>
 #include <QTextCursor>
 #include <QTextBlock>
+#include <QTextDocument>
+#include <QHelpEvent>
+#include <QToolTip>
+
+namespace {
+
+// Подсказка появляется со второго символа слова, Ctrl+Space — с первого.
+const int MinCompletionPrefix = 2;
+const int MaxCompletions = 50;
+
+bool isWordChar(QChar c)
+{
+    return c.isLetterOrNumber() || c == '_';
+}
+
+}
+
+
+// Поле слева от текста: номера строк и значки сворачивания. Рисует и
+// обрабатывает щелчки сам редактор.
+class CodeGutter : public QWidget
+{
+public:
+    explicit CodeGutter(CodeEditor *editor)
+        : QWidget(editor),
+          editor(editor)
+    {
+    }
+
+    QSize sizeHint() const override { return QSize(editor->gutterWidth(), 0); }
+
+protected:
+    void paintEvent(QPaintEvent *event) override { editor->paintGutter(event); }
+    void mousePressEvent(QMouseEvent *event) override { editor->gutterClicked(event->position().toPoint()); }
+
+private:
+    CodeEditor *editor;
+};
+
 
 CodeEditor::CodeEditor(QWidget *parent)
     : QPlainTextEdit(parent)
@@ -9,10 +59,483 @@ CodeEditor::CodeEditor(QWidget *parent)
     QFont font("Consolas", 12);
     setFont(font);
     setTabStopDistance(4 * QFontMetricsF(font).horizontalAdvance(' '));
+
+    syntaxHighlighter = new CppHighlighter(document());
+    symbolIndex = new SymbolIndex(document(), this);
+
+    completionModel = new QStringListModel(this);
+    completer = new QCompleter(completionModel, this);
+    completer->setWidget(this);
+    completer->setCompletionMode(QCompleter::PopupCompletion);
+    completer->setCaseSensitivity(Qt::CaseSensitive);
+    completer->setModelSorting(QCompleter::CaseSensitivelySortedModel);
+    completer->setMaxVisibleItems(12);
+    connect(completer, qOverload<const QString &>(&QCompleter::activated), this, &CodeEditor::insertCompletion);
+
+    QStringList lines;
+    for (QTextBlock block = document()->begin(); block.isValid(); block = block.next())
+        lines.append(block.text());
+    nestingIndex.replaceLines(0, 0, lines);
+    indexedBlockCount = lines.size();
+
+    gutter = new CodeGutter(this);
+    connect(document(), &QTextDocument::contentsChange, this, &CodeEditor::onContentsChange);
+    connect(this, &QPlainTextEdit::blockCountChanged, this, [this] { setViewportMargins(gutterWidth(), 0, 0, 0); });
+    connect(this, &QPlainTextEdit::updateRequest, this, &CodeEditor::updateGutter);
+    connect(this, &QPlainTextEdit::cursorPositionChanged, this, &CodeEditor::matchBrackets);
+    setViewportMargins(gutterWidth(), 0, 0, 0);
+}
+
+
+void CodeEditor::setMarks(MarkLayer layer, const QList<Mark> &newMarks)
+{
+    QList<LayerMark> &layerMarks = marks[layer];
+    layerMarks.clear();
+
+    QTextCharFormat format = markFormat(layer);
+    for (const Mark &mark : newMarks) {
+        LayerMark layerMark;
+        layerMark.selection.cursor = QTextCursor(document());
+        layerMark.selection.cursor.setPosition(mark.position);
+        layerMark.selection.cursor.setPosition(mark.position + mark.length, QTextCursor::KeepAnchor);
+        layerMark.selection.format = format;
+        layerMark.message = mark.message;
+        layerMarks.append(layerMark);
+    }
+
+    updateExtraSelections();
+}
+
+
+void CodeEditor::clearMarks(MarkLayer layer)
+{
+    if (marks.remove(layer))
+        updateExtraSelections();
+}
+
+
+QTextCharFormat CodeEditor::markFormat(MarkLayer layer) const
+{
+    QTextCharFormat format;
+    switch (layer) {
+    case MarkLayer::Forbidden:
+        format.setBackground(QColor(255, 220, 220));
+        format.setUnderlineStyle(QTextCharFormat::WaveUnderline);
+        format.setUnderlineColor(Qt::red);
+        break;
+    case MarkLayer::Errors:
+        format.setUnderlineStyle(QTextCharFormat::WaveUnderline);
+        format.setUnderlineColor(Qt::red);
+        break;
+    case MarkLayer::Warnings:
+        format.setUnderlineStyle(QTextCharFormat::WaveUnderline);
+        format.setUnderlineColor(QColor(230, 140, 0));
+        break;
+    }
+    return format;
+}
+
+
+void CodeEditor::updateExtraSelections()
+{
+    QList<QTextEdit::ExtraSelection> selections;
+    for (const QList<LayerMark> &layerMarks : std::as_const(marks)) {
+        for (const LayerMark &mark : layerMarks)
+            selections.append(mark.selection);
+    }
+    selections += bracketSelections;
+    setExtraSelections(selections);
+}
+
+
+void CodeEditor::onContentsChange(int position, int charsRemoved, int charsAdded)
+{
+    Q_UNUSED(charsRemoved);
+
+    // Диапазон изменённых строк считается так же, как в SymbolIndex.
+    QTextBlock firstBlock = document()->findBlock(position);
+    QTextBlock lastBlock = document()->findBlock(position + charsAdded);
+    if (!firstBlock.isValid())
+        firstBlock = document()->lastBlock();
+    if (!lastBlock.isValid())
+        lastBlock = document()->lastBlock();
+
+    QStringList lines;
+    for (QTextBlock block = firstBlock; block.isValid(); block = block.next()) {
+        lines.append(block.text());
+        if (block == lastBlock)
+            break;
+    }
+
+    int blockCount = document()->blockCount();
+    int removed = lines.size() - (blockCount - indexedBlockCount);
+    indexedBlockCount = blockCount;
+    nestingIndex.replaceLines(firstBlock.blockNumber(), removed, lines);
+
+    // Правка в свёрнутой области, в её заголовке или в строке с '}' сразу
+    // за ней раскрывает область: иначе скрытые строки перестали бы
+    // совпадать со скобками.
+    if (foldedCount > 0) {
+        int lastEdited = lastBlock.blockNumber();
+        for (QTextBlock block = firstBlock; block.isValid(); block = block.next()) {
+            CodeBlockData *data = CodeBlockData::of(block);
+            if (data && data->folded) {
+                unfold(block, lastEdited);
+            } else if (!block.isVisible() || (block.previous().isValid() && !block.previous().isVisible())) {
+                unfold(foldHeader(block), lastEdited);
+            }
+            if (block == lastBlock)
+                break;
+        }
+
+        // Заголовок мог исчезнуть вместе со своим CodeBlockData: Backspace в
+        // начале его строки или удаление выделения через него. Тогда за
+        // правкой остаются скрытые строки без свёрнутого заголовка, до
+        // которых не добраться с клавиатуры, — они раскрываются.
+        QTextBlock after = lastBlock.next();
+        if (after.isValid() && !after.isVisible()) {
+            QTextBlock header = foldHeader(after);
+            CodeBlockData *data = CodeBlockData::of(header);
+            if (!data || !data->folded)
+                unfold(header);
+        }
+
+        // Вместе с удалёнными блоками пропадают и их флаги folded.
+        if (removed > 1)
+            recountFolds();
+    }
+
+    matchBrackets();
 }
 
 
-void CodeEditor::keyPressEvent(QKeyEvent *event) {
+QTextBlock CodeEditor::foldHeader(const QTextBlock &block) const
+{
+    QTextBlock header = block.previous();
+    while (header.isValid() && !header.isVisible())
+        header = header.previous();
+    return header.isValid() ? header : document()->firstBlock();
+}
+
+
+void CodeEditor::recountFolds()
+{
+    foldedCount = 0;
+    for (QTextBlock block = document()->firstBlock(); block.isValid(); block = block.next()) {
+        CodeBlockData *data = CodeBlockData::of(block);
+        if (data && data->folded)
+            ++foldedCount;
+    }
+}
+
+
+void CodeEditor::toggleFold(const QTextBlock &block)
+{
+    if (!block.isValid())
+        return;
+
+    CodeBlockData *data = CodeBlockData::of(block);
+    if (data && data->folded) {
+        unfold(block);
+        return;
+    }
+
+    // Строка с '}' остаётся видна, скрывается только то, что между скобками.
+    int line = block.blockNumber();
+    int end = nestingIndex.foldEnd(line);
+    if (end <= line + 1)
+        return;
+
+    if (!data) {
+        data = new CodeBlockData;
+        QTextBlock(block).setUserData(data);
+    }
+    data->folded = true;
+    ++foldedCount;
+
+    QTextBlock last = document()->findBlockByNumber(end - 1);
+    for (QTextBlock hidden = block.next(); hidden.isValid(); hidden = hidden.next()) {
+        hidden.setVisible(false);
+        if (hidden == last)
+            break;
+    }
+
+    QTextCursor cursor = textCursor();
+    if (!cursor.block().isVisible()) {
+        cursor.setPosition(block.position() + block.length() - 1);
+        setTextCursor(cursor);
+    }
+
+    relayout(block, last);
+    ensureCursorVisible();
+}
+
+
+void CodeEditor::unfold(const QTextBlock &block, int lastEdited)
+{
+    QTextBlock(block).setVisible(true);
+    CodeBlockData *data = CodeBlockData::of(block);
+    if (data && data->folded) {
+        data->folded = false;
+        --foldedCount;
+    }
+
+    // Строки, вставленные правкой в скрытую область, видимы сами, поэтому
+    // раскрытие идёт и по ним — до последней изменённой строки.
+    QTextBlock last = block;
+    for (QTextBlock next = block.next(); next.isValid(); next = next.next()) {
+        if (next.isVisible() && next.blockNumber() > lastEdited)
+            break;
+        next.setVisible(true);
+        CodeBlockData *inner = CodeBlockData::of(next);
+        if (inner && inner->folded) {
+            inner->folded = false;
+            --foldedCount;
+        }
+        last = next;
+    }
+
+    relayout(block, last);
+}
+
+
+void CodeEditor::relayout(const QTextBlock &first, const QTextBlock &last)
+{
+    document()->markContentsDirty(first.position(), last.position() + last.length() - first.position());
+    viewport()->update();
+    gutter->update();
+}
+
+
+void CodeEditor::matchBrackets()
+{
+    bool hadBrackets = !bracketSelections.isEmpty();
+    bracketSelections.clear();
+
+    // Курсор может сдвинуться раньше, чем правка дойдёт до индекса.
+    QTextCursor cursor = textCursor();
+    if (!cursor.hasSelection() && nestingIndex.lineCount() == document()->blockCount()) {
+        QTextBlock block = cursor.block();
+        int line = block.blockNumber();
+        int column = cursor.positionInBlock();
+        if (!nestingIndex.bracketAt(line, column))
+            --column; // скобка перед курсором
+        if (nestingIndex.bracketAt(line, column)) {
+            NestingIndex::Match match = nestingIndex.findMatch(line, column);
+
+            QTextEdit::ExtraSelection selection;
+            selection.format.setBackground(match.matched ? QColor(200, 235, 200) : QColor(255, 200, 200));
+            selection.cursor = QTextCursor(document());
+            selection.cursor.setPosition(block.position() + column);
+            selection.cursor.setPosition(block.position() + column + 1, QTextCursor::KeepAnchor);
+            bracketSelections.append(selection);
+
+            if (match.isValid()) {
+                int position = document()->findBlockByNumber(match.line).position() + match.column;
+                selection.cursor.setPosition(position);
+                selection.cursor.setPosition(position + 1, QTextCursor::KeepAnchor);
+                bracketSelections.append(selection);
+            }
+        }
+    }
+
+    if (hadBrackets || !bracketSelections.isEmpty())
+        updateExtraSelections();
+    gutter->update();
+}
+
+
+int CodeEditor::gutterWidth() const
+{
+    int digits = 1;
+    for (int count = qMax(1, blockCount()); count >= 10; count /= 10)
+        ++digits;
+    return 8 + fontMetrics().horizontalAdvance(QLatin1Char('9')) * digits + foldMarkerWidth();
+}
+
+
+int CodeEditor::foldMarkerWidth() const
+{
+    return fontMetrics().height();
+}
+
+
+void CodeEditor::updateGutter(const QRect &rect, int dy)
+{
+    if (dy)
+        gutter->scroll(0, dy);
+    else
+        gutter->update(0, rect.y(), gutter->width(), rect.height());
+
+    if (rect.contains(viewport()->rect()))
+        setViewportMargins(gutterWidth(), 0, 0, 0);
+}
+
+
+void CodeEditor::resizeEvent(QResizeEvent *event)
+{
+    QPlainTextEdit::resizeEvent(event);
+
+    QRect rect = contentsRect();
+    gutter->setGeometry(QRect(rect.left(), rect.top(), gutterWidth(), rect.height()));
+}
+
+
+void CodeEditor::paintGutter(QPaintEvent *event)
+{
+    QPainter painter(gutter);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.fillRect(event->rect(), QColor(240, 240, 240));
+
+    int marker = foldMarkerWidth();
+    int numberWidth = gutter->width() - marker - 4;
+    int lineHeight = fontMetrics().height();
+    int currentLine = textCursor().blockNumber();
+
+    // Рисуются только видимые строки, поэтому цена кадра не зависит от длины
+    // файла: номер строки и парная '}' берутся из индексов за O(log n).
+    QTextBlock block = firstVisibleBlock();
+    int top = qRound(blockBoundingGeometry(block).translated(contentOffset()).top());
+    while (block.isValid() && top <= event->rect().bottom()) {
+        int bottom = top + qRound(blockBoundingRect(block).height());
+        if (block.isVisible() && bottom >= event->rect().top()) {
+            int line = block.blockNumber();
+            painter.setPen(line == currentLine ? QColor(40, 40, 40) : QColor(150, 150, 150));
+            painter.drawText(0, top, numberWidth, lineHeight, Qt::AlignRight, QString::number(line + 1));
+
+            CodeBlockData *data = CodeBlockData::of(block);
+            bool folded = data && data->folded;
+            if (folded || nestingIndex.foldEnd(line) > line + 1) {
+                QRectF box(numberWidth + 4 + marker * 0.3, top + lineHeight * 0.5 - marker * 0.2,
+                           marker * 0.4, marker * 0.4);
+                QPolygonF triangle;
+                if (folded)
+                    triangle << box.topLeft() << box.bottomLeft() << QPointF(box.right(), box.center().y());
+                else
+                    triangle << box.topLeft() << box.topRight() << QPointF(box.center().x(), box.bottom());
+                painter.setPen(Qt::NoPen);
+                painter.setBrush(folded ? QColor(60, 60, 60) : QColor(150, 150, 150));
+                painter.drawPolygon(triangle);
+            }
+        }
+        block = block.next();
+        top = bottom;
+    }
+}
+
+
+void CodeEditor::gutterClicked(const QPoint &position)
+{
+    if (position.x() < gutter->width() - foldMarkerWidth())
+        return;
+    toggleFold(cursorForPosition(QPoint(0, position.y())).block());
+}
+
+
+bool CodeEditor::event(QEvent *event)
+{
+    if (event->type() == QEvent::ToolTip) {
+        auto *helpEvent = static_cast<QHelpEvent *>(event);
+        int position = cursorForPosition(helpEvent->pos()).position();
+
+        QStringList messages;
+        for (const QList<LayerMark> &layerMarks : std::as_const(marks)) {
+            for (const LayerMark &mark : layerMarks) {
+                const QTextCursor &cursor = mark.selection.cursor;
+                if (!mark.message.isEmpty() && position >= cursor.selectionStart() && position < cursor.selectionEnd())
+                    messages << mark.message;
+            }
+        }
+
+        if (messages.isEmpty())
+            QToolTip::hideText();
+        else
+            QToolTip::showText(helpEvent->globalPos(), messages.join('\n'), this);
+        return true;
+    }
+
+    return QPlainTextEdit::event(event);
+}
+
+
+void CodeEditor::keyPressEvent(QKeyEvent *event)
+{
+    if (completer->popup()->isVisible()) {
+        // Эти клавиши выбирают вариант или закрывают список; их обрабатывает
+        // QCompleter.
+        switch (event->key()) {
+        case Qt::Key_Enter:
+        case Qt::Key_Return:
+        case Qt::Key_Tab:
+        case Qt::Key_Backtab:
+        case Qt::Key_Escape:
+            event->ignore();
+            return;
+        default:
+            break;
+        }
+    }
+
+    bool forced = event->key() == Qt::Key_Space && (event->modifiers() & Qt::ControlModifier);
+    if (!forced)
+        typeKey(event);
+    updateCompletion(event, forced);
+}
+
+
+QString CodeEditor::wordBeforeCursor() const
+{
+    QTextCursor cursor = textCursor();
+    QString text = cursor.block().text().left(cursor.positionInBlock());
+    int start = text.size();
+    while (start > 0 && isWordChar(text.at(start - 1)))
+        --start;
+    return text.mid(start);
+}
+
+
+void CodeEditor::updateCompletion(QKeyEvent *event, bool forced)
+{
+    QAbstractItemView *popup = completer->popup();
+    QString typed = event->text();
+    bool wordKey = !typed.isEmpty() && isWordChar(typed.back());
+    bool erasing = event->key() == Qt::Key_Backspace && popup->isVisible();
+    QString prefix = wordBeforeCursor();
+
+    if ((!forced && !wordKey && !erasing) || prefix.size() < (forced ? 1 : MinCompletionPrefix)
+        || prefix.at(0).isDigit()) {
+        popup->hide();
+        return;
+    }
+
+    // Поиск идёт по последнему готовому снимку индекса и не ждёт фоновый
+    // поток, даже если тот ещё разбирает недавнюю правку.
+    const QStringList candidates = symbolIndex->complete(prefix, MaxCompletions);
+    if (candidates.isEmpty()) {
+        popup->hide();
+        return;
+    }
+
+    completionModel->setStringList(candidates);
+    completer->setCompletionPrefix(prefix);
+    popup->setCurrentIndex(completer->completionModel()->index(0, 0));
+
+    QRect rect = cursorRect();
+    rect.setWidth(popup->sizeHintForColumn(0) + popup->verticalScrollBar()->sizeHint().width());
+    completer->complete(rect);
+}
+
+
+void CodeEditor::insertCompletion(const QString &completion)
+{
+    QTextCursor cursor = textCursor();
+    cursor.insertText(completion.mid(completer->completionPrefix().size()));
+    setTextCursor(cursor);
+}
+
+
+void CodeEditor::typeKey(QKeyEvent *event)
+{
     QTextCursor cursor = textCursor();
 
     if (event->key() == Qt::Key_ParenLeft) { // (
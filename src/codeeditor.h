@@ -2,16 +2,85 @@
 #define CODEEDITOR_H
 
 #include <QPlainTextEdit>
+#include <QMap>
+#include "nestingindex.h"
+
+class CppHighlighter;
+class SymbolIndex;
+class QCompleter;
+class QStringListModel;
+class CodeGutter;
 
 class CodeEditor : public QPlainTextEdit
 {
     Q_OBJECT
 
 public:
+    // Слои подсветки независимы: обновление одного не сбрасывает другие.
+    enum class MarkLayer { Forbidden, Errors, Warnings };
+
+    struct Mark
+    {
+        int position;
+        int length;
+        QString message;
+    };
+
     explicit CodeEditor(QWidget *parent = nullptr);
 
+    void setMarks(MarkLayer layer, const QList<Mark> &marks);
+    void clearMarks(MarkLayer layer);
+
+    CppHighlighter *highlighter() const { return syntaxHighlighter; }
+    SymbolIndex *symbols() const { return symbolIndex; }
+    const NestingIndex &nesting() const { return nestingIndex; }
+
+    // Сворачивает строки внутри '{}', которая открывается в block, или
+    // разворачивает их, если они уже свёрнуты.
+    void toggleFold(const QTextBlock &block);
+
 protected:
+    bool event(QEvent *event) override;
     void keyPressEvent(QKeyEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+
+private:
+    friend class CodeGutter;
+
+    struct LayerMark
+    {
+        QTextEdit::ExtraSelection selection;
+        QString message;
+    };
+
+    QTextCharFormat markFormat(MarkLayer layer) const;
+    void updateExtraSelections();
+    void typeKey(QKeyEvent *event);
+    QString wordBeforeCursor() const;
+    void updateCompletion(QKeyEvent *event, bool forced);
+    void insertCompletion(const QString &completion);
+    void onContentsChange(int position, int charsRemoved, int charsAdded);
+    void unfold(const QTextBlock &block, int lastEdited = -1);
+    QTextBlock foldHeader(const QTextBlock &block) const;
+    void recountFolds();
+    void relayout(const QTextBlock &first, const QTextBlock &last);
+    void matchBrackets();
+    int gutterWidth() const;
+    int foldMarkerWidth() const;
+    void updateGutter(const QRect &rect, int dy);
+    void paintGutter(QPaintEvent *event);
+    void gutterClicked(const QPoint &position);
+
+    QMap<MarkLayer, QList<LayerMark>> marks;
+    QList<QTextEdit::ExtraSelection> bracketSelections;
+    NestingIndex nestingIndex;
+    int indexedBlockCount = 0;
+    int foldedCount = 0;
+    CodeGutter *gutter;
+    CppHighlighter *syntaxHighlighter;
+    SymbolIndex *symbolIndex;
+    QCompleter *completer;
+    QStringListModel *completionModel;
 };
 
 #endif // CODEEDITOR_H
@@ -0,0 +1,170 @@
+#include "compilecache.h"
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QRegularExpression>
+#include <QSet>
+#include <QStandardPaths>
+#include <algorithm>
+
+namespace {
+
+// Добавляет к хешу содержимое заголовков #include "..." из text, включая
+// их собственные локальные заголовки. Ищутся они, как и компилятором в
+// первую очередь, рядом с включающим файлом.
+bool hashLocalIncludes(QCryptographicHash &hash, const QByteArray &text, const QDir &dir, QSet<QString> &seen)
+{
+    static const QRegularExpression includePattern(R"re(^\s*#\s*include\s*"([^"]+)")re",
+                                                   QRegularExpression::MultilineOption);
+
+    QRegularExpressionMatchIterator it = includePattern.globalMatch(QString::fromUtf8(text));
+    while (it.hasNext()) {
+        QString name = it.next().captured(1);
+        QString path = QFileInfo(dir.filePath(name)).canonicalFilePath();
+        if (path.isEmpty())
+            return false;
+        if (seen.contains(path))
+            continue;
+        seen.insert(path);
+
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly))
+            return false;
+        QByteArray header = file.readAll();
+        hash.addData(QByteArray(1, '\0'));
+        hash.addData(name.toUtf8());
+        hash.addData(QByteArray(1, '\0'));
+        hash.addData(header);
+        if (!hashLocalIncludes(hash, header, QFileInfo(path).dir(), seen))
+            return false;
+    }
+    return true;
+}
+
+}
+
+CompileCache::CompileCache(const QString &directory, qint64 maxBytes)
+    : cacheDir(directory),
+      limitBytes(maxBytes)
+{
+    QDir dir(cacheDir);
+    if (!dir.exists())
+        dir.mkpath(".");
+
+    const QFileInfoList entries = dir.entryInfoList(QStringList() << "*.bin", QDir::Files);
+    for (const QFileInfo &entry : entries)
+        totalBytes += entry.size();
+}
+
+
+QString CompileCache::key(const QByteArray &source, const QString &sourcePath, const QString &compiler,
+                          const QStringList &flags)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    hash.addData(compilerIdentity(compiler).toUtf8());
+    hash.addData(QByteArray(1, '\0'));
+    hash.addData(flags.join('\x1f').toUtf8());
+    hash.addData(QByteArray(1, '\0'));
+    hash.addData(source);
+
+    QSet<QString> seen;
+    if (!hashLocalIncludes(hash, source, QFileInfo(sourcePath).absoluteDir(), seen))
+        return QString();
+    return QString::fromLatin1(hash.result().toHex());
+}
+
+
+bool CompileCache::fetch(const QString &key, const QString &destination)
+{
+    QString path = entryPath(key);
+    if (!QFile::exists(path)) {
+        ++missCount;
+        return false;
+    }
+
+    QFile::remove(destination);
+    if (!QFile::copy(path, destination)) {
+        ++missCount;
+        return false;
+    }
+
+    QFile entry(path);
+    if (entry.open(QIODevice::ReadWrite))
+        entry.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+
+    ++hitCount;
+    return true;
+}
+
+
+void CompileCache::store(const QString &key, const QString &executable)
+{
+    QString path = entryPath(key);
+    QString tempPath = path + ".tmp";
+
+    QFile::remove(tempPath);
+    if (!QFile::copy(executable, tempPath))
+        return;
+
+    qint64 oldSize = QFileInfo(path).exists() ? QFileInfo(path).size() : 0;
+    QFile::remove(path);
+    if (!QFile::rename(tempPath, path)) {
+        QFile::remove(tempPath);
+        totalBytes -= oldSize;
+        return;
+    }
+
+    totalBytes += QFileInfo(path).size() - oldSize;
+    evict();
+}
+
+
+QString CompileCache::entryPath(const QString &key) const
+{
+    return QDir(cacheDir).filePath(key + ".bin");
+}
+
+
+QString CompileCache::compilerIdentity(const QString &compiler)
+{
+    auto it = compilerIds.constFind(compiler);
+    if (it != compilerIds.constEnd())
+        return it.value();
+
+    // Путь, размер и время изменения исполняемого файла компилятора меняются
+    // при его обновлении, а запускать «g++ --version» на каждый ключ слишком дорого.
+    QString path = QStandardPaths::findExecutable(compiler);
+    QFileInfo info(path.isEmpty() ? compiler : path);
+    QString identity = QString("%1|%2|%3")
+                           .arg(info.absoluteFilePath())
+                           .arg(info.size())
+                           .arg(info.lastModified().toMSecsSinceEpoch());
+
+    compilerIds.insert(compiler, identity);
+    return identity;
+}
+
+
+void CompileCache::evict()
+{
+    if (totalBytes <= limitBytes)
+        return;
+
+    QFileInfoList entries = QDir(cacheDir).entryInfoList(QStringList() << "*.bin", QDir::Files);
+    std::sort(entries.begin(), entries.end(), [](const QFileInfo &a, const QFileInfo &b) {
+        return a.lastModified() < b.lastModified();
+    });
+
+    totalBytes = 0;
+    for (const QFileInfo &entry : std::as_const(entries))
+        totalBytes += entry.size();
+
+    for (const QFileInfo &entry : std::as_const(entries)) {
+        if (totalBytes <= limitBytes)
+            break;
+        if (QFile::remove(entry.absoluteFilePath()))
+            totalBytes -= entry.size();
+    }
+}
@@ -0,0 +1,44 @@
+#ifndef COMPILECACHE_H
+#define COMPILECACHE_H
+
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QHash>
+
+// Кэш исполняемых файлов, адресуемый по содержимому: ключ — хеш исходного
+// текста, локальных заголовков #include "...", компилятора и флагов. Размер
+// ограничен, вытесняются давно не использовавшиеся записи (время изменения
+// файла служит меткой LRU).
+class CompileCache
+{
+public:
+    explicit CompileCache(const QString &directory, qint64 maxBytes = 512ll * 1024 * 1024);
+
+    QString directory() const { return cacheDir; }
+    qint64 maxBytes() const { return limitBytes; }
+    qint64 sizeBytes() const { return totalBytes; }
+    int hits() const { return hitCount; }
+    int misses() const { return missCount; }
+
+    // Пустой ключ — программу кэшировать нельзя: локальный заголовок не
+    // найден рядом с включающим его файлом (например, лежит в каталоге из -I).
+    QString key(const QByteArray &source, const QString &sourcePath, const QString &compiler,
+                const QStringList &flags);
+    bool fetch(const QString &key, const QString &destination);
+    void store(const QString &key, const QString &executable);
+
+private:
+    QString entryPath(const QString &key) const;
+    QString compilerIdentity(const QString &compiler);
+    void evict();
+
+    QString cacheDir;
+    qint64 limitBytes;
+    qint64 totalBytes = 0;
+    int hitCount = 0;
+    int missCount = 0;
+    QHash<QString, QString> compilerIds;
+};
+
+#endif // COMPILECACHE_H
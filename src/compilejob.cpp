@@ -0,0 +1,222 @@
+#include "compilejob.h"
+#include "compilecache.h"
+#include "pchmanager.h"
+#include "stagetrace.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QRegularExpression>
+
+int CompileJob::nextId = 1;
+
+CompileJob::CompileJob(const QString &sourceFile, const QString &executableFile, QObject *parent)
+    : QObject(parent),
+      jobId(nextId++),
+      source(sourceFile),
+      executable(executableFile),
+      process(new QProcess(this))
+{
+    process->setWorkingDirectory(QFileInfo(sourceFile).path());
+
+    connect(process, &QProcess::readyReadStandardError, this, &CompileJob::onReadyReadStandardError);
+    connect(process, &QProcess::finished, this, &CompileJob::onProcessFinished);
+    connect(process, &QProcess::errorOccurred, this, &CompileJob::onProcessError);
+}
+
+
+void CompileJob::start()
+{
+    if (currentStatus != Status::Pending)
+        return;
+
+    // Старый исполняемый файл мешает понять, создал ли его компилятор.
+    QFile::remove(executable);
+
+    currentStatus = Status::Running;
+    timer.start();
+    startUs = StageTrace::nowUs();
+    emit started();
+
+    QByteArray sourceText;
+    QFile sourceFile(source);
+    if (sourceFile.open(QIODevice::ReadOnly))
+        sourceText = sourceFile.readAll();
+
+    if (cache && sourceFile.isOpen()) {
+        cacheKey = cache->key(sourceText, source, compilerPath, extraFlags);
+        if (!cacheKey.isEmpty() && cache->fetch(cacheKey, executable)) {
+            cacheHit = true;
+            QMetaObject::invokeMethod(this, [this] {
+                finish(cancelRequested ? Status::Cancelled : Status::Succeeded);
+            }, Qt::QueuedConnection);
+            return;
+        }
+    }
+
+    if (pch) {
+        QStringList includes = PchManager::standardIncludes(sourceText);
+        if (!includes.isEmpty()) {
+            pchHeader = pch->prepareHeader(includes, compilerPath, extraFlags);
+            usingPch = pch->isReady(pchHeader);
+            if (!usingPch)
+                pch->build(pchHeader, compilerPath, extraFlags);
+        }
+    }
+
+    startCompiler();
+}
+
+
+void CompileJob::startCompiler()
+{
+    QStringList arguments = extraFlags;
+    if (usingPch)
+        arguments << "-Winvalid-pch" << "-include" << pchHeader;
+    // -time понимает только драйвер GCC; clang с ним не запустится.
+    bool gccDriver = QFileInfo(compilerPath).fileName().contains("g++")
+                     || QFileInfo(compilerPath).fileName().contains("gcc");
+    if (timeReport && gccDriver)
+        arguments << "-time";
+    arguments << source << "-o" << executable;
+
+    attemptStderr.clear();
+    partialLine.clear();
+    tools.clear();
+    attemptTimer.start();
+    compilerStartUs = StageTrace::nowUs();
+    process->start(compilerPath, arguments);
+}
+
+
+void CompileJob::cancel()
+{
+    if (!isActive())
+        return;
+
+    cancelRequested = true;
+    if (process->state() == QProcess::NotRunning) {
+        finish(Status::Cancelled);
+        return;
+    }
+
+    process->kill();
+}
+
+
+void CompileJob::onReadyReadStandardError()
+{
+    QString text = QString::fromLocal8Bit(process->readAllStandardError());
+    if (timeReport)
+        text = takeTimeReport(text, process->state() == QProcess::NotRunning);
+    if (text.isEmpty())
+        return;
+
+    stderrText += text;
+    attemptStderr += text;
+    emit errorOutputReceived(text);
+}
+
+
+QString CompileJob::takeTimeReport(const QString &text, bool flush)
+{
+    // Строки вида "# cc1plus 0.42 0.03" (user и sys в секундах) вырезаются
+    // из вывода компилятора; незавершённая строка ждёт следующего фрагмента.
+    static const QRegularExpression reportLine(R"(^# (\S+) (\d+\.\d+) (\d+\.\d+)$)");
+
+    QString pending = partialLine + text;
+    partialLine.clear();
+    int lastNewline = pending.lastIndexOf('\n');
+    if (!flush) {
+        partialLine = pending.mid(lastNewline + 1);
+        pending.truncate(lastNewline + 1);
+    }
+
+    QString kept;
+    const QStringList lines = pending.split('\n');
+    for (int i = 0; i < lines.size(); ++i) {
+        QRegularExpressionMatch match = reportLine.match(lines.at(i).trimmed());
+        if (match.hasMatch()) {
+            qint64 cpuUs = qint64((match.captured(2).toDouble() + match.captured(3).toDouble()) * 1e6);
+            tools.append({match.captured(1), cpuUs});
+            continue;
+        }
+        kept += lines.at(i);
+        if (i + 1 < lines.size())
+            kept += '\n';
+    }
+    return kept;
+}
+
+
+void CompileJob::onProcessFinished(int exitCode, QProcess::ExitStatus exitStatus)
+{
+    compilerEndUs = StageTrace::nowUs();
+    onReadyReadStandardError();
+
+    if (cancelRequested) {
+        finish(Status::Cancelled);
+        return;
+    }
+
+    bool ok = exitStatus == QProcess::NormalExit && exitCode == 0 && QFile::exists(executable);
+    compileMs = attemptTimer.elapsed();
+
+    // Испорченный или устаревший .gch: удаляем его и, если сборка упала,
+    // повторяем её без PCH. Свежий заголовок соберёт следующий запуск.
+    if (usingPch && (attemptStderr.contains(".gch") || attemptStderr.contains("PCH"))) {
+        pch->invalidate(pchHeader);
+        usingPch = false;
+        if (!ok) {
+            QString text = "Предкомпилированный заголовок недействителен, повторная компиляция без него.\n";
+            stderrText += text;
+            emit errorOutputReceived(text);
+            startCompiler();
+            return;
+        }
+    }
+
+    if (ok && !usingPch && pch && !pchHeader.isEmpty())
+        pch->recordPlainCompile(pchHeader, compileMs);
+
+    if (ok && cache && !cacheKey.isEmpty())
+        cache->store(cacheKey, executable);
+
+    finish(ok ? Status::Succeeded : Status::Failed);
+}
+
+
+void CompileJob::onProcessError(QProcess::ProcessError error)
+{
+    if (error != QProcess::FailedToStart)
+        return;
+
+    QString text = "Не удалось запустить компилятор " + compilerPath + ": " + process->errorString() + "\n";
+    stderrText += text;
+    emit errorOutputReceived(text);
+    finish(cancelRequested ? Status::Cancelled : Status::Failed);
+}
+
+
+qint64 CompileJob::pchSavedMs() const
+{
+    if (!usingPch || compileMs < 0)
+        return -1;
+
+    // Без замера компиляции без PCH экономия неизвестна.
+    qint64 plainMs = pch->plainCompileMs(pchHeader);
+    if (plainMs < 0)
+        return -1;
+    return qMax<qint64>(0, plainMs - compileMs);
+}
+
+
+void CompileJob::finish(Status status)
+{
+    if (!isActive())
+        return;
+    if (timer.isValid())
+        elapsed = timer.elapsed();
+    finishUs = StageTrace::nowUs();
+
+    currentStatus = status;
+    emit finished(status);
+}
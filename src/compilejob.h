@@ -0,0 +1,104 @@
+#ifndef COMPILEJOB_H
+#define COMPILEJOB_H
+
+#include <QObject>
+#include <QProcess>
+#include <QElapsedTimer>
+#include <QStringList>
+#include <QList>
+
+class CompileCache;
+class PchManager;
+
+class CompileJob : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum class Status { Pending, Running, Succeeded, Failed, Cancelled };
+
+    // Процессорное время подпроцесса GCC (cc1plus, as, collect2) из отчёта -time.
+    struct ToolTime
+    {
+        QString tool;
+        qint64 cpuUs;
+    };
+
+    CompileJob(const QString &sourceFile, const QString &executableFile, QObject *parent = nullptr);
+
+    int id() const { return jobId; }
+    QString sourceFile() const { return source; }
+    QString executableFile() const { return executable; }
+    Status status() const { return currentStatus; }
+    bool isActive() const { return currentStatus == Status::Pending || currentStatus == Status::Running; }
+    QString errorOutput() const { return stderrText; }
+    qint64 elapsedMs() const { return elapsed; }
+    bool isFromCache() const { return cacheHit; }
+    bool usedPch() const { return usingPch; }
+    qint64 compileTimeMs() const { return compileMs; }
+    // Сколько сэкономил PCH по сравнению с замером без него; -1 — неизвестно.
+    qint64 pchSavedMs() const;
+    // Метки времени по часам StageTrace::nowUs(); у компилятора — последняя попытка.
+    qint64 startedAtUs() const { return startUs; }
+    qint64 compilerStartedAtUs() const { return compilerStartUs; }
+    qint64 compilerFinishedAtUs() const { return compilerEndUs; }
+    qint64 finishedAtUs() const { return finishUs; }
+    QList<ToolTime> toolTimes() const { return tools; }
+
+    void setCompiler(const QString &compiler) { compilerPath = compiler; }
+    void setFlags(const QStringList &flags) { extraFlags = flags; }
+    void setCache(CompileCache *compileCache) { cache = compileCache; }
+    void setPchManager(PchManager *manager) { pch = manager; }
+    void setTimeReport(bool enabled) { timeReport = enabled; }
+
+public slots:
+    void start();
+    void cancel();
+
+signals:
+    void started();
+    void errorOutputReceived(const QString &text);
+    void finished(CompileJob::Status status);
+
+private slots:
+    void onReadyReadStandardError();
+    void onProcessFinished(int exitCode, QProcess::ExitStatus exitStatus);
+    void onProcessError(QProcess::ProcessError error);
+
+private:
+    void startCompiler();
+    QString takeTimeReport(const QString &text, bool flush);
+    void finish(Status status);
+
+    static int nextId;
+
+    int jobId;
+    QString source;
+    QString executable;
+    QString compilerPath = "g++";
+    QStringList extraFlags;
+    CompileCache *cache = nullptr;
+    QString cacheKey;
+    bool cacheHit = false;
+    PchManager *pch = nullptr;
+    QString pchHeader;
+    bool usingPch = false;
+    Status currentStatus = Status::Pending;
+    bool cancelRequested = false;
+    QString stderrText;
+    QString attemptStderr;
+    QProcess *process;
+    QElapsedTimer timer;
+    QElapsedTimer attemptTimer;
+    qint64 elapsed = 0;
+    qint64 compileMs = -1;
+    bool timeReport = false;
+    QString partialLine;
+    QList<ToolTime> tools;
+    qint64 startUs = 0;
+    qint64 compilerStartUs = 0;
+    qint64 compilerEndUs = 0;
+    qint64 finishUs = 0;
+};
+
+#endif // COMPILEJOB_H
@@ -0,0 +1,148 @@
+#include "cpphighlighter.h"
+#include "codeblockdata.h"
+#include <QLoggingCategory>
+#include <QTextDocument>
+#include <QTextLayout>
+#include <QTimer>
+
+// Время каждого прохода: QT_LOGGING_RULES="editor.highlight.debug=true".
+Q_LOGGING_CATEGORY(highlightLog, "editor.highlight", QtWarningMsg)
+
+CppHighlighter::CppHighlighter(QTextDocument *document, int budgetMs)
+    : QSyntaxHighlighter(document),
+      budget(budgetMs),
+      resumeTimer(new QTimer(this))
+{
+    auto &keyword = formats[int(CppLexer::TokenKind::Keyword)];
+    keyword.setForeground(QColor(0, 0, 160));
+    keyword.setFontWeight(QFont::Bold);
+
+    auto &comment = formats[int(CppLexer::TokenKind::Comment)];
+    comment.setForeground(QColor(0, 128, 0));
+    comment.setFontItalic(true);
+
+    formats[int(CppLexer::TokenKind::String)].setForeground(QColor(163, 21, 21));
+    formats[int(CppLexer::TokenKind::Char)].setForeground(QColor(163, 21, 21));
+    formats[int(CppLexer::TokenKind::HeaderName)].setForeground(QColor(163, 21, 21));
+    formats[int(CppLexer::TokenKind::Number)].setForeground(QColor(9, 134, 88));
+    formats[int(CppLexer::TokenKind::Directive)].setForeground(QColor(128, 0, 128));
+
+    resumeTimer->setSingleShot(true);
+    resumeTimer->setInterval(0);
+    connect(resumeTimer, &QTimer::timeout, this, &CppHighlighter::resumeDeferred);
+}
+
+
+void CppHighlighter::highlightBlock(const QString &text)
+{
+    if (!passActive)
+        startPass();
+
+    QTextBlock block = currentBlock();
+    if (passTimer.elapsed() >= budget) {
+        // Без setFormat QSyntaxHighlighter стёр бы форматы строки, и до
+        // перекраски она мигала бы без подсветки, поэтому прежние форматы
+        // ставятся заново. userState не меняется, поэтому перекраска не
+        // пойдёт дальше этой строки.
+        const QList<QTextLayout::FormatRange> previous = block.layout()->formats();
+        for (const QTextLayout::FormatRange &range : previous)
+            setFormat(range.start, range.length, range.format);
+        defer(block.blockNumber());
+        return;
+    }
+    ++passBlocks;
+
+    CppLexer::State state;
+    if (CodeBlockData *previous = CodeBlockData::of(block.previous()))
+        state = previous->lexState;
+
+    tokens.clear();
+    CppLexer::tokenizeLine(text, state, tokens);
+    for (const CppLexer::Token &token : std::as_const(tokens)) {
+        const QTextCharFormat &format = formats[int(token.kind)];
+        if (!format.properties().isEmpty())
+            setFormat(token.start, token.length, format);
+    }
+
+    CodeBlockData *data = CodeBlockData::of(block);
+    if (!data) {
+        data = new CodeBlockData;
+        setCurrentBlockUserData(data);
+    }
+    data->lexState = state;
+    data->highlightPass = passId;
+    setCurrentBlockState(encodeState(state));
+}
+
+
+void CppHighlighter::startPass()
+{
+    passActive = true;
+    ++passId;
+    passBlocks = 0;
+    passTimer.start();
+    QMetaObject::invokeMethod(this, &CppHighlighter::finishPass, Qt::QueuedConnection);
+}
+
+
+void CppHighlighter::finishPass()
+{
+    if (!passActive)
+        return;
+
+    passActive = false;
+    lastUs = passTimer.nsecsElapsed() / 1000;
+    lastBlocks = passBlocks;
+    maxUs = qMax(maxUs, lastUs);
+
+    qCDebug(highlightLog, "pass %d: %d blocks in %lld us%s", passId, lastBlocks, lastUs,
+            hasDeferredBlocks() ? ", rest deferred" : "");
+    emit passFinished(lastBlocks, lastUs, hasDeferredBlocks());
+}
+
+
+void CppHighlighter::defer(int blockNumber)
+{
+    if (deferredFirst < 0 || blockNumber < deferredFirst)
+        deferredFirst = blockNumber;
+    deferredLast = qMax(deferredLast, blockNumber);
+    resumeTimer->start();
+}
+
+
+void CppHighlighter::resumeDeferred()
+{
+    finishPass();
+
+    int first = deferredFirst;
+    int last = qMin(deferredLast, document()->blockCount() - 1);
+    deferredFirst = deferredLast = -1;
+
+    // rehighlightBlock() сам идёт дальше, пока меняется состояние; строки,
+    // уже окрашенные в этом проходе, пропускаются.
+    for (QTextBlock block = document()->findBlockByNumber(first);
+         block.isValid() && block.blockNumber() <= last; block = block.next()) {
+        CodeBlockData *data = CodeBlockData::of(block);
+        if (passActive && data && data->highlightPass == passId)
+            continue;
+
+        rehighlightBlock(block);
+        if (hasDeferredBlocks()) {
+            deferredLast = qMax(deferredLast, last);
+            return;
+        }
+    }
+}
+
+
+int CppHighlighter::encodeState(const CppLexer::State &state)
+{
+    int delimiterId = 0;
+    if (state.mode == CppLexer::State::RawString) {
+        auto it = rawDelimiterIds.constFind(state.rawDelimiter);
+        if (it == rawDelimiterIds.constEnd())
+            it = rawDelimiterIds.insert(state.rawDelimiter, rawDelimiterIds.size() + 1);
+        delimiterId = it.value();
+    }
+    return int(state.mode) | (delimiterId << 3);
+}
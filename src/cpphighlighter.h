@@ -0,0 +1,64 @@
+#ifndef CPPHIGHLIGHTER_H
+#define CPPHIGHLIGHTER_H
+
+#include <QSyntaxHighlighter>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QTextCharFormat>
+#include "cpplexer.h"
+
+class QTimer;
+
+// Подсветка C++ поверх CppLexer. Состояние лексера на конце строки хранится
+// в CodeBlockData, а в userState блока — его числовой код, поэтому после
+// правки QSyntaxHighlighter перекрашивает только строки, у которых
+// изменилось входное состояние.
+//
+// Один проход подсветки ограничен budgetMs: когда время вышло, оставшиеся
+// строки откладываются и докрашиваются следующими проходами из цикла
+// событий, так что ввод не ждёт перекраски всего файла.
+class CppHighlighter : public QSyntaxHighlighter
+{
+    Q_OBJECT
+
+public:
+    explicit CppHighlighter(QTextDocument *document, int budgetMs = 8);
+
+    int budgetMs() const { return budget; }
+    qint64 lastPassUs() const { return lastUs; }
+    qint64 maxPassUs() const { return maxUs; }
+    int lastPassBlocks() const { return lastBlocks; }
+    bool hasDeferredBlocks() const { return deferredFirst >= 0; }
+
+signals:
+    void passFinished(int blocks, qint64 microseconds, bool deferred);
+
+protected:
+    void highlightBlock(const QString &text) override;
+
+private:
+    void startPass();
+    void finishPass();
+    void defer(int blockNumber);
+    void resumeDeferred();
+    int encodeState(const CppLexer::State &state);
+
+    QTextCharFormat formats[int(CppLexer::TokenKind::Punctuation) + 1];
+    QList<CppLexer::Token> tokens;
+    QHash<QString, int> rawDelimiterIds;
+
+    int budget;
+    QElapsedTimer passTimer;
+    bool passActive = false;
+    int passId = 0;
+    int passBlocks = 0;
+    int deferredFirst = -1;
+    int deferredLast = -1;
+    QTimer *resumeTimer;
+
+    qint64 lastUs = 0;
+    qint64 maxUs = 0;
+    int lastBlocks = 0;
+};
+
+#endif // CPPHIGHLIGHTER_H
@@ -0,0 +1,288 @@
+#include "cpplexer.h"
+#include <algorithm>
+#include <iterator>
+
+namespace {
+
+// Отсортированы для двоичного поиска.
+const QStringView Keywords[] = {
+    u"alignas", u"alignof", u"and", u"and_eq", u"asm", u"auto", u"bitand", u"bitor", u"bool", u"break",
+    u"case", u"catch", u"char", u"char16_t", u"char32_t", u"char8_t", u"class", u"co_await", u"co_return",
+    u"co_yield", u"compl", u"concept", u"const", u"const_cast", u"consteval", u"constexpr", u"constinit",
+    u"continue", u"decltype", u"default", u"delete", u"do", u"double", u"dynamic_cast", u"else", u"enum",
+    u"explicit", u"export", u"extern", u"false", u"float", u"for", u"friend", u"goto", u"if", u"inline",
+    u"int", u"long", u"mutable", u"namespace", u"new", u"noexcept", u"not", u"not_eq", u"nullptr",
+    u"operator", u"or", u"or_eq", u"private", u"protected", u"public", u"register", u"reinterpret_cast",
+    u"requires", u"return", u"short", u"signed", u"sizeof", u"static", u"static_assert", u"static_cast",
+    u"struct", u"switch", u"template", u"this", u"thread_local", u"throw", u"true", u"try", u"typedef",
+    u"typeid", u"typename", u"union", u"unsigned", u"using", u"virtual", u"void", u"volatile", u"wchar_t",
+    u"while", u"xor", u"xor_eq"
+};
+
+const QStringView LongPunctuation[] = {
+    u"<=>", u"<<=", u">>=", u"...", u"->*",
+    u"::", u"->", u"++", u"--", u"<<", u">>", u"<=", u">=", u"==", u"!=", u"&&", u"||",
+    u"+=", u"-=", u"*=", u"/=", u"%=", u"&=", u"|=", u"^=", u".*", u"##"
+};
+
+bool isIdentifierStart(QChar c)
+{
+    return c.isLetter() || c == '_';
+}
+
+
+bool isIdentifierChar(QChar c)
+{
+    return c.isLetterOrNumber() || c == '_';
+}
+
+
+bool isStringPrefix(QStringView word)
+{
+    return word == u"u8" || word == u"u" || word == u"U" || word == u"L";
+}
+
+
+bool isRawStringPrefix(QStringView word)
+{
+    return word == u"R" || word == u"u8R" || word == u"uR" || word == u"UR" || word == u"LR";
+}
+
+
+// Возвращает позицию за закрывающей кавычкой или конец строки; continued
+// выставляется, если литерал продолжен обратной косой чертой.
+int skipQuoted(QStringView line, int from, QChar quote, bool *continued)
+{
+    *continued = false;
+    int i = from;
+    while (i < line.size()) {
+        QChar c = line.at(i);
+        if (c == '\\') {
+            if (i + 1 >= line.size()) {
+                *continued = true;
+                return line.size();
+            }
+            i += 2;
+            continue;
+        }
+        ++i;
+        if (c == quote)
+            return i;
+    }
+    return line.size();
+}
+
+}
+
+
+bool CppLexer::isKeyword(QStringView word)
+{
+    return std::binary_search(std::begin(Keywords), std::end(Keywords), word);
+}
+
+
+void CppLexer::tokenizeLine(QStringView line, State &state, QList<Token> &tokens, int offset)
+{
+    const int n = line.size();
+    int i = 0;
+
+    auto add = [&tokens, offset](TokenKind kind, int start, int end) {
+        if (end > start)
+            tokens.append({kind, offset + start, end - start});
+    };
+
+    switch (state.mode) {
+    case State::Normal:
+        break;
+    case State::BlockComment: {
+        int end = line.indexOf(u"*/");
+        if (end < 0) {
+            add(TokenKind::Comment, 0, n);
+            return;
+        }
+        i = end + 2;
+        add(TokenKind::Comment, 0, i);
+        state = State();
+        break;
+    }
+    case State::RawString: {
+        QString close = ')' + state.rawDelimiter + '"';
+        int end = line.indexOf(close);
+        if (end < 0) {
+            add(TokenKind::String, 0, n);
+            return;
+        }
+        i = end + close.size();
+        add(TokenKind::String, 0, i);
+        state = State();
+        break;
+    }
+    case State::StringContinuation: {
+        bool continued = false;
+        i = skipQuoted(line, 0, '"', &continued);
+        add(TokenKind::String, 0, i);
+        if (continued)
+            return;
+        state = State();
+        break;
+    }
+    case State::LineCommentContinuation:
+        add(TokenKind::Comment, 0, n);
+        if (!line.endsWith('\\'))
+            state = State();
+        return;
+    }
+
+    bool atLineStart = i == 0;
+
+    while (i < n) {
+        QChar c = line.at(i);
+        QChar next = i + 1 < n ? line.at(i + 1) : QChar();
+
+        if (c.isSpace()) {
+            ++i;
+            continue;
+        }
+
+        if (c == '/' && next == '/') {
+            add(TokenKind::Comment, i, n);
+            if (line.endsWith('\\'))
+                state.mode = State::LineCommentContinuation;
+            return;
+        }
+
+        if (c == '/' && next == '*') {
+            int end = line.indexOf(u"*/", i + 2);
+            if (end < 0) {
+                add(TokenKind::Comment, i, n);
+                state.mode = State::BlockComment;
+                return;
+            }
+            add(TokenKind::Comment, i, end + 2);
+            i = end + 2;
+            continue;
+        }
+
+        if (c == '#' && atLineStart) {
+            atLineStart = false;
+            int j = i + 1;
+            while (j < n && line.at(j).isSpace())
+                ++j;
+            int nameStart = j;
+            while (j < n && isIdentifierChar(line.at(j)))
+                ++j;
+            add(TokenKind::Directive, i, j);
+
+            QStringView name = line.mid(nameStart, j - nameStart);
+            i = j;
+            if (name == u"include" || name == u"include_next" || name == u"import") {
+                while (i < n && line.at(i).isSpace())
+                    ++i;
+                if (i < n && (line.at(i) == '<' || line.at(i) == '"')) {
+                    QChar close = line.at(i) == '<' ? QChar('>') : QChar('"');
+                    int end = line.indexOf(close, i + 1);
+                    end = end < 0 ? n : end + 1;
+                    add(TokenKind::HeaderName, i, end);
+                    i = end;
+                }
+            }
+            continue;
+        }
+        atLineStart = false;
+
+        int literalStart = i;
+        if (isIdentifierStart(c)) {
+            int j = i;
+            while (j < n && isIdentifierChar(line.at(j)))
+                ++j;
+            QStringView word = line.mid(i, j - i);
+
+            if (j < n && line.at(j) == '"' && isRawStringPrefix(word)) {
+                int open = line.indexOf('(', j + 1);
+                if (open < 0) {
+                    add(TokenKind::String, i, n);
+                    return;
+                }
+                QString delimiter = line.mid(j + 1, open - j - 1).toString();
+                QString close = ')' + delimiter + '"';
+                int end = line.indexOf(close, open + 1);
+                if (end < 0) {
+                    add(TokenKind::String, i, n);
+                    state.mode = State::RawString;
+                    state.rawDelimiter = delimiter;
+                    return;
+                }
+                add(TokenKind::String, i, end + close.size());
+                i = end + close.size();
+                continue;
+            }
+
+            if (j < n && (line.at(j) == '"' || line.at(j) == '\'') && isStringPrefix(word)) {
+                i = j;
+                c = line.at(i);
+            } else {
+                add(isKeyword(word) ? TokenKind::Keyword : TokenKind::Identifier, i, j);
+                i = j;
+                continue;
+            }
+        }
+
+        if (c == '"' || c == '\'') {
+            bool continued = false;
+            int end = skipQuoted(line, i + 1, c, &continued);
+            add(c == '"' ? TokenKind::String : TokenKind::Char, literalStart, end);
+            if (continued && c == '"')
+                state.mode = State::StringContinuation;
+            i = end;
+            continue;
+        }
+
+        if (c.isDigit() || (c == '.' && next.isDigit())) {
+            int j = i + 1;
+            while (j < n) {
+                QChar d = line.at(j);
+                QChar prev = line.at(j - 1);
+                bool exponentSign = (d == '+' || d == '-')
+                                    && (prev == 'e' || prev == 'E' || prev == 'p' || prev == 'P');
+                bool separator = d == '\'' && j + 1 < n && line.at(j + 1).isLetterOrNumber();
+                if (!isIdentifierChar(d) && d != '.' && !exponentSign && !separator)
+                    break;
+                ++j;
+            }
+            add(TokenKind::Number, i, j);
+            i = j;
+            continue;
+        }
+
+        int length = 1;
+        for (QStringView punctuation : LongPunctuation) {
+            if (line.mid(i).startsWith(punctuation)) {
+                length = punctuation.size();
+                break;
+            }
+        }
+        add(TokenKind::Punctuation, i, i + length);
+        i += length;
+    }
+}
+
+
+QList<CppLexer::Token> CppLexer::tokenize(QStringView text)
+{
+    QList<Token> tokens;
+    State state;
+    int lineStart = 0;
+    while (lineStart <= text.size()) {
+        int lineEnd = text.indexOf('\n', lineStart);
+        if (lineEnd < 0)
+            lineEnd = text.size();
+
+        int contentEnd = lineEnd;
+        if (contentEnd > lineStart && text.at(contentEnd - 1) == '\r')
+            --contentEnd;
+
+        tokenizeLine(text.mid(lineStart, contentEnd - lineStart), state, tokens, lineStart);
+        lineStart = lineEnd + 1;
+    }
+    return tokens;
+}
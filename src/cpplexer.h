@@ -0,0 +1,55 @@
+#ifndef CPPLEXER_H
+#define CPPLEXER_H
+
+#include <QList>
+#include <QString>
+#include <QStringView>
+
+// Построчный лексер C++. Состояние на конце строки (незакрытый комментарий,
+// сырая строка, продолжение строкового литерала) передаётся следующей
+// строке, поэтому текст можно разбирать с любого места, где оно известно.
+class CppLexer
+{
+public:
+    enum class TokenKind {
+        Identifier,
+        Keyword,
+        Number,
+        String,
+        Char,
+        Comment,
+        Directive,
+        HeaderName,
+        Punctuation
+    };
+
+    struct Token
+    {
+        TokenKind kind;
+        int start;
+        int length;
+    };
+
+    struct State
+    {
+        enum Mode { Normal, BlockComment, RawString, StringContinuation, LineCommentContinuation };
+
+        Mode mode = Normal;
+        QString rawDelimiter;
+
+        bool operator==(const State &other) const
+        {
+            return mode == other.mode && rawDelimiter == other.rawDelimiter;
+        }
+        bool operator!=(const State &other) const { return !(*this == other); }
+    };
+
+    // Разбирает одну строку без завершающего '\n'; позиции токенов отсчитываются
+    // от начала line плюс offset.
+    static void tokenizeLine(QStringView line, State &state, QList<Token> &tokens, int offset = 0);
+    static QList<Token> tokenize(QStringView text);
+
+    static bool isKeyword(QStringView word);
+};
+
+#endif // CPPLEXER_H
@@ -0,0 +1,212 @@
+#include "diagnosticschecker.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRegularExpression>
+#include <QTextDocument>
+#include <QTimer>
+
+namespace {
+
+const int DefaultIdleDelayMs = 700;
+const int CheckTimeoutMs = 20000;
+const char SnapshotName[] = "snapshot.cpp";
+
+bool sameFile(const QString &reported, const QString &fileName)
+{
+    return QFileInfo(reported).fileName() == QFileInfo(fileName).fileName();
+}
+
+}
+
+
+DiagnosticsChecker::DiagnosticsChecker(QTextDocument *document, QObject *parent)
+    : QObject(parent),
+      document(document),
+      process(new QProcess(this)),
+      idleTimer(new QTimer(this)),
+      timeoutTimer(new QTimer(this))
+{
+    process->setWorkingDirectory(workDir.path());
+
+    idleTimer->setSingleShot(true);
+    idleTimer->setInterval(DefaultIdleDelayMs);
+    timeoutTimer->setSingleShot(true);
+    timeoutTimer->setInterval(CheckTimeoutMs);
+
+    connect(document, &QTextDocument::contentsChanged, this, &DiagnosticsChecker::scheduleCheck);
+    connect(idleTimer, &QTimer::timeout, this, &DiagnosticsChecker::checkNow);
+    connect(timeoutTimer, &QTimer::timeout, process, &QProcess::kill);
+    connect(process, &QProcess::finished, this, &DiagnosticsChecker::onProcessFinished);
+    connect(process, &QProcess::errorOccurred, this, [this](QProcess::ProcessError error) {
+        if (error == QProcess::FailedToStart)
+            timeoutTimer->stop();
+    });
+}
+
+
+void DiagnosticsChecker::setIdleDelay(int ms)
+{
+    idleTimer->setInterval(ms);
+}
+
+
+void DiagnosticsChecker::scheduleCheck()
+{
+    idleTimer->start();
+
+    // Проверка уже неактуального текста всё равно будет отброшена.
+    if (isRunning()) {
+        restartPending = true;
+        process->kill();
+    }
+}
+
+
+void DiagnosticsChecker::checkNow()
+{
+    idleTimer->stop();
+    if (isRunning()) {
+        restartPending = true;
+        process->kill();
+        return;
+    }
+    restartPending = false;
+
+    QString text = document->toPlainText();
+    if (text.trimmed().isEmpty() || !workDir.isValid()) {
+        if (!current.isEmpty()) {
+            current.clear();
+            emit diagnosticsChanged(current);
+        }
+        return;
+    }
+
+    QFile file(workDir.filePath(SnapshotName));
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return;
+    file.write(text.toUtf8());
+    file.close();
+
+    snapshotRevision = document->revision();
+
+    QStringList arguments = extraFlags;
+    arguments << "-fsyntax-only";
+    if (jsonFormat)
+        arguments << "-fdiagnostics-format=json";
+    else
+        arguments << "-fdiagnostics-color=never";
+    arguments << file.fileName();
+
+    timeoutTimer->start();
+    process->start(compilerPath, arguments);
+}
+
+
+void DiagnosticsChecker::onProcessFinished(int exitCode, QProcess::ExitStatus exitStatus)
+{
+    timeoutTimer->stop();
+    QByteArray output = process->readAllStandardError();
+
+    if (restartPending) {
+        if (!idleTimer->isActive())
+            checkNow();
+        return;
+    }
+    if (exitStatus != QProcess::NormalExit || document->revision() != snapshotRevision)
+        return;
+
+    QString fileName = workDir.filePath(SnapshotName);
+    QList<Diagnostic> diagnostics;
+    if (jsonFormat) {
+        bool ok = false;
+        diagnostics = parseJson(output, fileName, &ok);
+        if (!ok && exitCode != 0 && output.contains("fdiagnostics-format")) {
+            // Компилятор не знает JSON-формата — переходим на текстовый.
+            jsonFormat = false;
+            checkNow();
+            return;
+        }
+        if (!ok)
+            diagnostics = parseText(output, fileName);
+    } else {
+        diagnostics = parseText(output, fileName);
+    }
+
+    current = diagnostics;
+    emit diagnosticsChanged(current);
+}
+
+
+QList<DiagnosticsChecker::Diagnostic> DiagnosticsChecker::parseJson(const QByteArray &output,
+                                                                      const QString &fileName, bool *ok)
+{
+    QList<Diagnostic> diagnostics;
+    QJsonParseError parseError;
+    QJsonDocument doc = QJsonDocument::fromJson(output, &parseError);
+    *ok = parseError.error == QJsonParseError::NoError && doc.isArray();
+    if (!*ok)
+        return diagnostics;
+
+    const QJsonArray items = doc.array();
+    for (const QJsonValue &value : items) {
+        QJsonObject item = value.toObject();
+        QString kind = item.value("kind").toString();
+        if (kind != "error" && kind != "fatal error" && kind != "warning")
+            continue;
+
+        const QJsonArray locations = item.value("locations").toArray();
+        if (locations.isEmpty())
+            continue;
+
+        QJsonObject location = locations.first().toObject();
+        QJsonObject caret = location.value("caret").toObject();
+        if (!sameFile(caret.value("file").toString(), fileName))
+            continue;
+        QJsonObject start = location.contains("start") ? location.value("start").toObject() : caret;
+        QJsonObject finish = location.contains("finish") ? location.value("finish").toObject() : caret;
+
+        auto column = [](const QJsonObject &point) {
+            return point.contains("byte-column") ? point.value("byte-column").toInt()
+                                                 : point.value("column").toInt();
+        };
+
+        Diagnostic diagnostic;
+        diagnostic.severity = kind == "warning" ? Diagnostic::Severity::Warning : Diagnostic::Severity::Error;
+        diagnostic.line = start.value("line").toInt();
+        diagnostic.column = column(start);
+        diagnostic.endLine = finish.value("line").toInt(diagnostic.line);
+        diagnostic.endColumn = column(finish);
+        diagnostic.message = item.value("message").toString();
+        diagnostics.append(diagnostic);
+    }
+    return diagnostics;
+}
+
+
+QList<DiagnosticsChecker::Diagnostic> DiagnosticsChecker::parseText(const QByteArray &output, const QString &fileName)
+{
+    static const QRegularExpression pattern("^(.*?):(\\d+):(\\d+): (fatal error|error|warning): (.*)$",
+                                            QRegularExpression::MultilineOption);
+
+    QList<Diagnostic> diagnostics;
+    QRegularExpressionMatchIterator it = pattern.globalMatch(QString::fromLocal8Bit(output));
+    while (it.hasNext()) {
+        QRegularExpressionMatch match = it.next();
+        if (!sameFile(match.captured(1), fileName))
+            continue;
+
+        Diagnostic diagnostic;
+        diagnostic.severity = match.captured(4) == "warning" ? Diagnostic::Severity::Warning
+                                                            : Diagnostic::Severity::Error;
+        diagnostic.line = match.captured(2).toInt();
+        diagnostic.column = match.captured(3).toInt();
+        diagnostic.endLine = diagnostic.line;
+        diagnostic.endColumn = diagnostic.column;
+        diagnostic.message = match.captured(5).trimmed();
+        diagnostics.append(diagnostic);
+    }
+    return diagnostics;
+}
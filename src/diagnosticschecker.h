@@ -0,0 +1,70 @@
+#ifndef DIAGNOSTICSCHECKER_H
+#define DIAGNOSTICSCHECKER_H
+
+#include <QObject>
+#include <QProcess>
+#include <QStringList>
+#include <QTemporaryDir>
+
+class QTextDocument;
+class QTimer;
+
+// Проверка кода во время набора: после паузы снимок документа пишется во
+// временный файл и проверяется «g++ -fsyntax-only». Одновременно идёт не
+// больше одной проверки; устаревшая прерывается, а результат для уже
+// изменённого текста отбрасывается.
+class DiagnosticsChecker : public QObject
+{
+    Q_OBJECT
+
+public:
+    // Строки и столбцы отсчитываются с 1; столбцы — в байтах UTF-8, как их
+    // считает GCC. Диапазон включает endColumn.
+    struct Diagnostic
+    {
+        enum class Severity { Error, Warning };
+
+        Severity severity;
+        int line;
+        int column;
+        int endLine;
+        int endColumn;
+        QString message;
+    };
+
+    explicit DiagnosticsChecker(QTextDocument *document, QObject *parent = nullptr);
+
+    void setCompiler(const QString &compiler) { compilerPath = compiler; }
+    void setFlags(const QStringList &flags) { extraFlags = flags; }
+    void setIdleDelay(int ms);
+    const QList<Diagnostic> &diagnostics() const { return current; }
+    bool isRunning() const { return process->state() != QProcess::NotRunning; }
+
+public slots:
+    void scheduleCheck();
+    void checkNow();
+
+signals:
+    void diagnosticsChanged(const QList<DiagnosticsChecker::Diagnostic> &diagnostics);
+
+private slots:
+    void onProcessFinished(int exitCode, QProcess::ExitStatus exitStatus);
+
+private:
+    static QList<Diagnostic> parseJson(const QByteArray &output, const QString &fileName, bool *ok);
+    static QList<Diagnostic> parseText(const QByteArray &output, const QString &fileName);
+
+    QTextDocument *document;
+    QProcess *process;
+    QTimer *idleTimer;
+    QTimer *timeoutTimer;
+    QTemporaryDir workDir;
+    QString compilerPath = "g++";
+    QStringList extraFlags;
+    int snapshotRevision = -1;
+    bool restartPending = false;
+    bool jsonFormat = true;
+    QList<Diagnostic> current;
+};
+
+#endif // DIAGNOSTICSCHECKER_H
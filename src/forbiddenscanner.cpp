@@ -0,0 +1,177 @@
+#include "forbiddenscanner.h"
+#include "cpplexer.h"
+#include <QQueue>
+#include <QRegularExpression>
+#include <algorithm>
+
+namespace {
+
+struct Span
+{
+    int streamStart;
+    int sourceStart;
+    int sourceEnd;
+};
+
+bool isSkipped(CppLexer::TokenKind kind)
+{
+    return kind == CppLexer::TokenKind::Comment
+           || kind == CppLexer::TokenKind::String
+           || kind == CppLexer::TokenKind::Char;
+}
+
+
+// Образец приводится к тому же виду, что и исходник в потоке: токены через
+// один пробел. Так "std::sort" совпадёт и с "std :: sort".
+QString normalizePattern(const QString &pattern)
+{
+    QString trimmed = pattern.trimmed();
+    static const QRegularExpression headerName("^(<[^<>]+>|\"[^\"]+\")$");
+    if (headerName.match(trimmed).hasMatch())
+        return trimmed;
+
+    QStringList parts;
+    const QList<CppLexer::Token> tokens = CppLexer::tokenize(trimmed);
+    for (const CppLexer::Token &token : tokens) {
+        if (token.kind != CppLexer::TokenKind::Comment)
+            parts << trimmed.mid(token.start, token.length);
+    }
+    return parts.join(' ');
+}
+
+}
+
+
+ForbiddenScanner::ForbiddenScanner(const QStringList &patterns)
+{
+    nodes.append(Node());
+    for (const QString &pattern : patterns) {
+        QString normalized = normalizePattern(pattern);
+        if (normalized.isEmpty())
+            continue;
+        this->patterns << pattern.trimmed();
+        patternLengths << normalized.size();
+        addPattern(normalized, this->patterns.size() - 1);
+    }
+    build();
+}
+
+
+void ForbiddenScanner::addPattern(const QString &normalized, int index)
+{
+    int state = 0;
+    for (QChar c : normalized) {
+        int child = nodes[state].next.value(c, -1);
+        if (child < 0) {
+            child = nodes.size();
+            nodes.append(Node());
+            nodes[state].next.insert(c, child);
+        }
+        state = child;
+    }
+    if (nodes[state].output < 0)
+        nodes[state].output = index;
+}
+
+
+void ForbiddenScanner::build()
+{
+    QQueue<int> queue;
+    for (int child : std::as_const(nodes[0].next))
+        queue.enqueue(child);
+
+    while (!queue.isEmpty()) {
+        int state = queue.dequeue();
+        for (auto it = nodes[state].next.cbegin(); it != nodes[state].next.cend(); ++it) {
+            QChar c = it.key();
+            int child = it.value();
+
+            int fail = nodes[state].fail;
+            while (fail > 0 && !nodes[fail].next.contains(c))
+                fail = nodes[fail].fail;
+            fail = nodes[fail].next.value(c, 0);
+
+            nodes[child].fail = fail;
+            nodes[child].outputLink = nodes[fail].output >= 0 ? fail : nodes[fail].outputLink;
+            queue.enqueue(child);
+        }
+    }
+}
+
+
+QList<ForbiddenScanner::Violation> ForbiddenScanner::scan(const QString &code) const
+{
+    QList<Violation> violations;
+    if (patterns.isEmpty())
+        return violations;
+
+    // Значимые токены складываются в поток, разделённый пробелами; имя
+    // заголовка попадает в него и целиком, и без скобок.
+    QString stream(1, ' ');
+    QList<Span> spans;
+    const QList<CppLexer::Token> tokens = CppLexer::tokenize(code);
+    for (const CppLexer::Token &token : tokens) {
+        if (isSkipped(token.kind))
+            continue;
+
+        int end = token.start + token.length;
+        spans.append({int(stream.size()), token.start, end});
+        stream += QStringView(code).mid(token.start, token.length);
+        stream += ' ';
+
+        if (token.kind == CppLexer::TokenKind::HeaderName && token.length > 2) {
+            spans.append({int(stream.size()), token.start, end});
+            stream += QStringView(code).mid(token.start + 1, token.length - 2);
+            stream += ' ';
+        }
+    }
+
+    QList<int> lineStarts{0};
+    for (int i = 0; i < code.size(); ++i) {
+        if (code.at(i) == '\n')
+            lineStarts.append(i + 1);
+    }
+
+    auto spanAt = [&spans](int streamPos) {
+        auto it = std::upper_bound(spans.cbegin(), spans.cend(), streamPos, [](int pos, const Span &span) {
+            return pos < span.streamStart;
+        });
+        return *(it - 1);
+    };
+
+    int state = 0;
+    for (int i = 0; i < stream.size(); ++i) {
+        QChar c = stream.at(i);
+        while (state > 0 && !nodes[state].next.contains(c))
+            state = nodes[state].fail;
+        state = nodes[state].next.value(c, 0);
+
+        int match = nodes[state].output >= 0 ? state : nodes[state].outputLink;
+        for (; match >= 0; match = nodes[match].outputLink) {
+            int pattern = nodes[match].output;
+            int start = i + 1 - patternLengths.at(pattern);
+            if (stream.at(start - 1) != ' ' || i + 1 >= stream.size() || stream.at(i + 1) != ' ')
+                continue;
+
+            Span first = spanAt(start);
+            Span last = spanAt(i);
+            auto line = std::upper_bound(lineStarts.cbegin(), lineStarts.cend(), first.sourceStart) - 1;
+
+            Violation violation;
+            violation.pattern = patterns.at(pattern);
+            violation.line = int(line - lineStarts.cbegin()) + 1;
+            violation.column = first.sourceStart - *line + 1;
+            violation.position = first.sourceStart;
+            violation.length = last.sourceEnd - first.sourceStart;
+            violations.append(violation);
+        }
+    }
+
+    return violations;
+}
+
+
+QString ForbiddenScanner::describe(const Violation &violation)
+{
+    return QString("«%1» (строка %2, столбец %3)").arg(violation.pattern).arg(violation.line).arg(violation.column);
+}
@@ -0,0 +1,48 @@
+#ifndef FORBIDDENSCANNER_H
+#define FORBIDDENSCANNER_H
+
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+// Поиск запрещённых конструкций по токенам исходника: комментарии и
+// литералы пропускаются, совпадение засчитывается только по границам
+// токенов. Все образцы ищутся за один проход автоматом Ахо — Корасик.
+class ForbiddenScanner
+{
+public:
+    struct Violation
+    {
+        QString pattern;
+        int line;
+        int column;
+        int position;
+        int length;
+    };
+
+    explicit ForbiddenScanner(const QStringList &patterns);
+
+    bool isEmpty() const { return patterns.isEmpty(); }
+    QList<Violation> scan(const QString &code) const;
+
+    static QString describe(const Violation &violation);
+
+private:
+    struct Node
+    {
+        QHash<QChar, int> next;
+        int fail = 0;
+        int output = -1;     // образец, заканчивающийся в этом узле
+        int outputLink = -1; // ближайший по суффиксным ссылкам узел с образцом
+    };
+
+    void addPattern(const QString &normalized, int index);
+    void build();
+
+    QStringList patterns;
+    QList<int> patternLengths;
+    QList<Node> nodes;
+};
+
+#endif // FORBIDDENSCANNER_H
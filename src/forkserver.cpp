@@ -0,0 +1,614 @@
+#include "forkserver.h"
+#include "compilejob.h"
+#include "stagetrace.h"
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QProcessEnvironment>
+#include <QSaveFile>
+#include <QTimer>
+
+#ifdef Q_OS_LINUX
+#include <csignal>
+#include <sys/wait.h>
+#endif
+
+namespace {
+
+const char ReadyLine[] = "PSTU-FORKSERVER READY";
+
+// Сколько ждать ответа прослойки после запуска: если её не подгрузили,
+// программа выполняет обычный main и ждёт входа, которого не будет.
+const int ReadyTimeoutMs = 5000;
+
+// Запас сверх лимита времени случая: лимит соблюдает сам сервер, а этот
+// таймер страхует от зависшего сервера.
+const int WatchdogSlackMs = 5000;
+
+// Вывод идёт в файл, поэтому без лимита вывода RLIMIT_FSIZE всё равно
+// ставится, чтобы зациклившаяся программа не заполнила диск.
+const qint64 UnlimitedOutputKb = 1024 * 1024;
+
+const qsizetype OutputPreviewLimit = 64 * 1024;
+const qsizetype CheckChunkSize = 256 * 1024;
+
+// Исходник прослойки. Сервер сбрасывает буферы stdio перед первым fork() и
+// дальше пишет только через write() в копии дескрипторов 0 и 1, чтобы
+// буферы, которые унаследуют потомки, оставались пустыми.
+const char ShimSource[] = R"SHIM(
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <dlfcn.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/prctl.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+typedef int (*MainFunction)(int, char **, char **);
+typedef int (*StartFunction)(MainFunction, int, char **, void (*)(void), void (*)(void), void (*)(void), void *);
+
+static MainFunction realMain;
+
+static long long nowUs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void writeAll(int fd, const char *data, size_t size)
+{
+    while (size > 0) {
+        ssize_t written = write(fd, data, size);
+        if (written < 0 && errno == EINTR)
+            continue;
+        if (written <= 0)
+            _exit(1);
+        data += written;
+        size -= (size_t)written;
+    }
+}
+
+static char buffer[8192];
+static size_t bufferStart, bufferEnd;
+
+static int readLine(int fd, char *line, size_t capacity)
+{
+    size_t length = 0;
+    for (;;) {
+        if (bufferStart == bufferEnd) {
+            ssize_t got = read(fd, buffer, sizeof(buffer));
+            if (got < 0 && errno == EINTR)
+                continue;
+            if (got <= 0)
+                return -1;
+            bufferStart = 0;
+            bufferEnd = (size_t)got;
+        }
+        char c = buffer[bufferStart++];
+        if (c == '\n') {
+            line[length] = '\0';
+            return (int)length;
+        }
+        if (length + 1 >= capacity)
+            return -1;
+        line[length++] = c;
+    }
+}
+
+static void setLimit(int resource, long long value)
+{
+    struct rlimit limit;
+    limit.rlim_cur = (rlim_t)value;
+    limit.rlim_max = (rlim_t)value;
+    setrlimit(resource, &limit);
+}
+
+static int redirect(const char *path, int fd, int flags)
+{
+    int opened = open(path, flags, 0644);
+    if (opened < 0)
+        return -1;
+    if (opened != fd) {
+        if (dup2(opened, fd) < 0)
+            return -1;
+        close(opened);
+    }
+    return 0;
+}
+
+static int serve(int argc, char **argv, char **envp)
+{
+    // Вывод статической инициализации, оставшийся в буферах stdio, иначе
+    // унаследовал бы и повторил в своём выводе каждый случай. Он уходит
+    // серверу перед строкой готовности и там пропускается.
+    fflush(NULL);
+
+    int control = fcntl(STDIN_FILENO, F_DUPFD_CLOEXEC, 10);
+    int reply = fcntl(STDOUT_FILENO, F_DUPFD_CLOEXEC, 10);
+    if (control < 0 || reply < 0)
+        _exit(1);
+
+    sigset_t childMask, savedMask;
+    sigemptyset(&childMask);
+    sigaddset(&childMask, SIGCHLD);
+    sigprocmask(SIG_BLOCK, &childMask, &savedMask);
+
+    // Перевод строки впереди отделяет готовность от вывода без '\n' в конце.
+    static const char ready[] = "\nPSTU-FORKSERVER READY\n";
+    writeAll(reply, ready, sizeof(ready) - 1);
+
+    // RUN <время, мс> <CPU, мс> <память, МБ> <вывод, КБ> <процессы>\t<вход>\t<вывод>\t<ошибки>
+    char line[16384];
+    while (readLine(control, line, sizeof(line)) >= 0) {
+        long long timeMs, cpuMs, memoryMb, outputKb, processes;
+        char *input = strchr(line, '\t');
+        char *output = input ? strchr(input + 1, '\t') : NULL;
+        char *error = output ? strchr(output + 1, '\t') : NULL;
+        if (!error || sscanf(line, "RUN %lld %lld %lld %lld %lld", &timeMs, &cpuMs, &memoryMb, &outputKb,
+                             &processes) != 5) {
+            static const char bad[] = "ERROR bad command\n";
+            writeAll(reply, bad, sizeof(bad) - 1);
+            continue;
+        }
+        *input++ = '\0';
+        *output++ = '\0';
+        *error++ = '\0';
+
+        long long startUs = nowUs();
+        pid_t pid = fork();
+        if (pid < 0) {
+            static const char failed[] = "ERROR fork failed\n";
+            writeAll(reply, failed, sizeof(failed) - 1);
+            continue;
+        }
+        if (pid == 0) {
+            close(control);
+            close(reply);
+            prctl(PR_SET_PDEATHSIG, SIGKILL);
+            if (redirect(input, STDIN_FILENO, O_RDONLY) < 0
+                || redirect(output, STDOUT_FILENO, O_WRONLY | O_CREAT | O_TRUNC) < 0
+                || redirect(error, STDERR_FILENO, O_WRONLY | O_CREAT | O_TRUNC) < 0)
+                _exit(127);
+
+            if (cpuMs > 0)
+                setLimit(RLIMIT_CPU, (cpuMs + 999) / 1000);
+            if (memoryMb > 0)
+                setLimit(RLIMIT_AS, memoryMb * 1024 * 1024);
+            if (outputKb > 0)
+                setLimit(RLIMIT_FSIZE, outputKb * 1024);
+            if (processes > 0)
+                setLimit(RLIMIT_NPROC, processes);
+            setLimit(RLIMIT_CORE, 0);
+
+            sigprocmask(SIG_SETMASK, &savedMask, NULL);
+            return realMain(argc, argv, envp);
+        }
+
+        long long launchUs = nowUs() - startUs;
+        long long deadline = startUs + timeMs * 1000;
+        int status = 0;
+        int timedOut = 0;
+        struct rusage usage;
+        memset(&usage, 0, sizeof(usage));
+        for (;;) {
+            pid_t done = wait4(pid, &status, WNOHANG, &usage);
+            if (done == pid)
+                break;
+            if (done < 0 && errno != EINTR)
+                _exit(1);
+            long long left = deadline - nowUs();
+            if (left <= 0) {
+                timedOut = 1;
+                kill(pid, SIGKILL);
+                while (wait4(pid, &status, 0, &usage) < 0 && errno == EINTR) {
+                }
+                break;
+            }
+            struct timespec timeout;
+            timeout.tv_sec = left / 1000000;
+            timeout.tv_nsec = (left % 1000000) * 1000;
+            sigtimedwait(&childMask, NULL, &timeout);
+        }
+        long long wallUs = nowUs() - startUs;
+
+        char answer[256];
+        int length = snprintf(answer, sizeof(answer), "DONE %d %d %lld %lld %ld %lld %lld\n", status, timedOut,
+                              (long long)usage.ru_utime.tv_sec * 1000000 + usage.ru_utime.tv_usec,
+                              (long long)usage.ru_stime.tv_sec * 1000000 + usage.ru_stime.tv_usec,
+                              usage.ru_maxrss, wallUs, launchUs);
+        writeAll(reply, answer, (size_t)length);
+    }
+    _exit(0);
+}
+
+#ifdef __cplusplus
+extern "C"
+#endif
+int __libc_start_main(MainFunction main, int argc, char **argv, void (*init)(void), void (*fini)(void),
+                      void (*rtldFini)(void), void *stackEnd)
+{
+    StartFunction start = (StartFunction)dlsym(RTLD_NEXT, "__libc_start_main");
+    const char *enabled = getenv("PSTU_FORKSERVER");
+    int serving = enabled && strcmp(enabled, "1") == 0;
+    // Процессы, которые запустит сама программа, прослойку не наследуют.
+    unsetenv("PSTU_FORKSERVER");
+    unsetenv("LD_PRELOAD");
+    realMain = main;
+    return start(serving ? serve : main, argc, argv, init, fini, rtldFini, stackEnd);
+}
+)SHIM";
+
+QString shimKey(const QString &compiler)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(QByteArray(ShimSource));
+    hash.addData(QByteArray(1, '\0'));
+    hash.addData(compiler.toUtf8());
+    return QString::fromLatin1(hash.result().toHex().left(12));
+}
+
+}
+
+
+ForkServer::ForkServer(const QString &executable, const QString &shimFile, QObject *parent)
+    : QObject(parent),
+      executable(executable),
+      process(new QProcess(this)),
+      watchdog(new QTimer(this))
+{
+    process->setWorkingDirectory(QFileInfo(executable).path());
+    process->setStandardErrorFile(QProcess::nullDevice());
+
+    QProcessEnvironment environment = QProcessEnvironment::systemEnvironment();
+    QString preload = environment.value("LD_PRELOAD");
+    environment.insert("LD_PRELOAD", preload.isEmpty() ? shimFile : shimFile + ":" + preload);
+    environment.insert("PSTU_FORKSERVER", "1");
+    process->setProcessEnvironment(environment);
+
+    watchdog->setSingleShot(true);
+
+    connect(process, &QProcess::readyReadStandardOutput, this, &ForkServer::onReadyReadStandardOutput);
+    connect(process, &QProcess::finished, this, &ForkServer::onProcessFinished);
+    connect(process, &QProcess::errorOccurred, this, [this](QProcess::ProcessError error) {
+        if (error != QProcess::FailedToStart)
+            return;
+        failure = "Не удалось запустить " + executable + ": " + process->errorString();
+        onProcessFinished();
+    });
+    connect(watchdog, &QTimer::timeout, this, &ForkServer::onWatchdog);
+}
+
+
+ForkServer::~ForkServer()
+{
+    process->disconnect(this);
+    if (process->state() != QProcess::NotRunning) {
+        process->kill();
+        process->waitForFinished(1000);
+    }
+}
+
+
+bool ForkServer::isSupported()
+{
+#ifdef Q_OS_LINUX
+    return true;
+#else
+    return false;
+#endif
+}
+
+
+bool ForkServer::canServe(const BuildProfile &profile, QString *reason)
+{
+    QString why;
+    if (!isSupported())
+        why = "Fork-server работает только в Linux.";
+    else if (!profile.sanitizers.isEmpty())
+        why = "Fork-server несовместим с санитайзерами: их среда выполнения должна загружаться первой.";
+    else if (profile.compileFlags().contains("-static") || profile.compileFlags().contains("-static-pie"))
+        why = "Fork-server не работает со статической сборкой: LD_PRELOAD к ней не применяется.";
+
+    if (reason)
+        *reason = why;
+    return why.isEmpty();
+}
+
+
+QString ForkServer::defaultDirectory()
+{
+    return QCoreApplication::applicationDirPath() + "/forkserver";
+}
+
+
+QString ForkServer::shimPath(const QString &compiler)
+{
+    return QDir(defaultDirectory()).filePath(shimKey(compiler) + "/libpstuforkserver.so");
+}
+
+
+CompileJob *ForkServer::createShimJob(const QString &compiler, QObject *parent, QString *error)
+{
+    // Собирается во временный файл и переносится на место в installShim():
+    // несколько прогонов могут собирать прослойку одновременно.
+    QString shim = shimPath(compiler);
+    QDir dir = QFileInfo(shim).dir();
+    QString source = dir.filePath("pstuforkserver.cpp");
+    QSaveFile file(source);
+    if (!dir.mkpath(".") || !file.open(QIODevice::WriteOnly) || file.write(ShimSource) < 0 || !file.commit()) {
+        if (error)
+            *error = "Не удалось записать исходник прослойки " + source + ".";
+        return nullptr;
+    }
+
+    static int buildCount = 0;
+    QString target = shim + QString(".%1-%2.tmp").arg(QCoreApplication::applicationPid()).arg(++buildCount);
+    auto *job = new CompileJob(source, target, parent);
+    job->setCompiler(compiler);
+    job->setFlags(QStringList() << "-shared" << "-fPIC" << "-O2" << "-Wl,--no-as-needed" << "-ldl");
+    return job;
+}
+
+
+bool ForkServer::installShim(const CompileJob *job, const QString &compiler, QString *error)
+{
+    QString shim = shimPath(compiler);
+    if (job->status() != CompileJob::Status::Succeeded) {
+        QFile::remove(job->executableFile());
+        if (error)
+            *error = "Не удалось собрать прослойку fork-server:\n" + job->errorOutput();
+        return false;
+    }
+    // Если другой прогон успел раньше, его копия ничем не хуже.
+    if (!QFile::rename(job->executableFile(), shim))
+        QFile::remove(job->executableFile());
+    if (!QFile::exists(shim)) {
+        if (error)
+            *error = "Не удалось сохранить прослойку fork-server в " + shim + ".";
+        return false;
+    }
+    return true;
+}
+
+
+void ForkServer::start()
+{
+    if (process->state() != QProcess::NotRunning || ready)
+        return;
+
+    if (!workDir.isValid()) {
+        failure = "Не удалось создать временный каталог для fork-server.";
+        QMetaObject::invokeMethod(this, [this] { emit exited(failure); }, Qt::QueuedConnection);
+        return;
+    }
+
+    watchdog->start(ReadyTimeoutMs);
+    process->start(executable, QStringList());
+}
+
+
+void ForkServer::run(const TestDefinition &test, int caseIndex, const ResourceLimits &limits)
+{
+    if (!ready || busy)
+        return;
+
+    busy = true;
+    definition = test;
+    caseLimits = limits;
+    testResult = TestResult();
+    testResult.caseIndex = caseIndex;
+    testResult.startedAtUs = StageTrace::nowUs();
+
+    QString inputPath = workDir.filePath("input");
+    QFile input(inputPath);
+    const QByteArray &data = test.cases.at(caseIndex).input;
+    if (!input.open(QIODevice::WriteOnly | QIODevice::Truncate) || input.write(data) != data.size()) {
+        failCase("Не удалось записать вход случая в " + inputPath + ".");
+        return;
+    }
+    input.close();
+
+    qint64 memoryMb = limits.memoryLimitMb > 0 && limits.limitAddressSpace ? limits.memoryLimitMb : 0;
+    qint64 outputKb = limits.outputLimitKb > 0 ? limits.outputLimitKb : UnlimitedOutputKb;
+    QString command = QString("RUN %1 %2 %3 %4 %5\t%6\t%7\t%8\n")
+                          .arg(limits.timeLimitMs)
+                          .arg(limits.cpuLimitMs)
+                          .arg(memoryMb)
+                          .arg(outputKb)
+                          .arg(limits.processLimit)
+                          .arg(inputPath, workDir.filePath("output"), workDir.filePath("error"));
+    process->write(QFile::encodeName(command));
+    watchdog->start(limits.timeLimitMs + WatchdogSlackMs);
+}
+
+
+void ForkServer::stop()
+{
+    // Конец команд: сервер выходит сам после текущего случая.
+    if (process->state() != QProcess::NotRunning)
+        process->closeWriteChannel();
+}
+
+
+void ForkServer::cancel()
+{
+    cancelRequested = true;
+    if (process->state() != QProcess::NotRunning)
+        process->kill();
+}
+
+
+void ForkServer::onReadyReadStandardOutput()
+{
+    replyBuffer += process->readAllStandardOutput();
+
+    qsizetype newline;
+    while ((newline = replyBuffer.indexOf('\n')) >= 0) {
+        QByteArray line = replyBuffer.left(newline).trimmed();
+        replyBuffer.remove(0, newline + 1);
+
+        if (!ready) {
+            // До ответа прослойки в вывод может писать статическая
+            // инициализация программы — такие строки пропускаются.
+            if (line == ReadyLine) {
+                ready = true;
+                watchdog->stop();
+                emit started();
+            }
+            continue;
+        }
+        if (!busy)
+            continue;
+        if (line.startsWith("DONE "))
+            completeCase(line);
+        else if (line.startsWith("ERROR "))
+            failCase("Fork-server: " + QString::fromLocal8Bit(line.mid(6)) + ".");
+    }
+}
+
+
+void ForkServer::completeCase(const QByteArray &reply)
+{
+    watchdog->stop();
+
+    const QList<QByteArray> fields = reply.split(' ');
+    if (fields.size() != 8) {
+        failCase("Fork-server прислал непонятный ответ.");
+        return;
+    }
+    int status = fields.at(1).toInt();
+    bool timedOut = fields.at(2) == "1";
+
+    ResourceUsage &usage = testResult.usage;
+    usage.valid = true;
+    usage.userUs = fields.at(3).toLongLong();
+    usage.systemUs = fields.at(4).toLongLong();
+    usage.userMs = usage.userUs / 1000;
+    usage.systemMs = usage.systemUs / 1000;
+    usage.peakRssKb = fields.at(5).toLongLong();
+    testResult.wallUs = fields.at(6).toLongLong();
+    testResult.wallMs = testResult.wallUs / 1000;
+    testResult.launchUs = fields.at(7).toLongLong();
+
+    int exitCode = -1;
+    QProcess::ExitStatus exitStatus = QProcess::CrashExit;
+#ifdef Q_OS_LINUX
+    if (WIFEXITED(status)) {
+        exitCode = WEXITSTATUS(status);
+        exitStatus = QProcess::NormalExit;
+    } else if (WIFSIGNALED(status)) {
+        usage.signal = WTERMSIG(status);
+    }
+#else
+    Q_UNUSED(status);
+#endif
+    testResult.exitCode = exitStatus == QProcess::NormalExit ? exitCode : -1;
+
+    QFile errorFile(workDir.filePath("error"));
+    if (errorFile.open(QIODevice::ReadOnly))
+        testResult.errorOutput = errorFile.read(OutputPreviewLimit);
+
+#ifdef Q_OS_LINUX
+    if (usage.signal == SIGXFSZ && caseLimits.outputLimitKb <= 0) {
+        testResult.details = QString("Вывод превысил %1 МБ.").arg(UnlimitedOutputKb / 1024);
+        finishCase(TestResult::Verdict::OutputLimit);
+        return;
+    }
+#endif
+    if (TestRunner::classifyFailure(testResult, caseLimits, timedOut, false, exitCode, exitStatus)) {
+        finishCase(testResult.verdict);
+        return;
+    }
+    checkOutput();
+}
+
+
+void ForkServer::checkOutput()
+{
+    const TestCase &testCase = definition.cases.at(testResult.caseIndex);
+    OutputChecker checker(testCase.expected, definition.checker);
+
+    QFile output(workDir.filePath("output"));
+    if (!output.open(QIODevice::ReadOnly)) {
+        failCase("Не удалось прочитать вывод программы.");
+        return;
+    }
+
+    qint64 checkStartUs = StageTrace::nowUs();
+    bool matches = true;
+    while (!output.atEnd()) {
+        QByteArray chunk = output.read(CheckChunkSize);
+        if (chunk.isEmpty())
+            break;
+        testResult.outputBytes += chunk.size();
+        if (testResult.output.size() < OutputPreviewLimit)
+            testResult.output += chunk.left(OutputPreviewLimit - testResult.output.size());
+        if (!checker.feed(chunk)) {
+            matches = false;
+            break;
+        }
+    }
+    if (matches)
+        matches = checker.finish();
+    testResult.checkUs = StageTrace::nowUs() - checkStartUs;
+
+    if (matches) {
+        finishCase(TestResult::Verdict::Passed);
+    } else {
+        testResult.details = checker.report();
+        finishCase(TestResult::Verdict::WrongAnswer);
+    }
+}
+
+
+void ForkServer::failCase(const QString &details)
+{
+    watchdog->stop();
+    testResult.details = details;
+    finishCase(cancelRequested ? TestResult::Verdict::Cancelled : TestResult::Verdict::RuntimeError);
+}
+
+
+void ForkServer::finishCase(TestResult::Verdict verdict)
+{
+    if (!busy)
+        return;
+
+    busy = false;
+    testResult.verdict = verdict;
+    emit caseFinished(testResult);
+}
+
+
+void ForkServer::onProcessFinished()
+{
+    watchdog->stop();
+    if (!ready && failure.isEmpty() && !cancelRequested)
+        failure = "Программа завершилась, не запустив fork-server: прослойка не подгрузилась.";
+    else if (ready && busy && failure.isEmpty() && !cancelRequested)
+        failure = "Fork-server неожиданно завершился.";
+
+    ready = false;
+    if (busy)
+        failCase(cancelRequested ? QString("Отменён.") : failure);
+    emit exited(cancelRequested ? QString() : failure);
+}
+
+
+void ForkServer::onWatchdog()
+{
+    failure = ready ? QString("Fork-server не ответил вовремя.")
+                    : QString("Fork-server не ответил за %1 мс после запуска.").arg(ReadyTimeoutMs);
+    process->kill();
+}
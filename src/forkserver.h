@@ -0,0 +1,80 @@
+#ifndef FORKSERVER_H
+#define FORKSERVER_H
+
+#include <QObject>
+#include <QProcess>
+#include <QTemporaryDir>
+#include "testrunner.h"
+#include "buildprofile.h"
+
+class CompileJob;
+class QTimer;
+
+// Запуск случаев без exec на каждый из них (только Linux). Программа
+// стартует один раз с прослойкой в LD_PRELOAD: прослойка перехватывает
+// __libc_start_main и после динамической компоновки и статической
+// инициализации вместо main ждёт команд на stdin. На каждый случай она
+// делает fork(): потомок получает вход, вывод и ошибки из файлов и лимиты
+// через setrlimit и продолжает обычный main, а сервер ждёт его через
+// wait4(), сам следит за лимитом времени и отвечает статусом и rusage.
+// Один сервер выполняет случаи по очереди; параллельность — несколько
+// серверов. Статические сборки и сборки с санитайзерами не поддерживаются.
+// Вывод статических конструкторов выполняется один раз и в вывод случаев
+// не попадает.
+class ForkServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    ForkServer(const QString &executable, const QString &shimFile, QObject *parent = nullptr);
+    ~ForkServer() override;
+
+    static bool isSupported();
+    static bool canServe(const BuildProfile &profile, QString *reason = nullptr);
+    static QString defaultDirectory();
+    // Прослойка собирается тем же компилятором, что и программа.
+    static QString shimPath(const QString &compiler);
+    static CompileJob *createShimJob(const QString &compiler, QObject *parent, QString *error = nullptr);
+    static bool installShim(const CompileJob *job, const QString &compiler, QString *error = nullptr);
+
+    bool isReady() const { return ready; }
+    bool isBusy() const { return busy; }
+
+public slots:
+    void start();
+    void run(const TestDefinition &test, int caseIndex, const ResourceLimits &limits);
+    void stop();
+    void cancel();
+
+signals:
+    void started();
+    void caseFinished(const TestResult &result);
+    // Сервер завершился; reason пуст при обычной остановке и отмене.
+    void exited(const QString &reason);
+
+private slots:
+    void onReadyReadStandardOutput();
+    void onProcessFinished();
+    void onWatchdog();
+
+private:
+    void completeCase(const QByteArray &reply);
+    void failCase(const QString &details);
+    void checkOutput();
+    void finishCase(TestResult::Verdict verdict);
+
+    QString executable;
+    QProcess *process;
+    QTimer *watchdog;
+    QTemporaryDir workDir;
+    QByteArray replyBuffer;
+    bool ready = false;
+    bool busy = false;
+    bool cancelRequested = false;
+    QString failure;
+    TestDefinition definition;
+    ResourceLimits caseLimits;
+    TestResult testResult;
+};
+
+#endif // FORKSERVER_H
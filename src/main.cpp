@@ -1,9 +1,119 @@
 #include "mainwindow.h"
 #include <QApplication>
+#include <QCommandLineParser>
+#include <QThread>
+#include <QTimer>
+#include <algorithm>
+#include <cstring>
 #include "loginwindow.h"
+#include "batchgrader.h"
+#include "resultstore.h"
+
+namespace {
+
+// QApplication требует дисплей, поэтому пакетный режим распознаётся до
+// создания объекта приложения.
+bool isBatchMode(int argc, char *argv[])
+{
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--batch") == 0)
+            return true;
+    }
+    return false;
+}
+
+
+int runBatch(QCoreApplication &app)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Пакетная проверка решений: каждое решение компилируется и прогоняется на всех тестах.");
+    parser.addHelpOption();
+
+    QCommandLineOption batchOption("batch", "Запуск без графического интерфейса.");
+    QCommandLineOption submissionsOption("submissions", "Каталог с решениями (*.cpp или подкаталоги студентов).", "dir");
+    QCommandLineOption testsOption("tests", "Каталог с тестами *.json.", "dir",
+                                   QCoreApplication::applicationDirPath() + "/tests");
+    QCommandLineOption jobsOption(QStringList() << "j" << "jobs", "Число одновременно работающих процессов.", "n",
+                                  QString::number(qMax(1, QThread::idealThreadCount())));
+    QCommandLineOption reportOption("report", "Файл отчёта.", "file");
+    QCommandLineOption formatOption("format", "Формат отчёта: json или csv (по умолчанию — по расширению файла).", "format");
+    QCommandLineOption profileOption("profile", "Профиль сборки из profiles.json (по умолчанию — выбранный в окне).",
+                                     "name");
+    QCommandLineOption compilerOption("compiler", "Компилятор вместо указанного в профиле.", "path");
+    QCommandLineOption flagsOption("flags", "Дополнительные флаги компилятора через пробел.", "flags");
+    QCommandLineOption forkServerOption("fork-server", "Выполнять случаи через fork-server (только Linux).");
+    QCommandLineOption resultsOption("results", "Каталог истории запусков.", "dir", ResultStore::defaultDirectory());
+    QCommandLineOption noResultsOption("no-results", "Не записывать запуски в историю.");
+
+    parser.addOptions({batchOption, submissionsOption, testsOption, jobsOption, reportOption, formatOption,
+                       profileOption, compilerOption, flagsOption, forkServerOption, resultsOption, noResultsOption});
+    parser.process(app);
+
+    if (!parser.isSet(submissionsOption) || !parser.isSet(reportOption)) {
+        qCritical("Нужно указать --submissions и --report.");
+        return 1;
+    }
+
+    BatchGrader::Options options;
+    options.submissionsDir = parser.value(submissionsOption);
+    options.testsDir = parser.value(testsOption);
+    options.reportPath = parser.value(reportOption);
+
+    QList<BuildProfile> profiles;
+    QString currentProfile;
+    QString error;
+    if (!BuildProfiles::load(BuildProfiles::defaultPath(), &profiles, &currentProfile, &error)) {
+        qCritical("%s", qPrintable(error));
+        return 1;
+    }
+    QString profileName = parser.isSet(profileOption) ? parser.value(profileOption) : currentProfile;
+    auto profile = std::find_if(profiles.cbegin(), profiles.cend(), [&profileName](const BuildProfile &candidate) {
+        return candidate.name == profileName;
+    });
+    if (profile == profiles.cend()) {
+        qCritical("Профиль «%s» не найден.", qPrintable(profileName));
+        return 1;
+    }
+    options.profile = *profile;
+    if (parser.isSet(compilerOption))
+        options.profile.compiler = parser.value(compilerOption);
+    options.profile.extraFlags << parser.value(flagsOption).split(' ', Qt::SkipEmptyParts);
+    options.forkServer = parser.isSet(forkServerOption);
+    if (!parser.isSet(noResultsOption))
+        options.resultsDir = parser.value(resultsOption);
+
+    bool ok = false;
+    options.jobs = parser.value(jobsOption).toInt(&ok);
+    if (!ok || options.jobs < 1) {
+        qCritical("Число процессов должно быть положительным.");
+        return 1;
+    }
+
+    QString format = parser.value(formatOption).toLower();
+    if (format.isEmpty())
+        format = options.reportPath.endsWith(".csv", Qt::CaseInsensitive) ? "csv" : "json";
+    if (format == "csv") {
+        options.format = BatchGrader::ReportFormat::Csv;
+    } else if (format != "json") {
+        qCritical("Неизвестный формат отчёта: %s", qPrintable(format));
+        return 1;
+    }
+
+    BatchGrader grader(options);
+    QObject::connect(&grader, &BatchGrader::finished, &app, &QCoreApplication::exit, Qt::QueuedConnection);
+    QTimer::singleShot(0, &grader, &BatchGrader::start);
+    return app.exec();
+}
+
+}
 
 int main(int argc, char *argv[])
 {
+    if (isBatchMode(argc, argv)) {
+        QCoreApplication app(argc, argv);
+        return runBatch(app);
+    }
+
     QApplication app(argc, argv);
     LoginWindow loginWindow;
 
@@ -1,6 +1,17 @@
 #include "mainwindow.h"
 #include <codeeditor.h>
 #include "TestCreationDialog.h"
+#include "compilejob.h"
+#include "pchmanager.h"
+#include "testsuiterunner.h"
+#include "testcatalog.h"
+#include "benchmarkdialog.h"
+#include "stressdialog.h"
+#include "referenceresolver.h"
+#include "testarchive.h"
+#include "projectbuilder.h"
+#include "forkserver.h"
+#include "resultstore.h"
 
 #include <QPushButton>
 #include <QVBoxLayout>
@@ -16,12 +27,47 @@
 #include <QJsonObject>
 #include <QJsonArray>
 #include <QThread>
-#include <QTimer>
-#include <QElapsedTimer>
+#include <QDockWidget>
+#include <QPlainTextEdit>
+#include <QScrollBar>
+#include <QStatusBar>
+#include <QTableWidget>
+#include <QHeaderView>
+#include <QSharedPointer>
+#include <QListView>
+#include <QLineEdit>
+#include <QSortFilterProxyModel>
+#include <QListWidget>
+#include <QTextBlock>
+#include <QComboBox>
+#include <QLabel>
+#include <QRegularExpression>
+#include <QSet>
+#include <QCheckBox>
+#include <QDateTime>
+
+#ifdef Q_OS_WIN
 #include <windows.h>
+#endif
+
+namespace {
+
+QString toolStageName(const QString &tool)
+{
+    if (tool == "cc1plus" || tool == "cc1")
+        return "Фронтенд и кодогенерация (" + tool + ")";
+    if (tool == "as")
+        return "Ассемблер (as)";
+    if (tool == "collect2" || tool == "ld")
+        return "Компоновка (" + tool + ")";
+    return tool;
+}
+
+}
 
 MainWindow::MainWindow(QWidget *parent)
-    : QMainWindow(parent)
+    : QMainWindow(parent),
+      compileCache(QCoreApplication::applicationDirPath() + "/cache")
 {
     auto *centralWidget = new QWidget(this);
     auto *mainLayout = new QVBoxLayout(centralWidget);
@@ -33,11 +79,15 @@ MainWindow::MainWindow(QWidget *parent)
     auto *editTestButton = new QPushButton("Редактировать тест", this);
     auto *showTestInfoButton = new QPushButton("Показать информацию", this);
     auto *deleteTestButton = new QPushButton("Удалить тест", this);
+    auto *packTestsButton = new QPushButton("Упаковать в архив", this);
+    auto *unpackArchiveButton = new QPushButton("Распаковать архив", this);
 
     testButtonLayout->addWidget(createTestButton);
     testButtonLayout->addWidget(editTestButton);
     testButtonLayout->addWidget(showTestInfoButton);
     testButtonLayout->addWidget(deleteTestButton);
+    testButtonLayout->addWidget(packTestsButton);
+    testButtonLayout->addWidget(unpackArchiveButton);
     testGroupBox->setLayout(testButtonLayout);
 
     auto *runGroupBox = new QGroupBox("Выполнение", this);
@@ -45,9 +95,36 @@ MainWindow::MainWindow(QWidget *parent)
 
     auto *compileButton = new QPushButton("Компилировать и запустить", this);
     auto *runWithTestButton = new QPushButton("Запустить с тестом", this);
-
+    auto *runAllTestsButton = new QPushButton("Запустить все тесты", this);
+    auto *benchmarkButton = new QPushButton("Бенчмарк", this);
+    auto *stressButton = new QPushButton("Стресс-тест", this);
+    cancelButton = new QPushButton("Отменить", this);
+    cancelButton->setEnabled(false);
+    profileCombo = new QComboBox(this);
+
+    traceCheck = new QCheckBox("Замер этапов", this);
+    traceCheck->setToolTip("Замерять каждый этап запуска: сохранение, компиляцию, старт процессов, "
+                           "работу программы и сравнение вывода.");
+    traceFileCheck = new QCheckBox("Трасса в файл", this);
+    traceFileCheck->setToolTip("Записывать замеры сессии в JSON формата Chrome trace_event "
+                               "(открывается в chrome://tracing или Perfetto).");
+    traceFileCheck->setEnabled(false);
+    forkServerCheck = new QCheckBox("Fork-server", this);
+    forkServerCheck->setToolTip("Запускать программу один раз и выполнять каждый случай в fork() уже "
+                                "инициализированного процесса (только Linux, без санитайзеров и -static).");
+    forkServerCheck->setEnabled(ForkServer::isSupported());
+
+    runButtonLayout->addWidget(new QLabel("Профиль:", this));
+    runButtonLayout->addWidget(profileCombo);
     runButtonLayout->addWidget(compileButton);
     runButtonLayout->addWidget(runWithTestButton);
+    runButtonLayout->addWidget(runAllTestsButton);
+    runButtonLayout->addWidget(benchmarkButton);
+    runButtonLayout->addWidget(stressButton);
+    runButtonLayout->addWidget(traceCheck);
+    runButtonLayout->addWidget(traceFileCheck);
+    runButtonLayout->addWidget(forkServerCheck);
+    runButtonLayout->addWidget(cancelButton);
     runGroupBox->setLayout(runButtonLayout);
 
     mainLayout->addWidget(testGroupBox);
@@ -57,8 +134,202 @@ MainWindow::MainWindow(QWidget *parent)
     codeEditor->setPlaceholderText("// Введите ваш C++ код здесь");
     mainLayout->addWidget(codeEditor);
 
+    outputPanel = new QPlainTextEdit(this);
+    outputPanel->setReadOnly(true);
+    outputPanel->setFont(QFont("Consolas", 10));
+    outputPanel->setMaximumBlockCount(5000);
+
+    outputDock = new QDockWidget("Вывод", this);
+    outputDock->setObjectName("outputDock");
+    outputDock->setWidget(outputPanel);
+    addDockWidget(Qt::BottomDockWidgetArea, outputDock);
+
+    resultsTable = new QTableWidget(0, 6, this);
+    resultsTable->setHorizontalHeaderLabels(QStringList() << "Тест" << "Результат" << "Время, мс"
+                                                          << "CPU, мс" << "Память, КБ" << "Код выхода");
+    resultsTable->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Stretch);
+    resultsTable->verticalHeader()->setVisible(false);
+    resultsTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    resultsTable->setSelectionBehavior(QAbstractItemView::SelectRows);
+    resultsTable->setSortingEnabled(true);
+
+    resultsDock = new QDockWidget("Результаты тестов", this);
+    resultsDock->setObjectName("resultsDock");
+    resultsDock->setWidget(resultsTable);
+    addDockWidget(Qt::BottomDockWidgetArea, resultsDock);
+    tabifyDockWidget(outputDock, resultsDock);
+    outputDock->raise();
+
+    problemsList = new QListWidget(this);
+
+    problemsDock = new QDockWidget("Проблемы", this);
+    problemsDock->setObjectName("problemsDock");
+    problemsDock->setWidget(problemsList);
+    addDockWidget(Qt::BottomDockWidgetArea, problemsDock);
+    tabifyDockWidget(resultsDock, problemsDock);
+
+    stagesTable = new QTableWidget(0, 5, this);
+    stagesTable->setHorizontalHeaderLabels(QStringList() << "Этап" << "Число" << "Всего, мс" << "Макс., мс"
+                                                         << "Доля");
+    stagesTable->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Stretch);
+    stagesTable->verticalHeader()->setVisible(false);
+    stagesTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+
+    stagesDock = new QDockWidget("Этапы", this);
+    stagesDock->setObjectName("stagesDock");
+    stagesDock->setWidget(stagesTable);
+    addDockWidget(Qt::BottomDockWidgetArea, stagesDock);
+    tabifyDockWidget(problemsDock, stagesDock);
+
+    auto *fileHistoryButton = new QPushButton("История файла", this);
+    fileHistoryButton->setToolTip("Вывести все записанные запуски последнего сохранённого исходника.");
+    auto *historyButtonLayout = new QHBoxLayout();
+    historyButtonLayout->addWidget(fileHistoryButton);
+    historyButtonLayout->addStretch();
+
+    historyTable = new QTableWidget(0, 6, this);
+    historyTable->setHorizontalHeaderLabels(QStringList() << "Тест" << "Запусков" << "Ошибок, %"
+                                                          << "Лучшее время, мс" << "Память, КБ" << "Решение");
+    historyTable->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Stretch);
+    historyTable->verticalHeader()->setVisible(false);
+    historyTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    historyTable->setSelectionBehavior(QAbstractItemView::SelectRows);
+    historyTable->setSortingEnabled(true);
+
+    auto *historyWidget = new QWidget(this);
+    auto *historyLayout = new QVBoxLayout(historyWidget);
+    historyLayout->setContentsMargins(0, 0, 0, 0);
+    historyLayout->addLayout(historyButtonLayout);
+    historyLayout->addWidget(historyTable);
+
+    historyDock = new QDockWidget("История", this);
+    historyDock->setObjectName("historyDock");
+    historyDock->setWidget(historyWidget);
+    addDockWidget(Qt::BottomDockWidgetArea, historyDock);
+    tabifyDockWidget(stagesDock, historyDock);
+    outputDock->raise();
+
+    resultStore = new ResultStore(ResultStore::defaultDirectory(), this);
+    connect(resultStore, &ResultStore::loadFinished, this, &MainWindow::updateHistoryTable);
+    connect(resultStore, &ResultStore::changed, this, &MainWindow::updateHistoryTable);
+    connect(resultStore, &ResultStore::errorOccurred, this, [this](const QString &message) {
+        appendOutput(message + "\n");
+    });
+    connect(fileHistoryButton, &QPushButton::clicked, this, &MainWindow::showSourceHistory);
+
+    connect(traceCheck, &QCheckBox::toggled, traceFileCheck, &QCheckBox::setEnabled);
+    connect(traceCheck, &QCheckBox::toggled, this, [this](bool enabled) {
+        if (!enabled)
+            traceFileCheck->setChecked(false);
+    });
+    connect(traceFileCheck, &QCheckBox::toggled, this, &MainWindow::setTraceFileEnabled);
+
+    diagnosticsChecker = new DiagnosticsChecker(codeEditor->document(), this);
+    connect(diagnosticsChecker, &DiagnosticsChecker::diagnosticsChanged, this, &MainWindow::showDiagnostics);
+
+    connect(problemsList, &QListWidget::itemActivated, this, [this](QListWidgetItem *item) {
+        QTextCursor cursor = codeEditor->textCursor();
+        cursor.setPosition(item->data(Qt::UserRole).toInt());
+        codeEditor->setTextCursor(cursor);
+        codeEditor->setFocus();
+    });
+
+    loadBuildProfiles();
+    connect(profileCombo, &QComboBox::currentIndexChanged, this, &MainWindow::selectBuildProfile);
+
+    testCatalog = new TestCatalog(QCoreApplication::applicationDirPath() + "/tests", this);
+
+    testFilter = new QSortFilterProxyModel(this);
+    testFilter->setSourceModel(testCatalog);
+    testFilter->setFilterRole(TestCatalog::SearchRole);
+    testFilter->setFilterCaseSensitivity(Qt::CaseInsensitive);
+
+    auto *testSearchEdit = new QLineEdit(this);
+    testSearchEdit->setPlaceholderText("Поиск по названию и описанию");
+    testSearchEdit->setClearButtonEnabled(true);
+    connect(testSearchEdit, &QLineEdit::textChanged, testFilter, &QSortFilterProxyModel::setFilterFixedString);
+
+    testList = new QListView(this);
+    testList->setModel(testFilter);
+    testList->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    testList->setUniformItemSizes(true);
+
+    auto *testsWidget = new QWidget(this);
+    auto *testsLayout = new QVBoxLayout(testsWidget);
+    testsLayout->setContentsMargins(0, 0, 0, 0);
+    testsLayout->addWidget(testSearchEdit);
+    testsLayout->addWidget(testList);
+
+    testsDock = new QDockWidget(this);
+    testsDock->setObjectName("testsDock");
+    testsDock->setWidget(testsWidget);
+    addDockWidget(Qt::LeftDockWidgetArea, testsDock);
+    updateTestsDockTitle();
+
+    auto *openProjectButton = new QPushButton("Открыть папку...", this);
+    auto *buildProjectButton = new QPushButton("Собрать", this);
+    auto *runProjectButton = new QPushButton("Собрать и запустить", this);
+    auto *projectButtonLayout = new QHBoxLayout();
+    projectButtonLayout->addWidget(openProjectButton);
+    projectButtonLayout->addWidget(buildProjectButton);
+    projectButtonLayout->addWidget(runProjectButton);
+
+    projectTable = new QTableWidget(0, 3, this);
+    projectTable->setHorizontalHeaderLabels(QStringList() << "Файл" << "Статус" << "Время, мс");
+    projectTable->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Stretch);
+    projectTable->verticalHeader()->setVisible(false);
+    projectTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    projectTable->setSelectionBehavior(QAbstractItemView::SelectRows);
+
+    auto *projectWidget = new QWidget(this);
+    auto *projectLayout = new QVBoxLayout(projectWidget);
+    projectLayout->setContentsMargins(0, 0, 0, 0);
+    projectLayout->addLayout(projectButtonLayout);
+    projectLayout->addWidget(projectTable);
+
+    projectDock = new QDockWidget("Проект", this);
+    projectDock->setObjectName("projectDock");
+    projectDock->setWidget(projectWidget);
+    addDockWidget(Qt::LeftDockWidgetArea, projectDock);
+    tabifyDockWidget(testsDock, projectDock);
+    testsDock->raise();
+
+    connect(openProjectButton, &QPushButton::clicked, this, &MainWindow::openProject);
+    connect(buildProjectButton, &QPushButton::clicked, this, &MainWindow::buildProject);
+    connect(runProjectButton, &QPushButton::clicked, this, &MainWindow::buildAndRunProject);
+    // Ошибки компиляции файла — в панель вывода по двойному щелчку по строке.
+    connect(projectTable, &QTableWidget::cellDoubleClicked, this, [this](int row) {
+        if (!projectBuilder || row >= projectBuilder->units().size())
+            return;
+        const ProjectBuilder::Unit &unit = projectBuilder->units().at(row);
+        if (unit.errorOutput.isEmpty())
+            return;
+        appendOutput(unit.relativePath + ":\n" + unit.errorOutput);
+        outputDock->show();
+        outputDock->raise();
+    });
+
+    connect(testCatalog, &TestCatalog::scanFinished, this, &MainWindow::updateTestsDockTitle);
+    connect(testFilter, &QSortFilterProxyModel::rowsInserted, this, &MainWindow::updateTestsDockTitle);
+    connect(testFilter, &QSortFilterProxyModel::rowsRemoved, this, &MainWindow::updateTestsDockTitle);
+    connect(testFilter, &QSortFilterProxyModel::modelReset, this, &MainWindow::updateTestsDockTitle);
+
+    pchManager = new PchManager(QCoreApplication::applicationDirPath() + "/pch", this);
+    connect(pchManager, &PchManager::buildFinished, this, [this](const QString &header, bool ok, qint64 ms) {
+        if (ok)
+            appendOutput(QString("Предкомпилированный заголовок %1 собран за %2 мс.\n").arg(header).arg(ms));
+        else
+            appendOutput(QString("Не удалось собрать предкомпилированный заголовок %1.\n").arg(header));
+    });
+
     connect(compileButton, &QPushButton::clicked, this, &MainWindow::compileAndRun);
     connect(runWithTestButton, &QPushButton::clicked, this, &MainWindow::compileAndRunWithTest);
+    connect(runAllTestsButton, &QPushButton::clicked, this, &MainWindow::runAllTests);
+    connect(benchmarkButton, &QPushButton::clicked, this, &MainWindow::openBenchmark);
+    connect(stressButton, &QPushButton::clicked, this, &MainWindow::openStressTest);
+    connect(cancelButton, &QPushButton::clicked, this, &MainWindow::cancelRunningJobs);
+    connect(packTestsButton, &QPushButton::clicked, this, &MainWindow::packTests);
+    connect(unpackArchiveButton, &QPushButton::clicked, this, &MainWindow::unpackArchive);
 
     connect(createTestButton, &QPushButton::clicked, this, [] {
         TestCreationDialog dialog;
@@ -66,163 +337,687 @@ MainWindow::MainWindow(QWidget *parent)
     });
 
     connect(editTestButton, &QPushButton::clicked, this, [this] {
-        QString testFilePath = QFileDialog::getOpenFileName(
-            this,
-            "Открыть тест для редактирования",
-            QCoreApplication::applicationDirPath() + "/tests",
-            "JSON Files (*.json)"
-            );
-
-        if (!testFilePath.isEmpty()) {
-            TestCreationDialog dialog(testFilePath, this);
+        const TestCatalog::Entry *entry = selectedTest();
+        if (entry && entry->suiteIndex >= 0) {
+            // Редактор пишет только отдельные файлы JSON: сохранённая копия
+            // легла бы рядом с архивом, и тест появился бы в списке дважды.
+            QMessageBox::information(this, "Редактирование теста",
+                                     "Тест входит в архив \"" + entry->fileName
+                                         + "\". Чтобы изменить его, сначала распакуйте архив.");
+            return;
+        }
+        if (entry) {
+            TestCreationDialog dialog(entry->test, this);
             dialog.exec();
         }
     });
 
+    connect(testList, &QListView::doubleClicked, editTestButton, &QPushButton::click);
+
     connect(deleteTestButton, &QPushButton::clicked, this, [this] {
-        QString testFilePath = QFileDialog::getOpenFileName(
+        const TestCatalog::Entry *entry = selectedTest();
+        if (!entry)
+            return;
+
+        QString testFilePath = QDir(testCatalog->directory()).filePath(entry->fileName);
+        QString question = entry->suiteIndex >= 0
+                               ? "Тест входит в архив. Удалить архив \"" + entry->fileName + "\" со всеми тестами?"
+                               : "Удалить тест \"" + entry->fileName + "\"?";
+        QMessageBox::StandardButton reply = QMessageBox::question(
             this,
-            "Выберите тест для удаления",
-            QCoreApplication::applicationDirPath() + "/tests",
-            "JSON Files (*.json)"
+            "Подтверждение удаления",
+            question,
+            QMessageBox::Yes | QMessageBox::No
             );
 
-        if (!testFilePath.isEmpty()) {
-            QFileInfo fileInfo(testFilePath);
-            QString fileName = fileInfo.fileName();
-
-            QMessageBox::StandardButton reply = QMessageBox::question(
-                this,
-                "Подтверждение удаления",
-                "Удалить тест \"" + fileName + "\"?",
-                QMessageBox::Yes | QMessageBox::No
-                );
-
-            if (reply == QMessageBox::Yes) {
-                if (QFile::remove(testFilePath)) {
-                    QMessageBox::information(this, "Успех", "Тест удален.");
-                } else {
-                    QMessageBox::critical(this, "Ошибка", "Не удалось удалить тест.");
-                }
+        if (reply == QMessageBox::Yes) {
+            if (QFile::remove(testFilePath)) {
+                QMessageBox::information(this, "Успех", "Тест удален.");
+            } else {
+                QMessageBox::critical(this, "Ошибка", "Не удалось удалить тест.");
             }
         }
     });
 
     connect(showTestInfoButton, &QPushButton::clicked, this, [this] {
-        QString testFilePath = QFileDialog::getOpenFileName(
-            this,
-            "Выберите тест для просмотра",
-            QCoreApplication::applicationDirPath() + "/tests",
-            "JSON Files (*.json)"
-            );
+        const TestCatalog::Entry *entry = selectedTest();
+        if (!entry)
+            return;
+
+        QString description = entry->test.description;
+        if(description.isEmpty()) {
+            QMessageBox::information(this, "Информация о тесте", "Описание теста отсутствует.");
+        }
+        else {
+            QMessageBox::information(this, "Информация о тесте", description);
+        }
+    });
+
+    setCentralWidget(centralWidget);
+    setWindowTitle("Проект");
+    resize(1000, 600);
+}
 
-        if(!testFilePath.isEmpty()) {
-            QFile file(testFilePath);
-            if(!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-                QMessageBox::critical(this, "Ошибка", "Не удалось открыть файл теста.");
-                return;
-            }
 
-            QByteArray data = file.readAll();
-            file.close();
+const TestCatalog::Entry *MainWindow::selectedTest()
+{
+    QModelIndex index = testFilter->mapToSource(testList->currentIndex());
+    const TestCatalog::Entry *entry = testCatalog->entryAt(index.row());
+    if (!index.isValid() || !entry) {
+        testsDock->show();
+        testsDock->raise();
+        QMessageBox::information(this, "Тест не выбран", "Выберите тест в списке «Тесты».");
+        return nullptr;
+    }
+    if (!entry->isValid()) {
+        QMessageBox::critical(this, "Ошибка", entry->fileName + ": " + entry->error);
+        return nullptr;
+    }
+    return entry;
+}
 
-            QJsonParseError parseError;
-            QJsonDocument doc = QJsonDocument::fromJson(data, &parseError);
 
-            if(parseError.error != QJsonParseError::NoError || !doc.isObject()) {
-                QMessageBox::critical(this, "Ошибка", "Неверный формат JSON.");
+void MainWindow::markForbidden(const QList<ForbiddenScanner::Violation> &violations)
+{
+    QList<CodeEditor::Mark> marks;
+    for (const ForbiddenScanner::Violation &violation : violations)
+        marks.append({violation.position, violation.length, "Запрещённая конструкция: " + violation.pattern});
+    codeEditor->setMarks(CodeEditor::MarkLayer::Forbidden, marks);
+
+    if (!violations.isEmpty()) {
+        QTextCursor cursor = codeEditor->textCursor();
+        cursor.setPosition(violations.first().position);
+        codeEditor->setTextCursor(cursor);
+        codeEditor->ensureCursorVisible();
+    }
+}
+
+
+QString MainWindow::forbiddenSummary(const QList<ForbiddenScanner::Violation> &violations)
+{
+    const int shownLimit = 10;
+    QStringList lines;
+    for (int i = 0; i < violations.size() && i < shownLimit; ++i)
+        lines << ForbiddenScanner::describe(violations.at(i));
+    if (violations.size() > shownLimit)
+        lines << QString("и ещё %1").arg(violations.size() - shownLimit);
+    return "Код содержит запрещённые конструкции:\n" + lines.join('\n');
+}
+
+
+void MainWindow::showDiagnostics(const QList<DiagnosticsChecker::Diagnostic> &diagnostics)
+{
+    QTextDocument *document = codeEditor->document();
+
+    // GCC считает столбцы в байтах UTF-8, документ — в символах.
+    auto positionOf = [document](int line, int byteColumn) {
+        QTextBlock block = document->findBlockByNumber(qMax(0, line - 1));
+        if (!block.isValid())
+            return qMax(0, document->characterCount() - 1);
+        QByteArray prefix = block.text().toUtf8().left(qMax(0, byteColumn - 1));
+        return block.position() + int(QString::fromUtf8(prefix).size());
+    };
+
+    QList<CodeEditor::Mark> errors;
+    QList<CodeEditor::Mark> warnings;
+    int errorCount = 0;
+    problemsList->clear();
+
+    for (const DiagnosticsChecker::Diagnostic &diagnostic : diagnostics) {
+        bool isError = diagnostic.severity == DiagnosticsChecker::Diagnostic::Severity::Error;
+        int start = positionOf(diagnostic.line, diagnostic.column);
+        int end = positionOf(diagnostic.endLine, diagnostic.endColumn + 1);
+        (isError ? errors : warnings).append({start, qMax(1, end - start), diagnostic.message});
+        if (isError)
+            ++errorCount;
+
+        auto *item = new QListWidgetItem(QString("%1:%2: %3: %4")
+                                             .arg(diagnostic.line)
+                                             .arg(diagnostic.column)
+                                             .arg(isError ? "ошибка" : "предупреждение", diagnostic.message),
+                                         problemsList);
+        item->setForeground(isError ? QColor(Qt::red) : QColor(180, 100, 0));
+        item->setData(Qt::UserRole, start);
+    }
+
+    codeEditor->setMarks(CodeEditor::MarkLayer::Errors, errors);
+    codeEditor->setMarks(CodeEditor::MarkLayer::Warnings, warnings);
+
+    if (diagnostics.isEmpty())
+        problemsDock->setWindowTitle("Проблемы");
+    else
+        problemsDock->setWindowTitle(QString("Проблемы (%1/%2)").arg(errorCount).arg(diagnostics.size() - errorCount));
+}
+
+
+void MainWindow::loadBuildProfiles()
+{
+    QString current;
+    QString error;
+    if (!BuildProfiles::load(BuildProfiles::defaultPath(), &buildProfiles, &current, &error)) {
+        appendOutput(error + " Используются стандартные профили.\n");
+        buildProfiles = BuildProfiles::defaults();
+        current = buildProfiles.first().name;
+    }
+
+    QSignalBlocker blocker(profileCombo);
+    profileCombo->clear();
+    for (const BuildProfile &profile : std::as_const(buildProfiles)) {
+        profileCombo->addItem(profile.name);
+        profileCombo->setItemData(profileCombo->count() - 1, profile.summary(), Qt::ToolTipRole);
+        if (profile.name == current)
+            profileCombo->setCurrentIndex(profileCombo->count() - 1);
+    }
+
+    diagnosticsChecker->setCompiler(currentProfile().compiler);
+    diagnosticsChecker->setFlags(currentProfile().syntaxCheckFlags() << "-Wall");
+}
+
+
+void MainWindow::selectBuildProfile(int index)
+{
+    if (index < 0 || index >= buildProfiles.size())
+        return;
+
+    QString error;
+    if (!BuildProfiles::save(BuildProfiles::defaultPath(), buildProfiles, buildProfiles.at(index).name, &error))
+        appendOutput(error + "\n");
+
+    diagnosticsChecker->setCompiler(currentProfile().compiler);
+    diagnosticsChecker->setFlags(currentProfile().syntaxCheckFlags() << "-Wall");
+    diagnosticsChecker->scheduleCheck();
+    statusBar()->showMessage("Профиль сборки: " + currentProfile().summary(), 5000);
+}
+
+
+const BuildProfile &MainWindow::currentProfile() const
+{
+    int index = qBound(0, profileCombo->currentIndex(), int(buildProfiles.size()) - 1);
+    return buildProfiles.at(index);
+}
+
+
+void MainWindow::updateTestsDockTitle()
+{
+    if (!testCatalog->isLoaded()) {
+        testsDock->setWindowTitle("Тесты (загрузка...)");
+        return;
+    }
+
+    int total = testCatalog->rowCount();
+    int shown = testFilter->rowCount();
+    testsDock->setWindowTitle(shown == total ? QString("Тесты (%1)").arg(total)
+                                             : QString("Тесты (%1 из %2)").arg(shown).arg(total));
+}
+
+
+MainWindow::~MainWindow()
+{
+    for (CompileJob *job : std::as_const(compileJobs))
+        job->disconnect(this);
+    for (TestSuiteRunner *runner : std::as_const(testRuns))
+        runner->disconnect(this);
+    for (ReferenceResolver *resolver : std::as_const(referenceResolvers))
+        resolver->disconnect(this);
+    if (suiteRunner)
+        suiteRunner->disconnect(this);
+    if (benchmarkRunner)
+        benchmarkRunner->disconnect(this);
+    if (stressTester)
+        stressTester->disconnect(this);
+    if (projectBuilder)
+        projectBuilder->disconnect(this);
+    cancelRunningJobs();
+}
+
+
+CompileJob *MainWindow::createCompileJob(const QString &cppFile, const QString &exeFile,
+                                         const QSharedPointer<StageTrace> &trace)
+{
+    const BuildProfile &profile = currentProfile();
+    auto *job = new CompileJob(cppFile, exeFile, this);
+    job->setCompiler(profile.compiler);
+    job->setFlags(profile.compileFlags());
+    job->setCache(&compileCache);
+    job->setPchManager(pchManager);
+    job->setTimeReport(!trace.isNull());
+    compileJobs.append(job);
+
+    if (trace) {
+        connect(job, &CompileJob::finished, this, [job, trace](CompileJob::Status status) {
+            QJsonObject args;
+            args["succeeded"] = status == CompileJob::Status::Succeeded;
+            args["fromCache"] = job->isFromCache();
+            args["pch"] = job->usedPch();
+            trace->add("Компиляция", "compile", job->startedAtUs(), job->finishedAtUs() - job->startedAtUs(), 0, args);
+            if (job->isFromCache() || job->compilerFinishedAtUs() == 0)
                 return;
+
+            trace->add("Процесс компилятора", "compile", job->compilerStartedAtUs(),
+                       job->compilerFinishedAtUs() - job->compilerStartedAtUs());
+            // -time сообщает только процессорное время подпроцессов; они идут
+            // друг за другом, поэтому на трассе расставляются подряд.
+            qint64 atUs = job->compilerStartedAtUs();
+            const QList<CompileJob::ToolTime> tools = job->toolTimes();
+            for (const CompileJob::ToolTime &tool : tools) {
+                trace->add(toolStageName(tool.tool), "compile", atUs, tool.cpuUs, 0, QJsonObject{{"cpuTime", true}});
+                atUs += tool.cpuUs;
             }
+        });
+    }
+
+    QString profileSummary = profile.summary();
+    connect(job, &CompileJob::started, this, [this, job, profileSummary] {
+        appendOutput(QString("[#%1] Компиляция %2 (профиль %3)...\n")
+                         .arg(job->id())
+                         .arg(job->sourceFile(), profileSummary));
+        statusBar()->showMessage(QString("Компиляция #%1...").arg(job->id()));
+        updateCancelButton();
+    });
+
+    connect(job, &CompileJob::errorOutputReceived, this, [this](const QString &text) {
+        appendOutput(text);
+    });
 
-            QJsonObject obj = doc.object();
-            QString description = obj.value("description").toString();
+    connect(job, &CompileJob::finished, this, [this, job](CompileJob::Status status) {
+        QString result;
+        switch (status) {
+        case CompileJob::Status::Succeeded:
+            result = job->isFromCache() ? "успешно (из кэша)" : "успешно";
+            break;
+        case CompileJob::Status::Cancelled:
+            result = "отменена";
+            break;
+        default:
+            result = "с ошибкой";
+            outputDock->show();
+            outputDock->raise();
+            break;
+        }
 
-            if(description.isEmpty()) {
-                QMessageBox::information(this, "Информация о тесте", "Описание теста отсутствует.");
+        QString message = QString("[#%1] Компиляция завершена %2 за %3 мс.")
+                              .arg(job->id())
+                              .arg(result)
+                              .arg(job->elapsedMs());
+        appendOutput(message + "\n");
+        if (status == CompileJob::Status::Succeeded && !job->isFromCache()) {
+            QString timing = QString("Время работы компилятора: %1 мс").arg(job->compileTimeMs());
+            if (job->usedPch()) {
+                qint64 saved = job->pchSavedMs();
+                timing += saved >= 0 ? QString(", с PCH (экономия ≈ %1 мс)").arg(saved) : ", с PCH";
             }
-            else {
-                QMessageBox::information(this, "Информация о тесте", description);
+            appendOutput(timing + ".\n");
+        }
+        appendOutput(QString("Кэш компиляции: попаданий %1, промахов %2, занято %3 из %4 МБ.\n")
+                         .arg(compileCache.hits())
+                         .arg(compileCache.misses())
+                         .arg(compileCache.sizeBytes() / (1024.0 * 1024.0), 0, 'f', 1)
+                         .arg(compileCache.maxBytes() / (1024 * 1024)));
+        statusBar()->showMessage(message, 5000);
+
+        compileJobs.removeOne(job);
+        job->deleteLater();
+        updateCancelButton();
+    });
+
+    return job;
+}
+
+
+void MainWindow::resolveExpectedOutputs(const QList<TestDefinition> &tests, const BuildProfile &profile,
+                                        const QSharedPointer<StageTrace> &trace,
+                                        const std::function<void(const QList<TestDefinition> &)> &next)
+{
+    if (!ReferenceResolver::isNeeded(tests)) {
+        next(tests);
+        return;
+    }
+
+    auto *resolver = new ReferenceResolver(tests, profile, this);
+    resolver->setCompileCache(&compileCache);
+    referenceResolvers.append(resolver);
+
+    connect(resolver, &ReferenceResolver::message, this, &MainWindow::appendOutput);
+    qint64 startUs = StageTrace::nowUs();
+    connect(resolver, &ReferenceResolver::finished, this, [this, resolver, next, trace, startUs](bool ok) {
+        referenceResolvers.removeOne(resolver);
+        resolver->deleteLater();
+        updateCancelButton();
+        if (trace) {
+            trace->add("Эталонные выводы", "reference", startUs, StageTrace::nowUs() - startUs, 0,
+                       QJsonObject{{"cached", resolver->cachedCount()}, {"computed", resolver->computedCount()}});
+        }
+
+        if (!ok) {
+            finishTrace(trace);
+            if (!resolver->errorMessage().isEmpty()) {
+                appendOutput(resolver->errorMessage() + "\n");
+                outputDock->show();
+                outputDock->raise();
             }
+            return;
         }
+
+        appendOutput(QString("Ожидаемые выводы эталонных решений: из кэша %1, вычислено %2.\n")
+                         .arg(resolver->cachedCount())
+                         .arg(resolver->computedCount()));
+        next(resolver->tests());
     });
 
-    setCentralWidget(centralWidget);
-    setWindowTitle("Проект");
-    resize(800, 600);
+    resolver->start();
+    updateCancelButton();
 }
 
 
-MainWindow::~MainWindow() = default;
+QSharedPointer<StageTrace> MainWindow::startTrace(const QString &title) const
+{
+    if (!traceCheck->isChecked())
+        return QSharedPointer<StageTrace>();
+    return QSharedPointer<StageTrace>::create(title);
+}
 
 
-void MainWindow::compileAndRun()
+void MainWindow::traceTestResult(StageTrace *trace, const TestDefinition &test, const TestResult &result, int lane)
 {
-    QString code = codeEditor->toPlainText();
-    if (code.trimmed().isEmpty()) {
-        QMessageBox::warning(this, "Пустой код", "Пожалуйста, введите код перед запуском.");
+    // Случаи, до запуска которых не дошло (отмена, запрещённый код), на трассу не попадают.
+    if (!trace || result.startedAtUs == 0)
         return;
+
+    QJsonObject args;
+    args["test"] = test.name;
+    args["case"] = result.caseIndex + 1;
+    args["verdict"] = TestResult::verdictCode(result.verdict);
+
+    qint64 programStartUs = result.startedAtUs + result.launchUs;
+    trace->setLaneName(lane, QString("%1 #%2").arg(test.name).arg(result.caseIndex + 1));
+    trace->add("Старт процесса", "run", result.startedAtUs, result.launchUs, lane, args);
+    trace->add("Работа программы", "run", programStartUs, result.wallUs, lane, args);
+    if (result.checkUs > 0) {
+        // Сравнение идёт по мере поступления вывода; на трассе показана его сумма.
+        trace->add("Сравнение вывода", "check", programStartUs + result.wallUs, result.checkUs, lane, args);
     }
+}
 
-    QString cppFile = QFileDialog::getSaveFileName(
-        this,
-        "Сохранить C++ файл",
-        QDir::homePath() + "/main.cpp",
-        "C++ Files (*.cpp)"
-        );
 
-    if (cppFile.isEmpty()) {
+void MainWindow::finishTrace(const QSharedPointer<StageTrace> &trace)
+{
+    if (!trace || trace->events().isEmpty())
         return;
+
+    const QList<StageTrace::Stage> stages = trace->stages();
+    qint64 spanUs = trace->spanUs();
+    stagesTable->setRowCount(0);
+    for (const StageTrace::Stage &stage : stages) {
+        int row = stagesTable->rowCount();
+        stagesTable->insertRow(row);
+
+        auto *countItem = new QTableWidgetItem;
+        countItem->setData(Qt::DisplayRole, stage.count);
+        auto *totalItem = new QTableWidgetItem(QString::number(stage.totalUs / 1000.0, 'f', 2));
+        totalItem->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+        auto *maxItem = new QTableWidgetItem(QString::number(stage.maxUs / 1000.0, 'f', 2));
+        maxItem->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+        // У параллельных случаев сумма может превысить длительность всего запуска.
+        auto *shareItem = new QTableWidgetItem(
+            spanUs > 0 ? QString("%1%").arg(100.0 * stage.totalUs / spanUs, 0, 'f', 1) : QString());
+        shareItem->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+
+        stagesTable->setItem(row, 0, new QTableWidgetItem(stage.name));
+        stagesTable->setItem(row, 1, countItem);
+        stagesTable->setItem(row, 2, totalItem);
+        stagesTable->setItem(row, 3, maxItem);
+        stagesTable->setItem(row, 4, shareItem);
     }
+    stagesDock->setWindowTitle(QString("Этапы: %1, %2 мс").arg(trace->title()).arg(spanUs / 1000.0, 0, 'f', 1));
 
-    QFile file(cppFile);
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        QMessageBox::critical(this, "Ошибка", "Не удалось сохранить файл.");
+    if (traceSession) {
+        QString error;
+        if (!traceSession->append(*trace, &error))
+            appendOutput(error + "\n");
+    }
+}
+
+
+void MainWindow::setTraceFileEnabled(bool enabled)
+{
+    if (!enabled) {
+        if (traceSession)
+            appendOutput("Трасса сессии записана в " + QDir::toNativeSeparators(traceSession->filePath()) + ".\n");
+        traceSession.reset();
         return;
     }
 
-    QTextStream out(&file);
-    out << code;
-    file.close();
+    QDir dir(TraceSession::defaultDirectory());
+    dir.mkpath(".");
+    QString filePath = dir.filePath("session-" + QDateTime::currentDateTime().toString("yyyyMMdd-HHmmss") + ".json");
+    traceSession = std::make_unique<TraceSession>(filePath);
+    appendOutput("Замеры этапов будут записываться в " + QDir::toNativeSeparators(filePath) + ".\n");
+}
 
-    QFileInfo fileInfo(cppFile);
-    QString folderPath = fileInfo.path();
-    QString exeFile = fileInfo.dir().filePath(fileInfo.baseName() + ".exe");
 
-    QProcess compileProcess;
-    compileProcess.setWorkingDirectory(folderPath);
-    compileProcess.start("g++", QStringList() << cppFile << "-o" << exeFile);
+void MainWindow::cancelRunningJobs()
+{
+    const QList<CompileJob *> jobs = compileJobs;
+    for (CompileJob *job : jobs)
+        job->cancel();
 
-    if (!compileProcess.waitForFinished(10000)) {
-        QMessageBox::warning(
-            this,
-            "Ошибка компиляции",
-            "Компиляция не завершилась вовремя.\n" + compileProcess.readAllStandardError()
-            );
-        return;
+    const QList<TestSuiteRunner *> runners = testRuns;
+    for (TestSuiteRunner *runner : runners)
+        runner->cancel();
+
+    const QList<ReferenceResolver *> resolvers = referenceResolvers;
+    for (ReferenceResolver *resolver : resolvers)
+        resolver->cancel();
+
+    if (suiteRunner)
+        suiteRunner->cancel();
+
+    if (benchmarkRunner)
+        benchmarkRunner->cancel();
+
+    if (stressTester)
+        stressTester->cancel();
+
+    if (projectBuilder)
+        projectBuilder->cancel();
+}
+
+
+void MainWindow::appendOutput(const QString &text)
+{
+    QScrollBar *scrollBar = outputPanel->verticalScrollBar();
+    bool atBottom = scrollBar->value() == scrollBar->maximum();
+
+    outputPanel->moveCursor(QTextCursor::End);
+    outputPanel->insertPlainText(text);
+
+    if (atBottom)
+        scrollBar->setValue(scrollBar->maximum());
+}
+
+
+void MainWindow::updateCancelButton()
+{
+    bool running = !testRuns.isEmpty() || !referenceResolvers.isEmpty() || (suiteRunner && suiteRunner->isRunning())
+                   || benchmarkRunner || stressTester || (projectBuilder && projectBuilder->isRunning());
+    for (CompileJob *job : std::as_const(compileJobs)) {
+        if (job->isActive()) {
+            running = true;
+            break;
+        }
     }
+    cancelButton->setEnabled(running);
+}
 
-    QString compileErrors = compileProcess.readAllStandardError();
-    if (!compileErrors.isEmpty()) {
-        QMessageBox::warning(this, "Ошибка компиляции", compileErrors);
+
+void MainWindow::compileAndRun()
+{
+    QSharedPointer<StageTrace> trace = startTrace("Компиляция и запуск");
+    QString cppFile = saveCodeToFile(trace.data());
+    if (cppFile.isEmpty())
         return;
-    }
 
-    if (!QFile::exists(exeFile)) {
-        QMessageBox::warning(
-            this,
-            "Ошибка",
-            "Файл " + exeFile + " не был создан!"
-            );
+    QString folderPath = QFileInfo(cppFile).path();
+    QString exeFile = executablePathFor(cppFile);
+
+    CompileJob *job = createCompileJob(cppFile, exeFile, trace);
+    connect(job, &CompileJob::finished, this, [this, folderPath, exeFile, trace](CompileJob::Status status) {
+        if (status != CompileJob::Status::Succeeded) {
+            finishTrace(trace);
+            return;
+        }
+
+        qint64 launchStartUs = StageTrace::nowUs();
+        bool launched = launchInConsole(folderPath, exeFile);
+        if (trace)
+            trace->add("Запуск процесса", "run", launchStartUs, StageTrace::nowUs() - launchStartUs);
+        finishTrace(trace);
+
+        if (!launched)
+            QMessageBox::warning(this, "Ошибка", "Не удалось запустить " + exeFile);
+    });
+    job->start();
+}
+
+
+void MainWindow::compileAndRunWithTest() {
+    const TestCatalog::Entry *entry = selectedTest();
+    if (!entry)
+        return;
+    TestDefinition test = entry->test;
+
+    QSharedPointer<StageTrace> trace = startTrace("Запуск с тестом «" + test.name + "»");
+    QString cppFile = saveCodeToFile(trace.data());
+    if (cppFile.isEmpty())
+        return;
+
+    QString code = codeEditor->toPlainText();
+    QByteArray sourceHash = ResultStore::hashSource(code.toUtf8());
+    BuildProfile profile = currentProfile();
+
+    QList<ForbiddenScanner::Violation> violations;
+    {
+        StageTrace::Scope scope(trace.data(), "Поиск запрещённых конструкций");
+        violations = test.findForbidden(code);
+    }
+    markForbidden(violations);
+    if (!violations.isEmpty()) {
+        recordForbidden(sourceHash, cppFile, profile, test, violations);
+        QMessageBox::warning(this, "Ошибка", forbiddenSummary(violations));
         return;
     }
 
+    QString exeFile = executablePathFor(cppFile);
+
+    CompileJob *job = createCompileJob(cppFile, exeFile, trace);
+    connect(job, &CompileJob::finished, this,
+            [this, cppFile, sourceHash, exeFile, test, profile, trace](CompileJob::Status status) {
+        if (status != CompileJob::Status::Succeeded) {
+            finishTrace(trace);
+            return;
+        }
+
+        resolveExpectedOutputs(QList<TestDefinition>() << test, profile, trace,
+                               [this, cppFile, sourceHash, exeFile, profile, trace](const QList<TestDefinition> &tests) {
+            auto *runner = new TestSuiteRunner(exeFile, tests, this);
+            runner->setAddressSpaceLimit(!profile.usesAddressSanitizer());
+            auto firstFailure = QSharedPointer<TestResult>::create();
+            testRuns.append(runner);
+
+            connect(runner, &TestSuiteRunner::caseFinished, this,
+                    [this, runner, firstFailure, cppFile, sourceHash, profile, trace](int, const TestDefinition &test,
+                                                                                      const TestResult &result) {
+                traceTestResult(trace.data(), test, result, runner->finishedCount());
+                resultStore->record(sourceHash, cppFile, profile.name, test.name, result);
+                if (!result.passed() && firstFailure->verdict == TestResult::Verdict::Cancelled)
+                    *firstFailure = result;
+
+                if (!result.errorOutput.isEmpty())
+                    appendOutput(QString::fromLocal8Bit(result.errorOutput));
+                appendOutput(QString("Тест \"%1\", случай %2: %3. %4.\n")
+                                 .arg(test.name)
+                                 .arg(result.caseIndex + 1)
+                                 .arg(TestResult::verdictName(result.verdict), usageSummary(result)));
+            });
+
+            connect(runner, &TestSuiteRunner::allFinished, this, [this, runner, firstFailure, profile, trace] {
+                testRuns.removeOne(runner);
+                runner->deleteLater();
+                updateCancelButton();
+                finishTrace(trace);
+
+                if (runner->wasCancelled())
+                    return;
+
+                QString resultMessage;
+                if (runner->caseCount() == 0) {
+                    resultMessage = "⚠️ В тесте нет случаев: проверять нечего.";
+                } else if (runner->passedCount() == runner->caseCount()) {
+                    resultMessage = "✅ Тест пройден успешно.";
+                    if (runner->caseCount() > 1)
+                        resultMessage += QString("\n\nПройдены все %1 случаев.").arg(runner->caseCount());
+                } else {
+                    const TestResult &result = *firstFailure;
+                    resultMessage = "❌ Тест не пройден.";
+                    resultMessage += QString("\n\nПройдено случаев: %1 из %2, баллы: %3 из %4.")
+                                         .arg(runner->passedCount())
+                                         .arg(runner->caseCount())
+                                         .arg(runner->score())
+                                         .arg(runner->maxScore());
+                    resultMessage += QString("\n\n🔹 Случай %1: %2.")
+                                         .arg(result.caseIndex + 1)
+                                         .arg(TestResult::verdictName(result.verdict));
+                    if (!result.details.isEmpty())
+                        resultMessage += "\n" + result.details;
+                    resultMessage += "\n\n" + usageSummary(result) + ".";
+                }
+                resultMessage += "\n\nПрофиль сборки: " + profile.summary();
+
+                QMessageBox::information(this, "Результат теста", resultMessage);
+            });
+
+            runner->start();
+            updateCancelButton();
+        });
+    });
+    job->start();
+}
+
+
+QString MainWindow::usageSummary(const TestResult &result)
+{
+    QString usage = QString("Время: %1 мс").arg(result.wallMs);
+    if (result.usage.valid) {
+        usage += QString(", user %1 мс, sys %2 мс, пик памяти %3 КБ")
+                     .arg(result.usage.userMs)
+                     .arg(result.usage.systemMs)
+                     .arg(result.usage.peakRssKb);
+    }
+    return usage;
+}
+
+
+QString MainWindow::executablePathFor(const QString &cppFile)
+{
+    QFileInfo fileInfo(cppFile);
+#ifdef Q_OS_WIN
+    return fileInfo.dir().filePath(fileInfo.baseName() + ".exe");
+#else
+    return fileInfo.dir().filePath(fileInfo.baseName());
+#endif
+}
+
+
+bool MainWindow::launchInConsole(const QString &folderPath, const QString &exeFile)
+{
+#ifdef Q_OS_WIN
     QString command = QString(
                           "cd /d \"%1\" && "
                           "\"%2\" && "
                           "echo Нажмите Enter чтобы закрыть консоль... && "
                           "pause > nul && "
                           "exit"
-                          ).arg(folderPath, exeFile);
+                          ).arg(QDir::toNativeSeparators(folderPath), QDir::toNativeSeparators(exeFile));
 
     ShellExecuteA(
         NULL,
@@ -232,146 +1027,837 @@ void MainWindow::compileAndRun()
         NULL,
         SW_SHOW
         );
+    return true;
+#else
+    return QProcess::startDetached(exeFile, QStringList(), folderPath);
+#endif
 }
 
 
-void MainWindow::compileAndRunWithTest() {
+QString MainWindow::saveCodeToFile(StageTrace *trace)
+{
     QString code = codeEditor->toPlainText();
     if (code.trimmed().isEmpty()) {
         QMessageBox::warning(this, "Пустой код", "Пожалуйста, введите код перед запуском.");
-        return;
+        return QString();
     }
 
-    QString cppFile = QFileDialog::getSaveFileName(
-        this,
-        "Сохранить C++ файл",
-        QDir::homePath() + "/main.cpp",
-        "C++ Files (*.cpp)"
-        );
+    QString cppFile;
+    {
+        StageTrace::Scope scope(trace, "Диалог сохранения");
+        cppFile = QFileDialog::getSaveFileName(
+            this,
+            "Сохранить C++ файл",
+            QDir::homePath() + "/main.cpp",
+            "C++ Files (*.cpp)"
+            );
+    }
     if (cppFile.isEmpty())
-        return;
+        return QString();
 
+    StageTrace::Scope scope(trace, "Запись исходника");
     QFile file(cppFile);
     if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
         QMessageBox::critical(this, "Ошибка", "Не удалось сохранить файл.");
-        return;
+        return QString();
     }
 
     QTextStream out(&file);
     out << code;
     file.close();
 
-    QString testFile = QFileDialog::getOpenFileName(
+    lastSourceFile = cppFile;
+    return cppFile;
+}
+
+
+void MainWindow::runAllTests()
+{
+    if (!testCatalog->isLoaded()) {
+        QMessageBox::information(this, "Тесты загружаются", "Каталог тестов ещё загружается, повторите попытку.");
+        return;
+    }
+    if (testCatalog->entries().isEmpty()) {
+        QMessageBox::information(this, "Нет тестов", "В каталоге " + testCatalog->directory() + " нет тестов.");
+        return;
+    }
+
+    QSharedPointer<StageTrace> trace = startTrace("Все тесты");
+    QString cppFile = saveCodeToFile(trace.data());
+    if (cppFile.isEmpty())
+        return;
+
+    if (suiteRunner) {
+        // Отменённые случаи прошлого прогона не должны попасть в таблицу
+        // нового; итог и удаление прогона по allFinished остаются.
+        disconnect(suiteRunner, &TestSuiteRunner::caseFinished, this, nullptr);
+        suiteRunner->cancel();
+    }
+
+    resultsTable->setRowCount(0);
+    resultsDock->show();
+    resultsDock->raise();
+
+    QString code = codeEditor->toPlainText();
+    QByteArray sourceHash = ResultStore::hashSource(code.toUtf8());
+    BuildProfile profile = currentProfile();
+    QList<TestDefinition> tests;
+    QList<ForbiddenScanner::Violation> allViolations;
+    for (const TestCatalog::Entry &entry : testCatalog->entries()) {
+        if (!entry.isValid()) {
+            appendOutput(entry.fileName + ": " + entry.error + "\n");
+            continue;
+        }
+
+        const TestDefinition &test = entry.test;
+        QList<ForbiddenScanner::Violation> violations;
+        {
+            StageTrace::Scope scope(trace.data(), "Поиск запрещённых конструкций");
+            violations = test.findForbidden(code);
+        }
+        if (!violations.isEmpty()) {
+            TestResult result;
+            result.verdict = TestResult::Verdict::Forbidden;
+            result.details = forbiddenSummary(violations);
+            addTestResultRow(test, result);
+            recordForbidden(sourceHash, cppFile, profile, test, violations);
+            allViolations += violations;
+            continue;
+        }
+
+        tests.append(test);
+    }
+    markForbidden(allViolations);
+
+    QString exeFile = executablePathFor(cppFile);
+
+    CompileJob *job = createCompileJob(cppFile, exeFile, trace);
+    connect(job, &CompileJob::finished, this,
+            [this, cppFile, sourceHash, exeFile, tests, profile, trace](CompileJob::Status status) {
+        if (status != CompileJob::Status::Succeeded) {
+            finishTrace(trace);
+            return;
+        }
+
+        resolveExpectedOutputs(tests, profile, trace,
+                               [this, cppFile, sourceHash, exeFile, profile, trace](const QList<TestDefinition> &resolved) {
+            auto *runner = new TestSuiteRunner(exeFile, resolved, this);
+            runner->setAddressSpaceLimit(!profile.usesAddressSanitizer());
+            if (forkServerCheck->isChecked()) {
+                QString reason;
+                if (ForkServer::canServe(profile, &reason))
+                    runner->setForkServer(profile.compiler);
+                else
+                    appendOutput(reason + "\n");
+            }
+            connect(runner, &TestSuiteRunner::message, this, &MainWindow::appendOutput);
+            suiteRunner = runner;
+
+            connect(runner, &TestSuiteRunner::caseFinished, this,
+                    [this, runner, cppFile, sourceHash, profile, trace](int, const TestDefinition &test,
+                                                                        const TestResult &result) {
+                traceTestResult(trace.data(), test, result, runner->finishedCount());
+                addTestResultRow(test, result);
+                resultStore->record(sourceHash, cppFile, profile.name, test.name, result);
+            });
+
+            connect(runner, &TestSuiteRunner::allFinished, this, [this, runner, profile, trace] {
+                QString message = QString("Тесты: пройдено случаев %1 из %2, баллы %3 из %4, профиль «%5».")
+                                      .arg(runner->passedCount())
+                                      .arg(runner->caseCount())
+                                      .arg(runner->score())
+                                      .arg(runner->maxScore())
+                                      .arg(profile.name);
+                appendOutput(message + "\n");
+                if (runner->caseCount() > 0) {
+                    // Для сравнения с fork-server: тот же прогон с флажком и без него.
+                    QString launcher = runner->usedForkServer()
+                                           ? QString("fork-server, %1 случаев").arg(runner->forkServerCaseCount())
+                                           : QString("QProcess");
+                    appendOutput(QString("Прогон занял %1 мс, %2 мс на случай (%3).\n")
+                                     .arg(runner->elapsedMs())
+                                     .arg(double(runner->elapsedMs()) / runner->caseCount(), 0, 'f', 2)
+                                     .arg(launcher));
+                }
+                statusBar()->showMessage(message, 5000);
+
+                if (suiteRunner == runner)
+                    suiteRunner = nullptr;
+                runner->deleteLater();
+                updateCancelButton();
+                finishTrace(trace);
+            });
+
+            appendOutput(QString("Запуск %1 тестов (%2 случаев), параллельно до %3.\n")
+                             .arg(runner->testCount())
+                             .arg(runner->caseCount())
+                             .arg(QThread::idealThreadCount()));
+            runner->start();
+            updateCancelButton();
+        });
+    });
+    job->start();
+}
+
+
+void MainWindow::packTests()
+{
+    if (!testCatalog->isLoaded()) {
+        QMessageBox::information(this, "Тесты загружаются", "Каталог тестов ещё загружается, повторите попытку.");
+        return;
+    }
+
+    QList<TestDefinition> tests;
+    qint64 sourceBytes = 0;
+    QSet<QString> counted;
+    for (const TestCatalog::Entry &entry : testCatalog->entries()) {
+        if (!entry.isValid())
+            continue;
+        // Архив может оказаться в другом каталоге, поэтому путь к эталону делается абсолютным.
+        TestDefinition test = entry.test;
+        if (!test.reference.isEmpty())
+            test.reference = QFileInfo(test.referencePath()).absoluteFilePath();
+        tests.append(test);
+        if (!counted.contains(entry.fileName)) {
+            counted.insert(entry.fileName);
+            sourceBytes += entry.size;
+        }
+    }
+    if (tests.isEmpty()) {
+        QMessageBox::information(this, "Нет тестов", "В каталоге " + testCatalog->directory() + " нет тестов.");
+        return;
+    }
+
+    QString archivePath = QFileDialog::getSaveFileName(
         this,
-        "Выберите файл теста",
-        QCoreApplication::applicationDirPath() + "/tests",
-        "JSON Files (*.json)"
+        "Упаковать тесты в архив",
+        QDir::homePath() + "/tests." + TestArchive::Extension,
+        QString("Архивы тестов (*.%1)").arg(QLatin1String(TestArchive::Extension))
         );
-    if (testFile.isEmpty())
+    if (archivePath.isEmpty())
         return;
 
-    QFile jsonFile(testFile);
-    if (!jsonFile.open(QIODevice::ReadOnly)) {
-        QMessageBox::critical(this, "Ошибка", "Не удалось открыть файл теста.");
+    // Архив из каталога тестов отображён в память, а в Windows такой файл
+    // заменить нельзя: каталог его отпускает, тесты копируют свои данные, а
+    // после записи архив читается заново.
+    bool released = testCatalog->releaseFile(archivePath);
+    if (released)
+        TestArchive::detach(&tests);
+
+    QString error;
+    bool written = TestArchive::write(archivePath, tests, &error);
+    if (released)
+        testCatalog->refresh();
+    if (!written) {
+        if (released && !testRuns.isEmpty())
+            error += "\nАрхив может быть занят запущенными тестами.";
+        QMessageBox::critical(this, "Ошибка", error);
         return;
     }
 
-    QJsonDocument doc = QJsonDocument::fromJson(jsonFile.readAll());
-    QJsonObject obj = doc.object();
-    QString testInput = obj["input"].toString();
-    QString expectedOutput = obj["expected"].toString().trimmed();
-    QJsonArray forbiddenArray = obj["forbidden"].toArray();
+    appendOutput(QString("Архив %1: %2 тестов, %3 КБ (исходные файлы — %4 КБ).\n")
+                     .arg(QDir::toNativeSeparators(archivePath))
+                     .arg(tests.size())
+                     .arg(QFileInfo(archivePath).size() / 1024)
+                     .arg(sourceBytes / 1024));
+    statusBar()->showMessage("Тесты упакованы в " + archivePath, 5000);
+}
 
-    QStringList forbiddenList;
-    for (const QJsonValue &val : forbiddenArray)
-        forbiddenList << val.toString().trimmed();
 
-    jsonFile.close();
+void MainWindow::unpackArchive()
+{
+    QString archivePath = QFileDialog::getOpenFileName(
+        this,
+        "Распаковать архив тестов",
+        QDir::homePath(),
+        QString("Архивы тестов (*.%1)").arg(QLatin1String(TestArchive::Extension))
+        );
+    if (archivePath.isEmpty())
+        return;
 
-    for (const QString &keyword : forbiddenList) {
-        if (!keyword.isEmpty() && code.contains(keyword, Qt::CaseInsensitive)) {
-            QMessageBox::warning(this, "Ошибка", "Код содержит запрещённый элемент: " + keyword);
-            return;
+    QList<TestDefinition> tests;
+    QString error;
+    if (!TestArchive::load(archivePath, &tests, &error)) {
+        QMessageBox::critical(this, "Ошибка", error);
+        return;
+    }
+
+    QString targetDir = QFileDialog::getExistingDirectory(this, "Каталог для тестов JSON", testCatalog->directory());
+    if (targetDir.isEmpty())
+        return;
+
+    // Имя файла берётся из названия теста; совпадения получают номер.
+    static const QRegularExpression forbiddenChars(R"([\\/:*?"<>|])");
+    QDir dir(targetDir);
+    int written = 0;
+    for (TestDefinition test : std::as_const(tests)) {
+        QString baseName = QString(test.name).replace(forbiddenChars, "_").trimmed();
+        if (baseName.isEmpty())
+            baseName = "test";
+        QString filePath = dir.filePath(baseName + ".json");
+        for (int suffix = 2; QFileInfo::exists(filePath); ++suffix)
+            filePath = dir.filePath(QString("%1 (%2).json").arg(baseName).arg(suffix));
+
+        // Относительный путь к эталону отсчитывался от каталога архива.
+        if (!test.reference.isEmpty())
+            test.reference = test.referencePath();
+
+        if (!test.save(filePath, &error)) {
+            appendOutput(QDir::toNativeSeparators(filePath) + ": " + error + "\n");
+            continue;
         }
+        ++written;
     }
 
-    QFileInfo fileInfo(cppFile);
-    QString folderPath = fileInfo.path();
-    QString exeFile = fileInfo.dir().filePath(fileInfo.baseName() + ".exe");
+    QMessageBox::information(this, "Архив распакован",
+                             QString("Записано тестов: %1 из %2.").arg(written).arg(tests.size()));
+}
 
-    QProcess compileProcess;
-    compileProcess.setWorkingDirectory(folderPath);
-    compileProcess.start("g++", QStringList() << cppFile << "-o" << exeFile);
 
-    if (!compileProcess.waitForFinished(5000)) {
-        QMessageBox::warning(this, "Ошибка компиляции", compileProcess.readAllStandardError());
+void MainWindow::openBenchmark()
+{
+    const TestCatalog::Entry *entry = selectedTest();
+    if (!entry)
         return;
+
+    if (!benchmarkDialog) {
+        benchmarkDialog = new BenchmarkDialog(this);
+        connect(benchmarkDialog, &BenchmarkDialog::runRequested, this, &MainWindow::runBenchmark);
+        connect(benchmarkDialog, &BenchmarkDialog::cancelRequested, this, [this] {
+            if (benchmarkRunner)
+                benchmarkRunner->cancel();
+        });
     }
 
-    if (!QFile::exists(exeFile)) {
-        QMessageBox::warning(this, "Ошибка", "Файл " + exeFile + " не создан!");
+    if (!benchmarkRunner) {
+        benchmarkTest = entry->test;
+        benchmarkDialog->setTestName(benchmarkTest.name);
+    }
+    benchmarkDialog->show();
+    benchmarkDialog->raise();
+    benchmarkDialog->activateWindow();
+}
+
+
+void MainWindow::runBenchmark(const BenchmarkRunner::Options &options, const QString &label)
+{
+    if (benchmarkRunner)
+        return;
+
+    QString code = codeEditor->toPlainText();
+    const QList<ForbiddenScanner::Violation> violations = benchmarkTest.findForbidden(code);
+    markForbidden(violations);
+    if (!violations.isEmpty()) {
+        QMessageBox::warning(benchmarkDialog, "Ошибка", forbiddenSummary(violations));
         return;
     }
 
-    QString outputFilePath = folderPath + "/output.txt";
-    QString safeInput = testInput;
-    safeInput.replace("\"", "\"\"");
+    QString cppFile = saveCodeToFile();
+    if (cppFile.isEmpty())
+        return;
 
-    QString cmd = QString(
-                      "cd /d \"%1\" && "
-                      "(echo %2 | \"%3\") > \"%4\" & "
-                      "echo %2 | \"%3\" && "
-                      "echo. && echo Нажмите Enter чтобы закрыть консоль... && pause > nul && exit"
-                      ).arg(folderPath)
-                      .arg(safeInput)
-                      .arg(exeFile)
-                      .arg(outputFilePath);
+    QString exeFile = executablePathFor(cppFile);
+    BuildProfile profile = currentProfile();
+    QString sourceHash = QString::fromLatin1(ResultStore::hashSource(code.toUtf8()).toHex());
+    TestDefinition test = benchmarkTest;
+
+    if (profile.optimization == "0" || !profile.sanitizers.isEmpty())
+        appendOutput("Внимание: профиль «" + profile.name + "» без оптимизации или с санитайзерами, замеры будут "
+                     "отличаться от проверки в рабочей сборке.\n");
+
+    benchmarkDialog->setRunning(true);
+    CompileJob *job = createCompileJob(cppFile, exeFile);
+    connect(job, &CompileJob::finished, this,
+            [this, exeFile, test, options, label, profile, sourceHash](CompileJob::Status status) {
+        if (status != CompileJob::Status::Succeeded) {
+            benchmarkDialog->setRunning(false);
+            return;
+        }
 
-    ShellExecuteA(
-        NULL,
-        "open",
-        "cmd.exe",
-        QString("/C %1").arg(cmd).toLocal8Bit().constData(),
-        NULL,
-        SW_SHOW
-        );
+        BenchmarkRunner::Options runOptions = options;
+        runOptions.addressSpaceLimit = !profile.usesAddressSanitizer();
+        auto *runner = new BenchmarkRunner(exeFile, test, runOptions, this);
+        benchmarkRunner = runner;
 
-    QTimer::singleShot(500, this, [=]() mutable {
-        QElapsedTimer timer;
-        timer.start();
+        connect(runner, &BenchmarkRunner::progress, benchmarkDialog, &BenchmarkDialog::setProgress);
+        connect(runner, &BenchmarkRunner::caseFinished, this, [this](const BenchmarkCase &benchmarkCase) {
+            if (!benchmarkCase.failure.isEmpty()) {
+                appendOutput(QString("Бенчмарк, случай %1: %2\n").arg(benchmarkCase.caseIndex + 1)
+                                 .arg(benchmarkCase.failure));
+                return;
+            }
+            BenchmarkStats wall = benchmarkCase.wallStats();
+            appendOutput(QString("Бенчмарк, случай %1: медиана %2 мс, p95 %3 мс, σ %4 мс.\n")
+                             .arg(benchmarkCase.caseIndex + 1)
+                             .arg(wall.median, 0, 'f', 3)
+                             .arg(wall.p95, 0, 'f', 3)
+                             .arg(wall.stddev, 0, 'f', 3));
+        });
+
+        connect(runner, &BenchmarkRunner::allFinished, this, [this, runner, label, profile, sourceHash] {
+            benchmarkRunner = nullptr;
+            runner->deleteLater();
+            benchmarkDialog->setRunning(false);
+            updateCancelButton();
+
+            if (runner->wasCancelled()) {
+                appendOutput("Бенчмарк отменён.\n");
+                return;
+            }
 
-        while (!QFile::exists(outputFilePath)) {
-            QThread::msleep(200);
-            if (timer.elapsed() > 30000) {
-                QMessageBox::warning(this, "Таймаут", "Программа не завершилась за отведённое время.");
+            BenchmarkResult result = runner->result();
+            result.label = label;
+            result.profile = profile;
+            result.sourceHash = sourceHash;
+
+            QDir directory(BenchmarkResult::defaultDirectory());
+            directory.mkpath(".");
+            QString filePath = directory.filePath(result.timestamp.toString("yyyyMMdd-HHmmss") + ".json");
+            QString error;
+            if (!result.save(filePath, &error)) {
+                appendOutput(error + "\n");
+                filePath.clear();
+            }
+            benchmarkDialog->showResult(result, filePath);
+        });
+
+        appendOutput(QString("Бенчмарк теста \"%1\": %2 прогревочных и %3 замеряемых запусков на случай%4.\n")
+                         .arg(test.name)
+                         .arg(options.warmupRuns)
+                         .arg(options.runs)
+                         .arg(options.pinnedCpu >= 0 ? QString(", ядро %1").arg(options.pinnedCpu) : QString()));
+        runner->start();
+        updateCancelButton();
+    });
+    job->start();
+}
+
+
+void MainWindow::openStressTest()
+{
+    if (!stressDialog) {
+        stressDialog = new StressDialog(this);
+        connect(stressDialog, &StressDialog::runRequested, this, &MainWindow::runStressTest);
+        connect(stressDialog, &StressDialog::cancelRequested, this, [this] {
+            if (stressTester)
+                stressTester->cancel();
+        });
+    }
+    stressDialog->show();
+    stressDialog->raise();
+    stressDialog->activateWindow();
+}
+
+
+void MainWindow::runStressTest()
+{
+    if (stressTester)
+        return;
+
+    QDir workDir(QCoreApplication::applicationDirPath() + "/stress");
+    if (!workDir.mkpath(".")) {
+        QMessageBox::critical(stressDialog, "Ошибка", "Не удалось создать каталог " + workDir.path() + ".");
+        return;
+    }
+
+    // Каждая программа компилируется один раз в свой исполняемый файл;
+    // повторный запуск без изменений берёт их из кэша компиляции.
+    const QStringList names = QStringList() << "generator" << "reference" << "candidate";
+    QStringList sources;
+    QStringList executables;
+    for (int i = 0; i < names.size(); ++i) {
+        auto program = StressDialog::Program(i);
+        QString source = stressDialog->sourceFile(program);
+        if (stressDialog->usesEditor(program)) {
+            QString code = codeEditor->toPlainText();
+            if (code.trimmed().isEmpty()) {
+                QMessageBox::warning(stressDialog, "Пустой код", "Пожалуйста, введите код в редакторе.");
                 return;
             }
+            source = workDir.filePath(names.at(i) + ".cpp");
+            QFile file(source);
+            if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+                QMessageBox::critical(stressDialog, "Ошибка", "Не удалось сохранить " + source + ".");
+                return;
+            }
+            file.write(code.toUtf8());
+        } else if (!QFileInfo::exists(source)) {
+            QMessageBox::warning(stressDialog, "Нет файла", "Укажите существующие исходные файлы всех трёх программ.");
+            return;
         }
+        sources << source;
+        executables << executablePathFor(workDir.filePath(names.at(i) + ".cpp"));
+    }
+
+    StressTester::Options options = stressDialog->options();
+    options.limits.limitAddressSpace = !currentProfile().usesAddressSanitizer();
+    stressDialog->setRunning(true);
+
+    auto remaining = QSharedPointer<int>::create(sources.size());
+    auto failed = QSharedPointer<bool>::create(false);
+    for (int i = 0; i < sources.size(); ++i) {
+        CompileJob *job = createCompileJob(sources.at(i), executables.at(i));
+        connect(job, &CompileJob::finished, this, [this, remaining, failed, executables, options](CompileJob::Status status) {
+            if (status != CompileJob::Status::Succeeded)
+                *failed = true;
+            if (--*remaining > 0)
+                return;
+            if (*failed) {
+                stressDialog->setRunning(false);
+                stressDialog->showOutcome("Не все программы удалось скомпилировать, подробности в окне «Вывод».");
+                return;
+            }
+
+            auto *tester = new StressTester(executables.at(0), executables.at(1), executables.at(2), options, this);
+            stressTester = tester;
+            connect(tester, &StressTester::progress, stressDialog, &StressDialog::setProgress);
+            connect(tester, &StressTester::finished, this, [this, tester](StressTester::Outcome outcome) {
+                stressTester = nullptr;
+                tester->deleteLater();
+                stressDialog->setRunning(false);
+                stressDialog->setProgress(tester->passedCount(), tester->elapsedMs());
+                updateCancelButton();
+
+                QString text;
+                switch (outcome) {
+                case StressTester::Outcome::CaseLimitReached:
+                    text = QString("Расхождений нет: пройдено %1 случаев.").arg(tester->passedCount());
+                    break;
+                case StressTester::Outcome::BudgetExhausted:
+                    text = QString("Расхождений нет: за отведённое время пройдено %1 случаев.")
+                               .arg(tester->passedCount());
+                    break;
+                case StressTester::Outcome::Failed:
+                    text = "Стресс-тест остановлен: " + tester->errorMessage();
+                    break;
+                case StressTester::Outcome::Cancelled:
+                    text = "Стресс-тест отменён.";
+                    break;
+                case StressTester::Outcome::MismatchFound: {
+                    const TestResult &result = tester->failingResult();
+                    text = QString("Расхождение на seed %1: %2.")
+                               .arg(tester->failingSeed())
+                               .arg(TestResult::verdictName(result.verdict));
+                    if (!result.details.isEmpty())
+                        text += "\n" + result.details;
+
+                    QString filePath = QDir(testCatalog->directory())
+                                           .filePath(QString("stress-%1.json").arg(tester->failingSeed()));
+                    QString error;
+                    QDir().mkpath(testCatalog->directory());
+                    if (tester->failingTest().save(filePath, &error))
+                        text += "\nВход сохранён как тест " + QDir::toNativeSeparators(filePath) + ".";
+                    else
+                        text += "\n" + error;
+                    break;
+                }
+                }
+                appendOutput(text + "\n");
+                stressDialog->showOutcome(text);
+            });
+
+            appendOutput(QString("Стресс-тест: до %1 случаев, бюджет %2 с, параллельно %3, seed с %4.\n")
+                             .arg(options.maxCases)
+                             .arg(options.timeBudgetMs / 1000)
+                             .arg(options.parallel)
+                             .arg(options.firstSeed));
+            tester->start();
+            updateCancelButton();
+        });
+        job->start();
+    }
+}
+
+
+void MainWindow::openProject()
+{
+    if (projectBuilder && projectBuilder->isRunning()) {
+        QMessageBox::information(this, "Идёт сборка", "Дождитесь окончания сборки проекта или отмените её.");
+        return;
+    }
+
+    QString directory = QFileDialog::getExistingDirectory(this, "Открыть папку проекта",
+                                                          projectDir.isEmpty() ? QDir::homePath() : projectDir);
+    if (directory.isEmpty())
+        return;
+
+    projectDir = directory;
+    projectDock->show();
+    projectDock->raise();
+    scanProject();
+}
+
+
+void MainWindow::buildProject()
+{
+    startProjectBuild(false);
+}
+
+
+void MainWindow::buildAndRunProject()
+{
+    startProjectBuild(true);
+}
+
+
+bool MainWindow::scanProject()
+{
+    // Сборщик пересоздаётся при каждом проходе: профиль мог смениться.
+    if (projectBuilder)
+        projectBuilder->deleteLater();
+    projectBuilder = new ProjectBuilder(projectDir, currentProfile(), this);
+    connect(projectBuilder, &ProjectBuilder::unitChanged, this, &MainWindow::updateProjectRow);
+    connect(projectBuilder, &ProjectBuilder::message, this, &MainWindow::appendOutput);
+
+    QString error;
+    bool ok = projectBuilder->scan(&error);
+
+    const QList<ProjectBuilder::Unit> &units = projectBuilder->units();
+    projectTable->setRowCount(units.size());
+    for (int row = 0; row < units.size(); ++row)
+        updateProjectRow(row);
+
+    QString name = QFileInfo(projectDir).fileName();
+    if (!ok) {
+        projectDock->setWindowTitle("Проект " + name);
+        QMessageBox::warning(this, "Проект", error);
+        return false;
+    }
+    projectDock->setWindowTitle(QString("Проект %1: файлов %2, устарело %3")
+                                    .arg(name)
+                                    .arg(units.size())
+                                    .arg(projectBuilder->staleCount()));
+    return true;
+}
+
 
-        QFile outFile(outputFilePath);
-        if (!outFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
-            QMessageBox::warning(this, "Ошибка", "Не удалось прочитать вывод.");
+void MainWindow::startProjectBuild(bool runAfterBuild)
+{
+    if (projectDir.isEmpty()) {
+        QMessageBox::information(this, "Проект не открыт", "Сначала откройте папку с исходниками проекта.");
+        return;
+    }
+    if (projectBuilder && projectBuilder->isRunning())
+        return;
+    if (!scanProject())
+        return;
+
+    outputPanel->clear();
+    outputDock->show();
+    outputDock->raise();
+    projectDock->show();
+    projectDock->raise();
+
+    ProjectBuilder *builder = projectBuilder;
+    QString name = QFileInfo(projectDir).fileName();
+    connect(builder, &ProjectBuilder::finished, this, [this, builder, name, runAfterBuild](bool ok) {
+        updateCancelButton();
+        if (!ok) {
+            projectDock->setWindowTitle("Проект " + name + ": ошибка сборки");
+            appendOutput(builder->wasCancelled() ? QString("Сборка проекта отменена.\n")
+                                                 : builder->errorMessage() + "\n");
             return;
         }
 
-        QString actualOutput = QString::fromUtf8(outFile.readAll()).trimmed();
-        outFile.close();
-        QFile::remove(outputFilePath);
+        projectDock->setWindowTitle(QString("Проект %1: собран за %2 мс, скомпилировано %3 из %4")
+                                        .arg(name)
+                                        .arg(builder->elapsedMs())
+                                        .arg(builder->compiledCount())
+                                        .arg(builder->units().size()));
+        appendOutput(QString("Проект собран за %1 мс: %2\n")
+                         .arg(builder->elapsedMs())
+                         .arg(QDir::toNativeSeparators(builder->executableFile())));
+
+        if (runAfterBuild && !launchInConsole(projectDir, builder->executableFile()))
+            QMessageBox::warning(this, "Ошибка", "Не удалось запустить " + builder->executableFile());
+    });
+
+    builder->start();
+    updateCancelButton();
+}
 
-        QString resultMessage;
 
-        if (actualOutput == expectedOutput) {
-            resultMessage = "✅ Тест пройден успешно.";
-        } else {
-            resultMessage = "❌ Тест не пройден.";
-            resultMessage += "\n\n🔹 Ожидалось:\n" + expectedOutput;
-            resultMessage += "\n\n🔹 Получено:\n" + actualOutput;
+void MainWindow::updateProjectRow(int row)
+{
+    if (!projectBuilder || row >= projectBuilder->units().size())
+        return;
+    const ProjectBuilder::Unit &unit = projectBuilder->units().at(row);
+
+    auto cell = [this, row](int column) {
+        QTableWidgetItem *item = projectTable->item(row, column);
+        if (!item) {
+            item = new QTableWidgetItem;
+            projectTable->setItem(row, column, item);
         }
+        return item;
+    };
+
+    QTableWidgetItem *fileItem = cell(0);
+    fileItem->setText(QDir::toNativeSeparators(unit.relativePath));
+    fileItem->setToolTip(unit.source);
+
+    QTableWidgetItem *statusItem = cell(1);
+    statusItem->setText(ProjectBuilder::statusName(unit.status));
+    statusItem->setToolTip(unit.errorOutput);
+    switch (unit.status) {
+    case ProjectBuilder::UnitStatus::Failed:
+        statusItem->setForeground(QColor(Qt::red));
+        break;
+    case ProjectBuilder::UnitStatus::Compiled:
+    case ProjectBuilder::UnitStatus::UpToDate:
+        statusItem->setForeground(QColor(Qt::darkGreen));
+        break;
+    default:
+        statusItem->setForeground(palette().text());
+        break;
+    }
+
+    QTableWidgetItem *timeItem = cell(2);
+    timeItem->setData(Qt::DisplayRole, unit.elapsedMs >= 0 ? QVariant(unit.elapsedMs) : QVariant());
+}
+
+
+void MainWindow::addTestResultRow(const TestDefinition &test, const TestResult &result)
+{
+    resultsTable->setSortingEnabled(false);
+
+    int row = resultsTable->rowCount();
+    resultsTable->insertRow(row);
+
+    QString name = test.name;
+    if (test.cases.size() > 1)
+        name += QString(" #%1").arg(result.caseIndex + 1);
+
+    auto *nameItem = new QTableWidgetItem(name);
+    nameItem->setToolTip(test.filePath);
+
+    auto *verdictItem = new QTableWidgetItem(TestResult::verdictName(result.verdict));
+    verdictItem->setForeground(result.passed() ? QColor(Qt::darkGreen) : QColor(Qt::red));
+    if (!result.details.isEmpty())
+        verdictItem->setToolTip(result.details);
+
+    auto *timeItem = new QTableWidgetItem;
+    timeItem->setData(Qt::DisplayRole, result.wallMs);
 
-        if (!testInput.isEmpty() && !actualOutput.contains(testInput)) {
-            resultMessage += "\n\n⚠️ Ввод пользователя не соответствует ожиданиям теста.";
+    auto *cpuItem = new QTableWidgetItem;
+    if (result.usage.valid)
+        cpuItem->setData(Qt::DisplayRole, result.usage.cpuMs());
+
+    auto *memoryItem = new QTableWidgetItem;
+    if (result.usage.valid)
+        memoryItem->setData(Qt::DisplayRole, result.usage.peakRssKb);
+
+    auto *exitCodeItem = new QTableWidgetItem;
+    exitCodeItem->setData(Qt::DisplayRole, result.exitCode);
+
+    resultsTable->setItem(row, 0, nameItem);
+    resultsTable->setItem(row, 1, verdictItem);
+    resultsTable->setItem(row, 2, timeItem);
+    resultsTable->setItem(row, 3, cpuItem);
+    resultsTable->setItem(row, 4, memoryItem);
+    resultsTable->setItem(row, 5, exitCodeItem);
+
+    resultsTable->setSortingEnabled(true);
+}
+
+
+void MainWindow::recordForbidden(const QByteArray &sourceHash, const QString &cppFile, const BuildProfile &profile,
+                                 const TestDefinition &test, const QList<ForbiddenScanner::Violation> &violations)
+{
+    // Как и в пакетной проверке, запрещённый код проваливает каждый случай теста.
+    for (int caseIndex = 0; caseIndex < qMax(1, int(test.cases.size())); ++caseIndex) {
+        TestResult result;
+        result.verdict = TestResult::Verdict::Forbidden;
+        result.caseIndex = caseIndex;
+        result.details = forbiddenSummary(violations);
+        resultStore->record(sourceHash, cppFile, profile.name, test.name, result);
+    }
+}
+
+
+void MainWindow::updateHistoryTable()
+{
+    const QList<ResultStore::CaseStats> stats = resultStore->caseStats();
+    QHash<QString, int> casesPerTest;
+    for (const ResultStore::CaseStats &caseStats : stats)
+        ++casesPerTest[caseStats.test];
+
+    historyTable->setSortingEnabled(false);
+    historyTable->setRowCount(stats.size());
+    for (int row = 0; row < stats.size(); ++row) {
+        const ResultStore::CaseStats &caseStats = stats.at(row);
+
+        QString name = caseStats.test;
+        if (casesPerTest.value(caseStats.test) > 1)
+            name += QString(" #%1").arg(caseStats.caseIndex + 1);
+
+        auto *nameItem = new QTableWidgetItem(name);
+
+        auto *runsItem = new QTableWidgetItem;
+        runsItem->setData(Qt::DisplayRole, caseStats.runs);
+
+        auto *failureItem = new QTableWidgetItem;
+        failureItem->setData(Qt::DisplayRole, qRound(caseStats.failureRate() * 1000) / 10.0);
+        failureItem->setToolTip(QString("Ошибок: %1 из %2").arg(caseStats.failures).arg(caseStats.runs));
+
+        auto *timeItem = new QTableWidgetItem;
+        auto *memoryItem = new QTableWidgetItem;
+        auto *sourceItem = new QTableWidgetItem;
+        if (caseStats.hasPassed) {
+            const ResultStore::Run &fastest = caseStats.fastest;
+            timeItem->setData(Qt::DisplayRole, fastest.wallUs / 1000.0);
+            if (fastest.peakRssKb >= 0)
+                memoryItem->setData(Qt::DisplayRole, fastest.peakRssKb);
+            sourceItem->setText(QString::fromLatin1(fastest.sourceHash.toHex().left(8)) + " "
+                                + QFileInfo(fastest.sourcePath).fileName());
+            sourceItem->setToolTip(QString("%1\n%2, профиль «%3»")
+                                       .arg(QDir::toNativeSeparators(fastest.sourcePath),
+                                            QDateTime::fromMSecsSinceEpoch(fastest.timestampMs)
+                                                .toString("yyyy-MM-dd HH:mm:ss"),
+                                            fastest.profile));
         }
 
-        QMessageBox::information(this, "Результат теста", resultMessage);
-    });
+        historyTable->setItem(row, 0, nameItem);
+        historyTable->setItem(row, 1, runsItem);
+        historyTable->setItem(row, 2, failureItem);
+        historyTable->setItem(row, 3, timeItem);
+        historyTable->setItem(row, 4, memoryItem);
+        historyTable->setItem(row, 5, sourceItem);
+    }
+    historyTable->setSortingEnabled(true);
+
+    historyDock->setWindowTitle(QString("История: %1 запусков").arg(resultStore->runCount()));
+}
+
+
+void MainWindow::showSourceHistory()
+{
+    if (lastSourceFile.isEmpty()) {
+        QMessageBox::information(this, "Нет файла", "Сначала сохраните и запустите решение на тестах.");
+        return;
+    }
+
+    const QList<ResultStore::Run> runs = resultStore->history(lastSourceFile);
+    if (runs.isEmpty()) {
+        appendOutput("Для " + QDir::toNativeSeparators(lastSourceFile) + " запусков ещё нет.\n");
+    } else {
+        // Хеш меняется вместе с исходником, поэтому по нему видно, какие
+        // запуски относятся к одной версии решения.
+        QString text = QString("История %1, последние %2 запусков:\n")
+                           .arg(QDir::toNativeSeparators(lastSourceFile))
+                           .arg(runs.size());
+        for (const ResultStore::Run &run : runs) {
+            text += QString("%1  %2  %3 #%4: %5, %6 мс, профиль «%7»\n")
+                        .arg(QDateTime::fromMSecsSinceEpoch(run.timestampMs).toString("yyyy-MM-dd HH:mm:ss"),
+                             QString::fromLatin1(run.sourceHash.toHex().left(8)),
+                             run.test)
+                        .arg(run.caseIndex + 1)
+                        .arg(TestResult::verdictName(run.verdict))
+                        .arg(run.wallUs / 1000.0, 0, 'f', 1)
+                        .arg(run.profile);
+        }
+        appendOutput(text);
+    }
+    outputDock->show();
+    outputDock->raise();
 }
@@ -3,8 +3,38 @@
 
 #include <QMainWindow>
 #include <QTextEdit>
+#include <QList>
+#include <QSharedPointer>
+#include <functional>
+#include <memory>
+#include "compilecache.h"
+#include "testcatalog.h"
+#include "diagnosticschecker.h"
+#include "buildprofile.h"
+#include "benchmarkrunner.h"
+#include "stagetrace.h"
 
 class QPlainTextEdit;
+class QPushButton;
+class QDockWidget;
+class QTableWidget;
+class QListView;
+class QListWidget;
+class QComboBox;
+class QCheckBox;
+class QSortFilterProxyModel;
+class CodeEditor;
+class CompileJob;
+class PchManager;
+class TestSuiteRunner;
+class BenchmarkDialog;
+class StressDialog;
+class StressTester;
+class ReferenceResolver;
+class ProjectBuilder;
+class ResultStore;
+struct TestDefinition;
+struct TestResult;
 
 class MainWindow : public QMainWindow {
     Q_OBJECT
@@ -16,9 +46,91 @@ public:
 private slots:
     void compileAndRun();
     void compileAndRunWithTest();
+    void runAllTests();
+    void packTests();
+    void unpackArchive();
+    void openBenchmark();
+    void runBenchmark(const BenchmarkRunner::Options &options, const QString &label);
+    void openStressTest();
+    void runStressTest();
+    void openProject();
+    void buildProject();
+    void buildAndRunProject();
+    void cancelRunningJobs();
 
 private:
-    QPlainTextEdit *codeEditor;
+    QString saveCodeToFile(StageTrace *trace = nullptr);
+    const TestCatalog::Entry *selectedTest();
+    void updateTestsDockTitle();
+    void markForbidden(const QList<ForbiddenScanner::Violation> &violations);
+    static QString forbiddenSummary(const QList<ForbiddenScanner::Violation> &violations);
+    void showDiagnostics(const QList<DiagnosticsChecker::Diagnostic> &diagnostics);
+    void loadBuildProfiles();
+    void selectBuildProfile(int index);
+    const BuildProfile &currentProfile() const;
+    void addTestResultRow(const TestDefinition &test, const TestResult &result);
+    static QString executablePathFor(const QString &cppFile);
+    static bool launchInConsole(const QString &folderPath, const QString &exeFile);
+    static QString usageSummary(const TestResult &result);
+    CompileJob *createCompileJob(const QString &cppFile, const QString &exeFile,
+                                 const QSharedPointer<StageTrace> &trace = QSharedPointer<StageTrace>());
+    void resolveExpectedOutputs(const QList<TestDefinition> &tests, const BuildProfile &profile,
+                                const QSharedPointer<StageTrace> &trace,
+                                const std::function<void(const QList<TestDefinition> &)> &next);
+    QSharedPointer<StageTrace> startTrace(const QString &title) const;
+    static void traceTestResult(StageTrace *trace, const TestDefinition &test, const TestResult &result, int lane);
+    void finishTrace(const QSharedPointer<StageTrace> &trace);
+    void setTraceFileEnabled(bool enabled);
+    bool scanProject();
+    void startProjectBuild(bool runAfterBuild);
+    void updateProjectRow(int row);
+    void recordForbidden(const QByteArray &sourceHash, const QString &cppFile, const BuildProfile &profile,
+                         const TestDefinition &test, const QList<ForbiddenScanner::Violation> &violations);
+    void updateHistoryTable();
+    void showSourceHistory();
+    void appendOutput(const QString &text);
+    void updateCancelButton();
+
+    CodeEditor *codeEditor;
+    QPlainTextEdit *outputPanel;
+    QDockWidget *outputDock;
+    QPushButton *cancelButton;
+    QComboBox *profileCombo;
+    QList<BuildProfile> buildProfiles;
+    QTableWidget *resultsTable;
+    QDockWidget *resultsDock;
+    TestCatalog *testCatalog;
+    QSortFilterProxyModel *testFilter;
+    QListView *testList;
+    QDockWidget *testsDock;
+    DiagnosticsChecker *diagnosticsChecker;
+    QListWidget *problemsList;
+    QDockWidget *problemsDock;
+    QCheckBox *traceCheck;
+    QCheckBox *traceFileCheck;
+    QCheckBox *forkServerCheck;
+    QTableWidget *stagesTable;
+    QDockWidget *stagesDock;
+    QTableWidget *projectTable;
+    QDockWidget *projectDock;
+    QString projectDir;
+    ProjectBuilder *projectBuilder = nullptr;
+    QTableWidget *historyTable;
+    QDockWidget *historyDock;
+    ResultStore *resultStore;
+    QString lastSourceFile;
+    std::unique_ptr<TraceSession> traceSession;
+    QList<CompileJob *> compileJobs;
+    QList<TestSuiteRunner *> testRuns;
+    QList<ReferenceResolver *> referenceResolvers;
+    TestSuiteRunner *suiteRunner = nullptr;
+    BenchmarkDialog *benchmarkDialog = nullptr;
+    BenchmarkRunner *benchmarkRunner = nullptr;
+    TestDefinition benchmarkTest;
+    StressDialog *stressDialog = nullptr;
+    StressTester *stressTester = nullptr;
+    CompileCache compileCache;
+    PchManager *pchManager;
 };
 
 #endif // MAINWINDOW_H
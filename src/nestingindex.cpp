@@ -0,0 +1,347 @@
+#include "nestingindex.h"
+#include <QVarLengthArray>
+#include <algorithm>
+
+QChar NestingIndex::pairOf(QChar ch)
+{
+    switch (ch.unicode()) {
+    case '(': return ')';
+    case ')': return '(';
+    case '[': return ']';
+    case ']': return '[';
+    case '{': return '}';
+    case '}': return '{';
+    }
+    return QChar();
+}
+
+
+NestingIndex::Summary NestingIndex::combine(const Summary &left, const Summary &right)
+{
+    Summary result;
+    result.net = left.net + right.net;
+    result.minAfter = left.minAfter;
+    if (right.minAfter != Unset)
+        result.minAfter = std::min(result.minAfter, left.net + right.minAfter);
+    result.minBefore = left.minBefore;
+    if (right.minBefore != Unset)
+        result.minBefore = std::min(result.minBefore, left.net + right.minBefore);
+    return result;
+}
+
+
+void NestingIndex::replaceLines(int first, int removed, const QStringList &newLines)
+{
+    int oldCount = lines.size();
+    first = qBound(0, first, oldCount);
+    removed = qBound(0, removed, oldCount - first);
+
+    lines.remove(first, removed);
+    lines.insert(first, newLines.size(), Line());
+    for (int i = 0; i < newLines.size(); ++i)
+        lines[first + i].text = newLines.at(i);
+    if (lines.size() != oldCount)
+        treeValid = false;
+
+    // Новые строки разбираются всегда, следующие — пока у них меняется
+    // входное состояние лексера.
+    int end = first + int(newLines.size());
+    for (int i = first; i < lines.size(); ++i) {
+        CppLexer::State start = i > 0 ? lines.at(i - 1).endState : CppLexer::State();
+        Line &line = lines[i];
+        if (i >= end && line.tokenized && line.startState == start)
+            break;
+        tokenize(line, start);
+        update(i);
+    }
+}
+
+
+void NestingIndex::tokenize(Line &line, const CppLexer::State &start)
+{
+    line.startState = start;
+    line.endState = start;
+    line.brackets.clear();
+    line.summary = Summary();
+    line.tokenized = true;
+
+    QList<CppLexer::Token> tokens;
+    CppLexer::tokenizeLine(line.text, line.endState, tokens);
+
+    int depth = 0;
+    for (const CppLexer::Token &token : std::as_const(tokens)) {
+        if (token.kind != CppLexer::TokenKind::Punctuation || token.length != 1)
+            continue;
+        QChar ch = line.text.at(token.start);
+        if (!isOpen(ch) && !isClose(ch))
+            continue;
+
+        line.brackets.append(Bracket{token.start, ch});
+        line.summary.minBefore = std::min(line.summary.minBefore, depth);
+        depth += isOpen(ch) ? 1 : -1;
+        line.summary.minAfter = std::min(line.summary.minAfter, depth);
+    }
+    line.summary.net = depth;
+}
+
+
+void NestingIndex::update(int line)
+{
+    if (!treeValid)
+        return;
+
+    // Спуск до листа и пересчёт узлов на обратном пути.
+    QVarLengthArray<int, 64> path;
+    int node = 1;
+    int lo = 0;
+    int hi = lines.size() - 1;
+    while (lo < hi) {
+        path.append(node);
+        int mid = (lo + hi) / 2;
+        if (line <= mid) {
+            node = 2 * node;
+            hi = mid;
+        } else {
+            node = 2 * node + 1;
+            lo = mid + 1;
+        }
+    }
+    tree[node] = lines.at(line).summary;
+    for (int i = path.size() - 1; i >= 0; --i)
+        tree[path[i]] = combine(tree.at(2 * path[i]), tree.at(2 * path[i] + 1));
+}
+
+
+void NestingIndex::rebuild() const
+{
+    if (treeValid)
+        return;
+    tree.fill(Summary(), 4 * std::max<qsizetype>(lines.size(), 1));
+    if (!lines.isEmpty())
+        build(1, 0, lines.size() - 1);
+    treeValid = true;
+}
+
+
+void NestingIndex::build(int node, int lo, int hi) const
+{
+    if (lo == hi) {
+        tree[node] = lines.at(lo).summary;
+        return;
+    }
+    int mid = (lo + hi) / 2;
+    build(2 * node, lo, mid);
+    build(2 * node + 1, mid + 1, hi);
+    tree[node] = combine(tree.at(2 * node), tree.at(2 * node + 1));
+}
+
+
+int NestingIndex::depthAt(int line) const
+{
+    rebuild();
+    if (line <= 0 || lines.isEmpty())
+        return 0;
+    if (line >= lines.size())
+        return tree.at(1).net;
+
+    int depth = 0;
+    int node = 1;
+    int lo = 0;
+    int hi = lines.size() - 1;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (line <= mid) {
+            node = 2 * node;
+            hi = mid;
+        } else {
+            depth += tree.at(2 * node).net;
+            node = 2 * node + 1;
+            lo = mid + 1;
+        }
+    }
+    return depth;
+}
+
+
+// Первая строка не раньше from, в которой глубина после какой-нибудь скобки
+// не больше target; depth — глубина в начале ещё не пройденной части.
+int NestingIndex::searchForward(int node, int lo, int hi, int from, int target, int &depth) const
+{
+    if (hi < from)
+        return -1;
+
+    const Summary &summary = tree.at(node);
+    if (lo >= from) {
+        if (summary.minAfter == Unset || depth + summary.minAfter > target) {
+            depth += summary.net;
+            return -1;
+        }
+        if (lo == hi)
+            return lo;
+    }
+
+    int mid = (lo + hi) / 2;
+    int found = searchForward(2 * node, lo, mid, from, target, depth);
+    if (found >= 0)
+        return found;
+    return searchForward(2 * node + 1, mid + 1, hi, from, target, depth);
+}
+
+
+// Последняя строка не позже to, в которой глубина перед какой-нибудь
+// скобкой не больше target; depth — глубина в конце ещё не пройденной части.
+int NestingIndex::searchBackward(int node, int lo, int hi, int to, int target, int &depth) const
+{
+    if (lo > to)
+        return -1;
+
+    const Summary &summary = tree.at(node);
+    if (hi <= to) {
+        int start = depth - summary.net;
+        if (summary.minBefore == Unset || start + summary.minBefore > target) {
+            depth = start;
+            return -1;
+        }
+        if (lo == hi)
+            return lo;
+    }
+
+    int mid = (lo + hi) / 2;
+    int found = searchBackward(2 * node + 1, mid + 1, hi, to, target, depth);
+    if (found >= 0)
+        return found;
+    return searchBackward(2 * node, lo, mid, to, target, depth);
+}
+
+
+NestingIndex::Match NestingIndex::closeAfter(int line, int depth) const
+{
+    Match match;
+    if (line >= lines.size())
+        return match;
+
+    int start = depthAt(line);
+    int found = searchForward(1, 0, lines.size() - 1, line, depth, start);
+    if (found < 0)
+        return match;
+
+    int running = depthAt(found);
+    for (const Bracket &bracket : lines.at(found).brackets) {
+        running += isOpen(bracket.ch) ? 1 : -1;
+        if (running <= depth) {
+            match.line = found;
+            match.column = bracket.column;
+            return match;
+        }
+    }
+    return match;
+}
+
+
+NestingIndex::Match NestingIndex::openBefore(int line, int depth) const
+{
+    Match match;
+    if (line < 0)
+        return match;
+
+    int end = depthAt(line + 1);
+    int found = searchBackward(1, 0, lines.size() - 1, line, depth, end);
+    if (found < 0)
+        return match;
+
+    int running = depthAt(found);
+    for (const Bracket &bracket : lines.at(found).brackets) {
+        if (running <= depth) {
+            match.line = found;
+            match.column = bracket.column;
+        }
+        running += isOpen(bracket.ch) ? 1 : -1;
+    }
+    return match;
+}
+
+
+const NestingIndex::Bracket *NestingIndex::bracketAt(int line, int column) const
+{
+    if (line < 0 || line >= lines.size())
+        return nullptr;
+    for (const Bracket &bracket : lines.at(line).brackets) {
+        if (bracket.column == column)
+            return &bracket;
+    }
+    return nullptr;
+}
+
+
+NestingIndex::Match NestingIndex::findMatch(int line, int column) const
+{
+    Match match;
+    const Bracket *target = bracketAt(line, column);
+    if (!target)
+        return match;
+
+    const QList<Bracket> &lineBrackets = lines.at(line).brackets;
+    int index = int(target - lineBrackets.constData());
+    int before = depthAt(line);
+    for (int i = 0; i < index; ++i)
+        before += isOpen(lineBrackets.at(i).ch) ? 1 : -1;
+
+    if (isOpen(target->ch)) {
+        // Парная — первая скобка, после которой глубина возвращается к before.
+        int running = before + 1;
+        for (int i = index + 1; i < lineBrackets.size() && !match.isValid(); ++i) {
+            running += isOpen(lineBrackets.at(i).ch) ? 1 : -1;
+            if (running <= before) {
+                match.line = line;
+                match.column = lineBrackets.at(i).column;
+            }
+        }
+        if (!match.isValid())
+            match = closeAfter(line + 1, before);
+    } else {
+        // Парная — последняя скобка, перед которой глубина была before - 1.
+        int depth = before - 1;
+        int running = depthAt(line);
+        for (int i = 0; i < index; ++i) {
+            if (running <= depth) {
+                match.line = line;
+                match.column = lineBrackets.at(i).column;
+            }
+            running += isOpen(lineBrackets.at(i).ch) ? 1 : -1;
+        }
+        if (!match.isValid())
+            match = openBefore(line - 1, depth);
+    }
+
+    if (match.isValid()) {
+        const Bracket *other = bracketAt(match.line, match.column);
+        match.matched = other && other->ch == pairOf(target->ch);
+    }
+    return match;
+}
+
+
+int NestingIndex::foldEnd(int line) const
+{
+    if (line < 0 || line >= lines.size())
+        return -1;
+
+    // Скобки, закрытые в этой же строке, не в счёт: сворачивается первая
+    // оставшаяся открытой '{'.
+    QVarLengthArray<int, 16> open;
+    const QList<Bracket> &lineBrackets = lines.at(line).brackets;
+    for (int i = 0; i < lineBrackets.size(); ++i) {
+        if (isOpen(lineBrackets.at(i).ch))
+            open.append(i);
+        else if (!open.isEmpty())
+            open.removeLast();
+    }
+
+    for (int i : open) {
+        if (lineBrackets.at(i).ch != '{')
+            continue;
+        Match match = findMatch(line, lineBrackets.at(i).column);
+        return match.isValid() && match.matched && match.line > line ? match.line : -1;
+    }
+    return -1;
+}
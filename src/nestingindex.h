@@ -0,0 +1,93 @@
+#ifndef NESTINGINDEX_H
+#define NESTINGINDEX_H
+
+#include <QChar>
+#include <QList>
+#include <QStringList>
+#include <limits>
+#include "cpplexer.h"
+
+// Скобки документа по строкам. Для каждой строки хранятся скобки вне
+// комментариев и литералов и сводка: насколько строка меняет глубину
+// вложенности и до какого минимума глубина опускается внутри неё. Сводки
+// собраны в дерево отрезков, поэтому глубина в начале строки и ближайшая
+// строка, где глубина падает ниже заданной, находятся за O(log n) без
+// прохода от начала файла. Глубина общая для (), [] и {}: парная скобка
+// ищется по ней, а несовпадение вида сообщается отдельно.
+//
+// Правка заменяет диапазон строк; заново разбираются только новые строки и
+// следующие за ними, пока у них меняется состояние лексера на входе.
+class NestingIndex
+{
+public:
+    struct Bracket
+    {
+        int column;
+        QChar ch;
+    };
+
+    struct Match
+    {
+        int line = -1;
+        int column = -1;
+        bool matched = false; // найдена скобка того же вида
+
+        bool isValid() const { return line >= 0; }
+    };
+
+    void replaceLines(int first, int removed, const QStringList &lines);
+    int lineCount() const { return lines.size(); }
+
+    const QList<Bracket> &brackets(int line) const { return lines.at(line).brackets; }
+    // Скобка, которая стоит в line ровно в column, или nullptr.
+    const Bracket *bracketAt(int line, int column) const;
+    // Глубина вложенности в начале строки.
+    int depthAt(int line) const;
+
+    // Парная скобка для скобки в (line, column).
+    Match findMatch(int line, int column) const;
+    // Строка с '}', парной первой '{', которая открывается в line и не
+    // закрывается в ней же; -1, если такой нет.
+    int foldEnd(int line) const;
+
+    static bool isOpen(QChar ch) { return ch == '(' || ch == '[' || ch == '{'; }
+    static bool isClose(QChar ch) { return ch == ')' || ch == ']' || ch == '}'; }
+    static QChar pairOf(QChar ch);
+
+private:
+    // Глубина отсчитывается от начала строки или узла; Unset — скобок нет.
+    static constexpr int Unset = std::numeric_limits<int>::max();
+
+    struct Summary
+    {
+        int net = 0;
+        int minAfter = Unset;  // минимум глубины после каждой скобки
+        int minBefore = Unset; // минимум глубины перед каждой скобкой
+    };
+
+    struct Line
+    {
+        QString text;
+        QList<Bracket> brackets;
+        Summary summary;
+        CppLexer::State startState;
+        CppLexer::State endState;
+        bool tokenized = false;
+    };
+
+    static Summary combine(const Summary &left, const Summary &right);
+    void tokenize(Line &line, const CppLexer::State &start);
+    void update(int line);
+    void rebuild() const;
+    void build(int node, int lo, int hi) const;
+    int searchForward(int node, int lo, int hi, int from, int target, int &depth) const;
+    int searchBackward(int node, int lo, int hi, int to, int target, int &depth) const;
+    Match closeAfter(int line, int depth) const;
+    Match openBefore(int line, int depth) const;
+
+    QList<Line> lines;
+    mutable QList<Summary> tree;
+    mutable bool treeValid = false;
+};
+
+#endif // NESTINGINDEX_H
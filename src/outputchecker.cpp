@@ -0,0 +1,318 @@
+#include "outputchecker.h"
+#include <QtMath>
+
+namespace {
+
+const int SnippetLimit = 200;
+
+bool isSpace(char c)
+{
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\v' || c == '\f';
+}
+
+QByteArray normalizeLineEnds(QByteArray text)
+{
+    return text.replace("\r\n", "\n");
+}
+
+}
+
+
+OutputChecker::Options OutputChecker::Options::fromJson(const QJsonObject &obj)
+{
+    Options options;
+    QString mode = obj.value("checker").toString();
+    if (mode == "tokens")
+        options.mode = Mode::Tokens;
+    else if (mode == "float")
+        options.mode = Mode::Float;
+
+    options.absTolerance = obj.value("absTolerance").toDouble(options.absTolerance);
+    options.relTolerance = obj.value("relTolerance").toDouble(options.relTolerance);
+    return options;
+}
+
+
+void OutputChecker::Options::writeJson(QJsonObject &obj) const
+{
+    switch (mode) {
+    case Mode::Exact:
+        obj["checker"] = "exact";
+        break;
+    case Mode::Tokens:
+        obj["checker"] = "tokens";
+        break;
+    case Mode::Float:
+        obj["checker"] = "float";
+        obj["absTolerance"] = absTolerance;
+        obj["relTolerance"] = relTolerance;
+        break;
+    }
+}
+
+
+QString OutputChecker::Options::modeName(Mode mode)
+{
+    switch (mode) {
+    case Mode::Exact:
+        return "Точное совпадение";
+    case Mode::Tokens:
+        return "По токенам";
+    case Mode::Float:
+        return "Числа с допуском";
+    }
+    return QString();
+}
+
+
+OutputChecker::OutputChecker(const QByteArray &expectedOutput, const Options &options)
+    : options(options),
+      expected(normalizeLineEnds(expectedOutput).trimmed())
+{
+    if (options.mode == Mode::Exact)
+        return;
+
+    qsizetype i = 0;
+    while (i < expected.size()) {
+        while (i < expected.size() && isSpace(expected.at(i)))
+            ++i;
+        qsizetype start = i;
+        while (i < expected.size() && !isSpace(expected.at(i)))
+            ++i;
+        if (i > start)
+            expectedTokens.append({start, i - start});
+    }
+}
+
+
+bool OutputChecker::feed(const QByteArray &chunk)
+{
+    return feed(chunk.constData(), chunk.size());
+}
+
+
+bool OutputChecker::feed(const char *data, qsizetype size)
+{
+    if (mismatch)
+        return false;
+
+    if (options.mode == Mode::Exact)
+        feedExact(data, size);
+    else
+        feedTokens(data, size);
+
+    return !mismatch;
+}
+
+
+bool OutputChecker::finish()
+{
+    if (mismatch)
+        return false;
+
+    if (options.mode == Mode::Exact) {
+        if (expectedPos < expected.size()) {
+            fail(line, column, expectedLineAt(expectedPos), currentLine,
+                 "Вывод закончился раньше ожидаемого.");
+        }
+    } else {
+        completeToken();
+        if (!mismatch && tokenIndex < expectedTokens.size()) {
+            const Token &wanted = expectedTokens.at(tokenIndex);
+            fail(line, column, expected.mid(wanted.offset, wanted.length), QByteArray(),
+                 QString("Вывод закончился, не хватает токенов начиная с №%1.").arg(tokenIndex + 1));
+        }
+    }
+
+    return !mismatch;
+}
+
+
+QString OutputChecker::report() const
+{
+    if (!mismatch)
+        return QString();
+
+    QString text = QString("Первое расхождение: строка %1, столбец %2.").arg(failLine).arg(failColumn);
+    if (!failReason.isEmpty())
+        text += "\n" + failReason;
+    text += "\nОжидалось: «" + QString::fromUtf8(failWanted) + "»";
+    text += "\nПолучено: «" + QString::fromUtf8(failActual) + "»";
+    return text;
+}
+
+
+void OutputChecker::feedExact(const char *data, qsizetype size)
+{
+    // Пробельные символы откладываются: в начале и в конце вывода они
+    // игнорируются, как и при прежнем сравнении после trimmed().
+    for (qsizetype i = 0; i < size; ++i) {
+        char c = data[i];
+
+        if (isSpace(c)) {
+            if (seenContent) {
+                if (pendingSpace.isEmpty()) {
+                    pendingLine = line;
+                    pendingColumn = column;
+                }
+                if (pendingSpace.size() <= expected.size() - expectedPos)
+                    pendingSpace += c;
+                else
+                    pendingOverflow = true;
+            }
+            advance(c);
+            continue;
+        }
+
+        if (!pendingSpace.isEmpty() || pendingOverflow) {
+            QByteArray space = normalizeLineEnds(pendingSpace);
+            qsizetype n = space.size();
+            if (pendingOverflow || expected.mid(expectedPos, n) != space) {
+                fail(pendingLine, pendingColumn, expectedLineAt(expectedPos),
+                     currentLine + actualLineTail(data, size, i), "Различаются пробельные символы.");
+                return;
+            }
+            expectedPos += n;
+            pendingSpace.clear();
+        }
+
+        seenContent = true;
+        if (expectedPos >= expected.size()) {
+            fail(line, column, QByteArray(), currentLine + actualLineTail(data, size, i),
+                 "Вывод длиннее ожидаемого.");
+            return;
+        }
+        if (expected.at(expectedPos) != c) {
+            fail(line, column, expectedLineAt(expectedPos), currentLine + actualLineTail(data, size, i),
+                 QString());
+            return;
+        }
+
+        ++expectedPos;
+        advance(c);
+    }
+}
+
+
+void OutputChecker::feedTokens(const char *data, qsizetype size)
+{
+    for (qsizetype i = 0; i < size && !mismatch; ++i) {
+        char c = data[i];
+
+        if (isSpace(c)) {
+            completeToken();
+            advance(c);
+            continue;
+        }
+
+        if (token.isEmpty() && !tokenOverflow) {
+            tokenLine = line;
+            tokenColumn = column;
+        }
+
+        // Токен длиннее ожидаемого заведомо не совпадёт, поэтому хранить его
+        // целиком незачем.
+        qsizetype limit = tokenIndex < expectedTokens.size() ? expectedTokens.at(tokenIndex).length : 0;
+        if (options.mode == Mode::Float)
+            limit = qMax<qsizetype>(limit, 64);
+        if (token.size() <= limit)
+            token += c;
+        else
+            tokenOverflow = true;
+
+        advance(c);
+    }
+}
+
+
+void OutputChecker::completeToken()
+{
+    if (token.isEmpty() && !tokenOverflow)
+        return;
+
+    if (tokenIndex >= expectedTokens.size()) {
+        fail(tokenLine, tokenColumn, QByteArray(), token, "Вывод содержит лишние токены.");
+    } else {
+        const Token &wanted = expectedTokens.at(tokenIndex);
+        QByteArray wantedText = expected.mid(wanted.offset, wanted.length);
+        if (tokenOverflow || !tokensMatch(token, wantedText)) {
+            QByteArray shown = tokenOverflow ? token + "..." : token;
+            fail(tokenLine, tokenColumn, wantedText, shown, QString("Токен №%1.").arg(tokenIndex + 1));
+        }
+    }
+
+    ++tokenIndex;
+    token.clear();
+    tokenOverflow = false;
+}
+
+
+bool OutputChecker::tokensMatch(const QByteArray &actual, const QByteArray &wanted) const
+{
+    if (actual == wanted)
+        return true;
+    if (options.mode != Mode::Float)
+        return false;
+
+    bool actualOk = false;
+    bool wantedOk = false;
+    double actualValue = actual.toDouble(&actualOk);
+    double wantedValue = wanted.toDouble(&wantedOk);
+    if (!actualOk || !wantedOk)
+        return false;
+
+    double diff = qAbs(actualValue - wantedValue);
+    return diff <= options.absTolerance || diff <= options.relTolerance * qAbs(wantedValue);
+}
+
+
+void OutputChecker::advance(char c)
+{
+    ++totalBytes;
+
+    if (c == '\n') {
+        ++line;
+        column = 1;
+        currentLine.clear();
+        return;
+    }
+
+    if ((uchar(c) & 0xC0) != 0x80)
+        ++column;
+    if (currentLine.size() < SnippetLimit)
+        currentLine += c;
+}
+
+
+void OutputChecker::fail(int atLine, int atColumn, const QByteArray &wanted, const QByteArray &actual,
+                         const QString &reason)
+{
+    mismatch = true;
+    failLine = atLine;
+    failColumn = atColumn;
+    failWanted = wanted.left(SnippetLimit);
+    failActual = actual.left(SnippetLimit);
+    failReason = reason;
+}
+
+
+QByteArray OutputChecker::expectedLineAt(qsizetype pos) const
+{
+    if (pos >= expected.size())
+        return QByteArray();
+
+    qsizetype start = pos > 0 ? expected.lastIndexOf('\n', pos - 1) + 1 : 0;
+    qsizetype end = expected.indexOf('\n', pos);
+    if (end < 0)
+        end = expected.size();
+    return expected.mid(start, qMin<qsizetype>(end - start, SnippetLimit));
+}
+
+
+QByteArray OutputChecker::actualLineTail(const char *data, qsizetype size, qsizetype from) const
+{
+    qsizetype end = from;
+    while (end < size && data[end] != '\n' && data[end] != '\r' && end - from < SnippetLimit)
+        ++end;
+    return QByteArray(data + from, end - from);
+}
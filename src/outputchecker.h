@@ -0,0 +1,88 @@
+#ifndef OUTPUTCHECKER_H
+#define OUTPUTCHECKER_H
+
+#include <QByteArray>
+#include <QJsonObject>
+#include <QList>
+#include <QString>
+
+// Сравнивает вывод программы с ожидаемым по мере поступления фрагментов,
+// не накапливая весь вывод. После первого расхождения feed() возвращает
+// false, и программу можно останавливать.
+class OutputChecker
+{
+public:
+    enum class Mode { Exact, Tokens, Float };
+
+    struct Options
+    {
+        Mode mode = Mode::Exact;
+        double absTolerance = 1e-6;
+        double relTolerance = 1e-6;
+
+        static Options fromJson(const QJsonObject &obj);
+        void writeJson(QJsonObject &obj) const;
+        static QString modeName(Mode mode);
+    };
+
+    explicit OutputChecker(const QByteArray &expected, const Options &options = Options());
+
+    bool feed(const QByteArray &chunk);
+    bool feed(const char *data, qsizetype size);
+    bool finish();
+
+    bool failed() const { return mismatch; }
+    qint64 bytesChecked() const { return totalBytes; }
+    int mismatchLine() const { return failLine; }
+    int mismatchColumn() const { return failColumn; }
+    QString report() const;
+
+private:
+    struct Token
+    {
+        qsizetype offset;
+        qsizetype length;
+    };
+
+    void feedExact(const char *data, qsizetype size);
+    void feedTokens(const char *data, qsizetype size);
+    void completeToken();
+    bool tokensMatch(const QByteArray &actual, const QByteArray &wanted) const;
+    void advance(char c);
+    void fail(int line, int column, const QByteArray &wanted, const QByteArray &actual, const QString &reason);
+    QByteArray expectedLineAt(qsizetype pos) const;
+    QByteArray actualLineTail(const char *data, qsizetype size, qsizetype from) const;
+
+    Options options;
+    QByteArray expected;
+    QList<Token> expectedTokens;
+
+    qint64 totalBytes = 0;
+    int line = 1;
+    int column = 1;
+    QByteArray currentLine;
+
+    // Exact
+    qsizetype expectedPos = 0;
+    bool seenContent = false;
+    QByteArray pendingSpace;
+    bool pendingOverflow = false;
+    int pendingLine = 1;
+    int pendingColumn = 1;
+
+    // Tokens, Float
+    int tokenIndex = 0;
+    QByteArray token;
+    bool tokenOverflow = false;
+    int tokenLine = 1;
+    int tokenColumn = 1;
+
+    bool mismatch = false;
+    int failLine = 0;
+    int failColumn = 0;
+    QByteArray failWanted;
+    QByteArray failActual;
+    QString failReason;
+};
+
+#endif // OUTPUTCHECKER_H
@@ -0,0 +1,232 @@
+#include "pchmanager.h"
+#include <QCryptographicHash>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QProcess>
+
+namespace {
+
+bool isStandardHeader(const QString &name)
+{
+    static const QSet<QString> headers = {
+        "bits/stdc++.h",
+        "algorithm", "any", "array", "atomic", "bit", "bitset", "cassert", "cctype", "cfloat",
+        "charconv", "chrono", "cinttypes", "climits", "clocale", "cmath", "compare", "complex",
+        "concepts", "condition_variable", "cstddef", "cstdint", "cstdio", "cstdlib", "cstring",
+        "ctime", "deque", "exception", "execution", "filesystem", "forward_list", "fstream",
+        "functional", "future", "initializer_list", "iomanip", "ios", "iosfwd", "iostream",
+        "istream", "iterator", "limits", "list", "locale", "map", "memory", "mutex", "new",
+        "numbers", "numeric", "optional", "ostream", "queue", "random", "ranges", "ratio",
+        "regex", "set", "shared_mutex", "span", "sstream", "stack", "stdexcept", "streambuf",
+        "string", "string_view", "thread", "tuple", "type_traits", "typeindex", "typeinfo",
+        "unordered_map", "unordered_set", "utility", "valarray", "variant", "vector",
+        "assert.h", "ctype.h", "limits.h", "math.h", "stdio.h", "stdlib.h", "string.h", "time.h"
+    };
+    return headers.contains(name);
+}
+
+}
+
+
+PchManager::PchManager(const QString &directory, QObject *parent)
+    : QObject(parent),
+      pchDir(directory)
+{
+    QDir dir(pchDir);
+    if (!dir.exists())
+        dir.mkpath(".");
+}
+
+
+QStringList PchManager::standardIncludes(const QByteArray &source)
+{
+    // Берётся только непрерывный префикс из стандартных #include: вынос этих
+    // заголовков в -include не меняет смысла программы.
+    QStringList includes;
+    bool inComment = false;
+
+    const QList<QByteArray> lines = source.split('\n');
+    for (const QByteArray &rawLine : lines) {
+        QByteArray line = rawLine.trimmed();
+
+        if (inComment) {
+            if (line.contains("*/"))
+                inComment = false;
+            continue;
+        }
+        if (line.isEmpty() || line.startsWith("//"))
+            continue;
+        if (line.startsWith("/*")) {
+            inComment = !line.contains("*/");
+            continue;
+        }
+        if (!line.startsWith('#'))
+            break;
+
+        QByteArray directive = line.mid(1).trimmed();
+        if (!directive.startsWith("include"))
+            break;
+
+        QByteArray target = directive.mid(7).trimmed();
+        int close = target.indexOf('>');
+        if (!target.startsWith('<') || close < 0)
+            break;
+
+        QString name = QString::fromLatin1(target.mid(1, close - 1)).trimmed();
+        if (!isStandardHeader(name))
+            break;
+        if (!includes.contains(name))
+            includes << name;
+    }
+
+    includes.sort();
+    return includes;
+}
+
+
+QString PchManager::prepareHeader(const QStringList &includes, const QString &compiler, const QStringList &flags)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    hash.addData(compiler.toUtf8());
+    hash.addData(QByteArray(1, '\0'));
+    hash.addData(flags.join('\x1f').toUtf8());
+    hash.addData(QByteArray(1, '\0'));
+    hash.addData(includes.join('\n').toUtf8());
+
+    QDir dir(QDir(pchDir).filePath(QString::fromLatin1(hash.result().toHex().left(16))));
+    if (!dir.exists())
+        dir.mkpath(".");
+
+    QString header = dir.filePath("pch.h");
+    if (!QFile::exists(header)) {
+        QFile file(header);
+        if (file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+            for (const QString &include : includes)
+                file.write("#include <" + include.toUtf8() + ">\n");
+        }
+    }
+
+    return header;
+}
+
+
+bool PchManager::isReady(const QString &header) const
+{
+    return !building.contains(header) && QFile::exists(header + ".gch");
+}
+
+
+void PchManager::build(const QString &header, const QString &compiler, const QStringList &flags)
+{
+    if (building.contains(header) || QFile::exists(header + ".gch"))
+        return;
+
+    building.insert(header);
+
+    // Компилятор пишет во временный файл, чтобы параллельные сборки никогда
+    // не увидели наполовину записанный .gch.
+    QString tempOutput = header + ".gch.tmp";
+    auto *process = new QProcess(this);
+    QElapsedTimer timer;
+    timer.start();
+    process->setWorkingDirectory(QFileInfo(header).path());
+
+    connect(process, &QProcess::finished, this,
+            [this, process, timer, header, tempOutput](int exitCode, QProcess::ExitStatus exitStatus) {
+        qint64 ms = timer.elapsed();
+        process->deleteLater();
+        building.remove(header);
+
+        bool ok = exitStatus == QProcess::NormalExit && exitCode == 0
+                  && QFile::rename(tempOutput, header + ".gch");
+        QFile::remove(tempOutput);
+
+        if (ok) {
+            timingFor(header).buildMs = ms;
+            saveTiming(header);
+        }
+        emit buildFinished(header, ok, ms);
+    });
+
+    connect(process, &QProcess::errorOccurred, this, [this, process, header](QProcess::ProcessError error) {
+        if (error != QProcess::FailedToStart)
+            return;
+        process->deleteLater();
+        building.remove(header);
+        emit buildFinished(header, false, 0);
+    });
+
+    process->start(compiler, QStringList() << flags << "-x" << "c++-header" << header << "-o" << tempOutput);
+}
+
+
+void PchManager::invalidate(const QString &header)
+{
+    QFile::remove(header + ".gch");
+    timingFor(header).buildMs = -1;
+    saveTiming(header);
+}
+
+
+void PchManager::recordPlainCompile(const QString &header, qint64 ms)
+{
+    timingFor(header).plainMs = ms;
+    saveTiming(header);
+}
+
+
+qint64 PchManager::plainCompileMs(const QString &header) const
+{
+    return storedTiming(header).plainMs;
+}
+
+
+qint64 PchManager::buildMs(const QString &header) const
+{
+    return storedTiming(header).buildMs;
+}
+
+
+PchManager::Timing &PchManager::timingFor(const QString &header)
+{
+    auto it = timings.find(header);
+    if (it != timings.end())
+        return it.value();
+    return timings.insert(header, storedTiming(header)).value();
+}
+
+
+// Замеры из памяти, а если заголовок ещё не встречался — из timing.json.
+PchManager::Timing PchManager::storedTiming(const QString &header) const
+{
+    auto it = timings.constFind(header);
+    if (it != timings.constEnd())
+        return it.value();
+
+    Timing timing;
+    QFile file(QFileInfo(header).dir().filePath("timing.json"));
+    if (file.open(QIODevice::ReadOnly)) {
+        QJsonObject obj = QJsonDocument::fromJson(file.readAll()).object();
+        timing.plainMs = obj.value("plainMs").toInteger(-1);
+        timing.buildMs = obj.value("buildMs").toInteger(-1);
+    }
+    return timing;
+}
+
+
+void PchManager::saveTiming(const QString &header) const
+{
+    Timing timing = timings.value(header);
+
+    QJsonObject obj;
+    obj["plainMs"] = timing.plainMs;
+    obj["buildMs"] = timing.buildMs;
+
+    QFile file(QFileInfo(header).dir().filePath("timing.json"));
+    if (file.open(QIODevice::WriteOnly))
+        file.write(QJsonDocument(obj).toJson(QJsonDocument::Compact));
+}
@@ -0,0 +1,48 @@
+#ifndef PCHMANAGER_H
+#define PCHMANAGER_H
+
+#include <QObject>
+#include <QHash>
+#include <QSet>
+#include <QStringList>
+
+// Предкомпилированные заголовки для набора стандартных #include в начале
+// исходника. Для каждой пары «набор заголовков + флаги» создаётся свой
+// каталог с pch.h и pch.h.gch; сборка идёт в фоне и не задерживает компиляцию.
+class PchManager : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit PchManager(const QString &directory, QObject *parent = nullptr);
+
+    static QStringList standardIncludes(const QByteArray &source);
+
+    QString prepareHeader(const QStringList &includes, const QString &compiler, const QStringList &flags);
+    bool isReady(const QString &header) const;
+    void build(const QString &header, const QString &compiler, const QStringList &flags);
+    void invalidate(const QString &header);
+
+    void recordPlainCompile(const QString &header, qint64 ms);
+    qint64 plainCompileMs(const QString &header) const;
+    qint64 buildMs(const QString &header) const;
+
+signals:
+    void buildFinished(const QString &header, bool ok, qint64 ms);
+
+private:
+    struct Timing {
+        qint64 plainMs = -1;
+        qint64 buildMs = -1;
+    };
+
+    Timing &timingFor(const QString &header);
+    Timing storedTiming(const QString &header) const;
+    void saveTiming(const QString &header) const;
+
+    QString pchDir;
+    QSet<QString> building;
+    QHash<QString, Timing> timings;
+};
+
+#endif // PCHMANAGER_H
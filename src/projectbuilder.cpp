@@ -0,0 +1,419 @@
+#include "projectbuilder.h"
+#include "compilejob.h"
+#include <QCryptographicHash>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QProcess>
+#include <QSaveFile>
+#include <QThread>
+#include <algorithm>
+
+namespace {
+
+// Список объектов последней удачной компоновки: удалённый или добавленный
+// исходник требует перекомпоновки, даже если ни один объект не изменился.
+const char LinkStampFile[] = "objects.txt";
+
+QString profileKey(const BuildProfile &profile)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(profile.compiler.toUtf8());
+    hash.addData(QByteArray(1, '\0'));
+    hash.addData(profile.compileFlags().join('\x1f').toUtf8());
+    return QString::fromLatin1(hash.result().toHex().left(12));
+}
+
+}
+
+const char ProjectBuilder::BuildDirName[] = ".pstu-build";
+
+
+ProjectBuilder::ProjectBuilder(const QString &directory, const BuildProfile &profile, QObject *parent)
+    : QObject(parent),
+      projectDir(QDir(directory).absolutePath()),
+      buildDir(QDir(projectDir).filePath(QString(BuildDirName) + "/" + profileKey(profile))),
+      profile(profile),
+      maxParallel(qMax(1, QThread::idealThreadCount()))
+{
+}
+
+
+bool ProjectBuilder::isSourceFile(const QString &filePath)
+{
+    static const QStringList suffixes = {"cpp", "cc", "cxx", "c++"};
+    return suffixes.contains(QFileInfo(filePath).suffix(), Qt::CaseInsensitive);
+}
+
+
+QStringList ProjectBuilder::parseDepFile(const QByteArray &text)
+{
+    // Нужно только первое правило "объект: исходник заголовки...". Строки
+    // продолжаются через "\", пробелы в путях экранированы "\ ", "$" — "$$".
+    // Двоеточие диска в Windows-пути не отделяется пробелом от остального пути.
+    // Пустые правила для заголовков, которые добавляет -MP, пропускаются.
+    const QString content = QString::fromLocal8Bit(text);
+    QStringList dependencies;
+    QString current;
+    bool afterColon = false;
+
+    auto flush = [&] {
+        if (afterColon && !current.isEmpty())
+            dependencies.append(current);
+        current.clear();
+    };
+
+    for (qsizetype i = 0; i < content.size(); ++i) {
+        QChar c = content.at(i);
+        QChar next = i + 1 < content.size() ? content.at(i + 1) : QChar();
+
+        if (c == '\\' && next == '\n') {
+            ++i;
+            flush();
+            continue;
+        }
+        if (c == '\\' && next == '\r' && i + 2 < content.size() && content.at(i + 2) == '\n') {
+            i += 2;
+            flush();
+            continue;
+        }
+        if (c == '\\' && (next == ' ' || next == '#')) {
+            current += next;
+            ++i;
+            continue;
+        }
+        if (c == '$' && next == '$') {
+            current += '$';
+            ++i;
+            continue;
+        }
+        if (c == '\n') {
+            flush();
+            if (afterColon)
+                break;
+            continue;
+        }
+        if (c.isSpace()) {
+            flush();
+            continue;
+        }
+        if (!afterColon && c == ':' && (next.isNull() || next.isSpace())) {
+            afterColon = true;
+            current.clear();
+            continue;
+        }
+        current += c;
+    }
+    flush();
+    return dependencies;
+}
+
+
+QString ProjectBuilder::statusName(UnitStatus status)
+{
+    switch (status) {
+    case UnitStatus::Stale:
+        return "Нужна сборка";
+    case UnitStatus::UpToDate:
+        return "Актуален";
+    case UnitStatus::Queued:
+        return "В очереди";
+    case UnitStatus::Compiling:
+        return "Компиляция";
+    case UnitStatus::Compiled:
+        return "Скомпилирован";
+    case UnitStatus::Failed:
+        return "Ошибка";
+    case UnitStatus::Cancelled:
+        return "Отменён";
+    }
+    return QString();
+}
+
+
+QString ProjectBuilder::executableFile() const
+{
+    QString name = QFileInfo(projectDir).fileName();
+    if (name.isEmpty())
+        name = "project";
+#ifdef Q_OS_WIN
+    return QDir(buildDir).filePath(name + ".exe");
+#else
+    return QDir(buildDir).filePath(name);
+#endif
+}
+
+
+bool ProjectBuilder::scan(QString *error)
+{
+    if (running)
+        return false;
+
+    items.clear();
+    const QString buildRoot = QDir(projectDir).filePath(BuildDirName) + "/";
+    QDirIterator it(projectDir, QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        QString path = it.next();
+        if (path.startsWith(buildRoot) || !isSourceFile(path))
+            continue;
+
+        Unit unit;
+        unit.source = path;
+        unit.relativePath = QDir(projectDir).relativeFilePath(path);
+        unit.object = QDir(buildDir).filePath(unit.relativePath + ".o");
+        unit.depFile = QDir(buildDir).filePath(unit.relativePath + ".d");
+        items.append(unit);
+    }
+    std::sort(items.begin(), items.end(), [](const Unit &a, const Unit &b) {
+        return a.relativePath < b.relativePath;
+    });
+
+    if (items.isEmpty()) {
+        if (error)
+            *error = "В папке " + QDir::toNativeSeparators(projectDir) + " нет исходников C++.";
+        return false;
+    }
+
+    // Общие заголовки проверяются один раз на весь проход.
+    QHash<QString, QDateTime> modified;
+    for (Unit &unit : items)
+        unit.status = isStale(unit, &modified) ? UnitStatus::Stale : UnitStatus::UpToDate;
+    return true;
+}
+
+
+int ProjectBuilder::staleCount() const
+{
+    int count = 0;
+    for (const Unit &unit : items) {
+        if (unit.status != UnitStatus::UpToDate && unit.status != UnitStatus::Compiled)
+            ++count;
+    }
+    return count;
+}
+
+
+bool ProjectBuilder::isStale(const Unit &unit, QHash<QString, QDateTime> *modified) const
+{
+    QFileInfo object(unit.object);
+    if (!object.exists())
+        return true;
+
+    QFile depFile(unit.depFile);
+    if (!depFile.open(QIODevice::ReadOnly))
+        return true;
+    const QStringList dependencies = parseDepFile(depFile.readAll());
+    if (dependencies.isEmpty())
+        return true;
+
+    // Относительные пути в depfile отсчитываются от каталога, в котором
+    // запускался компилятор, то есть от каталога исходника.
+    QDir sourceDir = QFileInfo(unit.source).dir();
+    QDateTime built = object.lastModified();
+    for (const QString &dependency : dependencies) {
+        QString path = sourceDir.absoluteFilePath(dependency);
+        auto it = modified->constFind(path);
+        if (it == modified->constEnd())
+            it = modified->insert(path, QFileInfo(path).lastModified());
+        // Невалидное время — файл удалён или переименован.
+        if (!it.value().isValid() || it.value() > built)
+            return true;
+    }
+    return false;
+}
+
+
+void ProjectBuilder::start()
+{
+    if (running)
+        return;
+
+    running = true;
+    if (items.isEmpty()) {
+        error = "Проект не просканирован или в нём нет исходников.";
+        QMetaObject::invokeMethod(this, [this] { finish(false); }, Qt::QueuedConnection);
+        return;
+    }
+
+    error.clear();
+    cancelled = false;
+    linked = false;
+    rebuilt = 0;
+    timer.start();
+
+    queue.clear();
+    for (int i = 0; i < items.size(); ++i) {
+        if (items.at(i).status != UnitStatus::Stale)
+            continue;
+        items[i].status = UnitStatus::Queued;
+        queue.append(i);
+        emit unitChanged(i);
+    }
+
+    emit message(QString("Сборка проекта %1: пересобрать %2 из %3 файлов.\n")
+                     .arg(QDir::toNativeSeparators(projectDir))
+                     .arg(queue.size())
+                     .arg(items.size()));
+    startCompiles();
+}
+
+
+void ProjectBuilder::cancel()
+{
+    if (!running)
+        return;
+
+    cancelled = true;
+    for (int index : std::as_const(queue)) {
+        items[index].status = UnitStatus::Cancelled;
+        emit unitChanged(index);
+    }
+    queue.clear();
+
+    const QList<CompileJob *> jobs = active;
+    for (CompileJob *job : jobs)
+        job->cancel();
+    if (linkProcess)
+        linkProcess->kill();
+    if (active.isEmpty() && !linkProcess)
+        finish(false);
+}
+
+
+void ProjectBuilder::startCompiles()
+{
+    while (!cancelled && active.size() < maxParallel && !queue.isEmpty()) {
+        int index = queue.takeFirst();
+        Unit &unit = items[index];
+        QDir().mkpath(QFileInfo(unit.object).path());
+        // Устаревший depfile от прошлой сборки не должен пережить неудачную.
+        QFile::remove(unit.depFile);
+
+        auto *job = new CompileJob(unit.source, unit.object, this);
+        job->setCompiler(profile.compiler);
+        job->setFlags(QStringList(profile.objectFlags()) << "-I" + projectDir << "-c" << "-MMD" << "-MP"
+                                                        << "-MF" << unit.depFile);
+        active.append(job);
+        unit.status = UnitStatus::Compiling;
+        emit unitChanged(index);
+
+        connect(job, &CompileJob::finished, this, [this, job, index](CompileJob::Status status) {
+            active.removeOne(job);
+            job->deleteLater();
+
+            Unit &unit = items[index];
+            unit.elapsedMs = job->elapsedMs();
+            unit.errorOutput = job->errorOutput();
+            if (status == CompileJob::Status::Succeeded) {
+                unit.status = UnitStatus::Compiled;
+                ++rebuilt;
+            } else {
+                unit.status = status == CompileJob::Status::Cancelled ? UnitStatus::Cancelled : UnitStatus::Failed;
+            }
+            emit unitChanged(index);
+            if (!unit.errorOutput.isEmpty() && status != CompileJob::Status::Cancelled)
+                emit message(unit.relativePath + ":\n" + unit.errorOutput);
+
+            startCompiles();
+        });
+
+        job->start();
+    }
+
+    if (!running || !active.isEmpty() || !queue.isEmpty() || linkProcess)
+        return;
+
+    if (cancelled) {
+        finish(false);
+        return;
+    }
+
+    // Как make -k: ошибка в одном файле не останавливает остальные, чтобы
+    // в таблице были видны все сломанные единицы сразу.
+    int failed = 0;
+    for (const Unit &unit : std::as_const(items)) {
+        if (unit.status == UnitStatus::Failed)
+            ++failed;
+    }
+    if (failed > 0) {
+        error = QString("Не скомпилировано файлов: %1 из %2.").arg(failed).arg(items.size());
+        finish(false);
+        return;
+    }
+    link();
+}
+
+
+void ProjectBuilder::link()
+{
+    QStringList objects;
+    for (const Unit &unit : std::as_const(items))
+        objects.append(unit.object);
+
+    QString executable = executableFile();
+    QFileInfo executableInfo(executable);
+    QFile stamp(QDir(buildDir).filePath(LinkStampFile));
+    bool needed = rebuilt > 0 || !executableInfo.exists() || !stamp.open(QIODevice::ReadOnly)
+                  || QString::fromUtf8(stamp.readAll()) != objects.join('\n');
+    for (int i = 0; !needed && i < objects.size(); ++i)
+        needed = QFileInfo(objects.at(i)).lastModified() > executableInfo.lastModified();
+    stamp.close();
+
+    if (!needed) {
+        emit message("Исполняемый файл актуален.\n");
+        finish(true);
+        return;
+    }
+
+    QFile::remove(executable);
+    linkProcess = new QProcess(this);
+    linkProcess->setWorkingDirectory(buildDir);
+    linkProcess->setProcessChannelMode(QProcess::MergedChannels);
+
+    auto done = [this, objects, executable] {
+        QProcess *process = linkProcess;
+        linkProcess = nullptr;
+        process->deleteLater();
+
+        QString output = QString::fromLocal8Bit(process->readAll());
+        if (!output.isEmpty())
+            emit message(output);
+
+        bool ok = !cancelled && process->error() != QProcess::FailedToStart
+                  && process->exitStatus() == QProcess::NormalExit && process->exitCode() == 0
+                  && QFile::exists(executable);
+        if (ok) {
+            linked = true;
+            QSaveFile newStamp(QDir(buildDir).filePath(LinkStampFile));
+            if (!newStamp.open(QIODevice::WriteOnly) || newStamp.write(objects.join('\n').toUtf8()) < 0
+                || !newStamp.commit())
+                emit message("Не удалось записать " + newStamp.fileName() + ".\n");
+        } else if (!cancelled) {
+            error = process->error() == QProcess::FailedToStart
+                        ? "Не удалось запустить компоновщик " + profile.compiler + ": " + process->errorString()
+                        : QString("Компоновка завершилась с ошибкой.");
+        }
+        finish(ok);
+    };
+    connect(linkProcess, &QProcess::finished, this, done);
+    connect(linkProcess, &QProcess::errorOccurred, this, [this, done](QProcess::ProcessError processError) {
+        if (processError == QProcess::FailedToStart && linkProcess)
+            done();
+    });
+
+    emit message("Компоновка " + QDir::toNativeSeparators(executable) + "...\n");
+    linkProcess->start(profile.compiler, QStringList(profile.linkFlags()) << objects << "-o" << executable);
+}
+
+
+void ProjectBuilder::finish(bool ok)
+{
+    if (!running)
+        return;
+
+    running = false;
+    if (timer.isValid())
+        elapsed = timer.elapsed();
+    emit finished(ok);
+}
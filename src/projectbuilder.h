@@ -0,0 +1,97 @@
+#ifndef PROJECTBUILDER_H
+#define PROJECTBUILDER_H
+
+#include <QObject>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QStringList>
+#include "buildprofile.h"
+
+class CompileJob;
+class QProcess;
+
+// Сборка папки с несколькими единицами трансляции. Каждый исходник
+// компилируется в свой объектный файл (параллельно, до числа ядер),
+// зависимости от заголовков берутся из depfile-ов, которые пишет -MMD.
+// Пересобираются только единицы, у которых объектный файл старше исходника
+// или любого из его заголовков; компоновка — только если изменился хотя бы
+// один объектный файл или их набор. Объекты каждого профиля сборки лежат в
+// своём подкаталоге .pstu-build, поэтому смена профиля не портит другие.
+class ProjectBuilder : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum class UnitStatus { Stale, UpToDate, Queued, Compiling, Compiled, Failed, Cancelled };
+
+    struct Unit
+    {
+        QString source;
+        QString relativePath;
+        QString object;
+        QString depFile;
+        UnitStatus status = UnitStatus::Stale;
+        qint64 elapsedMs = -1;
+        QString errorOutput;
+    };
+
+    static const char BuildDirName[];
+
+    ProjectBuilder(const QString &directory, const BuildProfile &profile, QObject *parent = nullptr);
+
+    static bool isSourceFile(const QString &filePath);
+    static QStringList parseDepFile(const QByteArray &text);
+    static QString statusName(UnitStatus status);
+
+    QString directory() const { return projectDir; }
+    QString buildDirectory() const { return buildDir; }
+    QString executableFile() const;
+
+    void setMaxParallel(int count) { maxParallel = qMax(1, count); }
+
+    // Находит исходники и отмечает устаревшие; вызывается перед start().
+    bool scan(QString *error = nullptr);
+    const QList<Unit> &units() const { return items; }
+    int staleCount() const;
+    int compiledCount() const { return rebuilt; }
+    bool isLinked() const { return linked; }
+    qint64 elapsedMs() const { return elapsed; }
+    bool isRunning() const { return running; }
+    bool wasCancelled() const { return cancelled; }
+    QString errorMessage() const { return error; }
+
+public slots:
+    void start();
+    void cancel();
+
+signals:
+    void unitChanged(int index);
+    void message(const QString &text);
+    void finished(bool ok);
+
+private:
+    bool isStale(const Unit &unit, QHash<QString, QDateTime> *modified) const;
+    void startCompiles();
+    void link();
+    void finish(bool ok);
+
+    QString projectDir;
+    QString buildDir;
+    BuildProfile profile;
+    int maxParallel;
+    QList<Unit> items;
+    QList<int> queue;
+    QList<CompileJob *> active;
+    QProcess *linkProcess = nullptr;
+    QElapsedTimer timer;
+    qint64 elapsed = 0;
+    int rebuilt = 0;
+    bool linked = false;
+    bool running = false;
+    bool cancelled = false;
+    QString error;
+};
+
+#endif // PROJECTBUILDER_H
@@ -0,0 +1,319 @@
+#include "referenceresolver.h"
+#include "compilejob.h"
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QProcess>
+#include <QSaveFile>
+#include <QThread>
+#include <QTimer>
+
+namespace {
+
+const char SourceHashFile[] = "source.sha256";
+
+// Эталон собирается во временный файл и переносится на место только
+// целиком: несколько резолверов (прогон всех тестов и одиночный запуск)
+// могут собирать и запускать один и тот же эталон одновременно. Если другой
+// успел раньше, его сборка ничем не хуже: имя файла задают исходник и
+// профиль сборки.
+bool installExecutable(const QString &built, const QString &executable)
+{
+    if (!QFile::rename(built, executable))
+        QFile::remove(built);
+    return QFile::exists(executable);
+}
+
+}
+
+
+ReferenceResolver::ReferenceResolver(const QList<TestDefinition> &tests, const BuildProfile &profile, QObject *parent)
+    : QObject(parent),
+      resolved(tests),
+      profile(profile),
+      cacheDir(defaultDirectory()),
+      maxParallel(qMax(1, QThread::idealThreadCount()))
+{
+}
+
+
+bool ReferenceResolver::isNeeded(const QList<TestDefinition> &tests)
+{
+    for (const TestDefinition &test : tests) {
+        if (!test.reference.isEmpty())
+            return true;
+    }
+    return false;
+}
+
+
+QString ReferenceResolver::defaultDirectory()
+{
+    return QCoreApplication::applicationDirPath() + "/reference";
+}
+
+
+void ReferenceResolver::start()
+{
+    if (running)
+        return;
+    running = true;
+
+    for (int testIndex = 0; testIndex < resolved.size(); ++testIndex) {
+        TestDefinition &test = resolved[testIndex];
+        if (test.reference.isEmpty())
+            continue;
+
+        QString source = test.referencePath();
+        auto it = references.find(source);
+        if (it == references.end()) {
+            Reference reference;
+            if (!prepareReference(source, &reference)) {
+                error = QString("Тест \"%1\": %2").arg(test.name, error);
+                QMetaObject::invokeMethod(this, [this] { finish(false); }, Qt::QueuedConnection);
+                return;
+            }
+            it = references.insert(source, reference);
+        }
+
+        for (int caseIndex = 0; caseIndex < test.cases.size(); ++caseIndex) {
+            TestCase &testCase = test.cases[caseIndex];
+            QString key = outputKey(it.value(), testCase.input);
+            QFile output(QDir(it->directory).filePath(key + ".out"));
+            if (output.open(QIODevice::ReadOnly)) {
+                testCase.expected = output.readAll();
+                ++cached;
+                continue;
+            }
+            pendingByReference[source].append({testIndex, caseIndex, key});
+        }
+    }
+
+    if (pendingByReference.isEmpty()) {
+        QMetaObject::invokeMethod(this, [this] { finish(true); }, Qt::QueuedConnection);
+        return;
+    }
+    compileReferences();
+}
+
+
+void ReferenceResolver::cancel()
+{
+    if (!running)
+        return;
+
+    cancelled = true;
+    for (const Reference &reference : std::as_const(references)) {
+        if (reference.job)
+            reference.job->cancel();
+    }
+    queue.clear();
+    const QList<QProcess *> processes = active;
+    for (QProcess *process : processes)
+        process->kill();
+    if (compiling == 0 && active.isEmpty())
+        finish(false);
+}
+
+
+bool ReferenceResolver::prepareReference(const QString &source, Reference *reference)
+{
+    QFile file(source);
+    if (!file.open(QIODevice::ReadOnly)) {
+        error = "не удалось открыть эталонное решение " + source + ".";
+        return false;
+    }
+
+    reference->source = source;
+    reference->sourceHash = QCryptographicHash::hash(file.readAll(), QCryptographicHash::Sha256).toHex();
+
+    QByteArray pathHash = QCryptographicHash::hash(QFileInfo(source).absoluteFilePath().toUtf8(),
+                                                   QCryptographicHash::Sha1).toHex().left(16);
+    QDir dir(QDir(cacheDir).filePath(QString::fromLatin1(pathHash)));
+    reference->directory = dir.path();
+    QString build = profile.compiler + '\0' + profile.compileFlags().join('\x1f');
+    QByteArray buildHash = QCryptographicHash::hash(build.toUtf8(), QCryptographicHash::Sha1).toHex().left(16);
+    QString name = "reference-" + QString::fromLatin1(buildHash);
+#ifdef Q_OS_WIN
+    name += ".exe";
+#endif
+    reference->executable = dir.filePath(name);
+
+    // Выводы старой версии эталона больше не нужны ни одному ключу.
+    QFile stamp(dir.filePath(SourceHashFile));
+    if (stamp.open(QIODevice::ReadOnly) && stamp.readAll().trimmed() == reference->sourceHash)
+        return true;
+    stamp.close();
+
+    dir.removeRecursively();
+    if (!dir.mkpath(".")) {
+        error = "не удалось создать каталог " + dir.path() + ".";
+        return false;
+    }
+    QSaveFile newStamp(dir.filePath(SourceHashFile));
+    if (!newStamp.open(QIODevice::WriteOnly) || newStamp.write(reference->sourceHash) < 0 || !newStamp.commit()) {
+        error = "не удалось записать " + newStamp.fileName() + ".";
+        return false;
+    }
+    return true;
+}
+
+
+QString ReferenceResolver::outputKey(const Reference &reference, const QByteArray &input) const
+{
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    hash.addData(reference.sourceHash);
+    hash.addData(QByteArray(1, '\0'));
+    hash.addData(profile.compiler.toUtf8());
+    hash.addData(QByteArray(1, '\0'));
+    hash.addData(profile.compileFlags().join('\x1f').toUtf8());
+    hash.addData(QByteArray(1, '\0'));
+    hash.addData(input);
+    return QString::fromLatin1(hash.result().toHex());
+}
+
+
+void ReferenceResolver::compileReferences()
+{
+    const QStringList sources = pendingByReference.keys();
+    for (const QString &source : sources) {
+        Reference &reference = references[source];
+        static int buildCount = 0;
+        QString target = reference.executable
+                         + QString(".%1-%2.tmp").arg(QCoreApplication::applicationPid()).arg(++buildCount);
+        auto *job = new CompileJob(reference.source, target, this);
+        job->setCompiler(profile.compiler);
+        job->setFlags(profile.compileFlags());
+        job->setCache(compileCache);
+        reference.job = job;
+        ++compiling;
+
+        connect(job, &CompileJob::finished, this, [this, job, source](CompileJob::Status status) {
+            references[source].job = nullptr;
+            job->deleteLater();
+            --compiling;
+
+            if (cancelled) {
+                QFile::remove(job->executableFile());
+                if (compiling == 0 && active.isEmpty())
+                    finish(false);
+                return;
+            }
+            if (status != CompileJob::Status::Succeeded) {
+                QFile::remove(job->executableFile());
+                error = "Не удалось скомпилировать эталонное решение " + source + ":\n" + job->errorOutput();
+                cancel();
+                return;
+            }
+            const QString executable = references[source].executable;
+            if (!installExecutable(job->executableFile(), executable)) {
+                error = "Не удалось сохранить эталонное решение в " + executable + ".";
+                cancel();
+                return;
+            }
+
+            queue += pendingByReference.value(source);
+            startRuns();
+        });
+
+        emit message("Компиляция эталонного решения " + QDir::toNativeSeparators(source) + "...\n");
+        job->start();
+    }
+}
+
+
+void ReferenceResolver::startRuns()
+{
+    while (!cancelled && active.size() < maxParallel && !queue.isEmpty()) {
+        Pending pending = queue.takeFirst();
+        const TestDefinition &test = resolved.at(pending.testIndex);
+        const TestCase &testCase = test.cases.at(pending.caseIndex);
+        const Reference &reference = references[test.referencePath()];
+
+        auto *process = new QProcess(this);
+        auto *timer = new QTimer(process);
+        timer->setSingleShot(true);
+        process->setWorkingDirectory(QFileInfo(reference.executable).path());
+        active.append(process);
+
+        connect(timer, &QTimer::timeout, process, &QProcess::kill);
+        connect(process, &QProcess::started, this, [process, timer, testCase] {
+            timer->start(testCase.limits.timeLimitMs);
+            process->write(testCase.input);
+            process->closeWriteChannel();
+        });
+        connect(process, &QProcess::finished, this, [this, process, timer, pending] {
+            bool timedOut = !timer->isActive();
+            timer->stop();
+            runFinished(process, pending, timedOut);
+        });
+        connect(process, &QProcess::errorOccurred, this, [this, process, pending](QProcess::ProcessError processError) {
+            if (processError == QProcess::FailedToStart)
+                runFinished(process, pending, false);
+        });
+
+        process->start(reference.executable, QStringList());
+    }
+
+    if (running && active.isEmpty() && queue.isEmpty() && compiling == 0)
+        finish(!cancelled);
+}
+
+
+void ReferenceResolver::runFinished(QProcess *process, const Pending &pending, bool timedOut)
+{
+    if (!active.removeOne(process))
+        return;
+    process->deleteLater();
+
+    TestDefinition &test = resolved[pending.testIndex];
+    if (!cancelled) {
+        bool failed = process->error() == QProcess::FailedToStart
+                      || process->exitStatus() != QProcess::NormalExit || process->exitCode() != 0;
+        if (failed) {
+            QString reason;
+            if (process->error() == QProcess::FailedToStart)
+                reason = "не запустилось: " + process->errorString();
+            else if (timedOut)
+                reason = QString("не завершилось за %1 мс").arg(test.cases.at(pending.caseIndex).limits.timeLimitMs);
+            else
+                reason = QString("завершилось с кодом %1").arg(process->exitCode());
+            error = QString("Эталонное решение теста \"%1\" на случае %2 %3.")
+                        .arg(test.name)
+                        .arg(pending.caseIndex + 1)
+                        .arg(reason);
+            QByteArray errorOutput = process->readAllStandardError().trimmed();
+            if (!errorOutput.isEmpty())
+                error += "\n" + QString::fromLocal8Bit(errorOutput);
+            cancel();
+            return;
+        }
+
+        QByteArray output = process->readAllStandardOutput();
+        test.cases[pending.caseIndex].expected = output;
+        ++computed;
+
+        QSaveFile file(QDir(references[test.referencePath()].directory).filePath(pending.key + ".out"));
+        if (!file.open(QIODevice::WriteOnly) || file.write(output) < 0 || !file.commit())
+            emit message("Не удалось сохранить вывод эталона в " + file.fileName() + ".\n");
+    }
+
+    if (cancelled) {
+        if (compiling == 0 && active.isEmpty())
+            finish(false);
+        return;
+    }
+    startRuns();
+}
+
+
+void ReferenceResolver::finish(bool ok)
+{
+    if (!running)
+        return;
+
+    running = false;
+    emit finished(ok);
+}
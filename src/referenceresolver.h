@@ -0,0 +1,90 @@
+#ifndef REFERENCERESOLVER_H
+#define REFERENCERESOLVER_H
+
+#include <QObject>
+#include <QHash>
+#include <QList>
+#include "testdefinition.h"
+#include "buildprofile.h"
+
+class CompileCache;
+class CompileJob;
+class QProcess;
+
+// Заполняет ожидаемый вывод случаев тех тестов, которые ссылаются на
+// эталонное решение. Выводы хранятся в каталоге reference: у каждого
+// эталона свой подкаталог, файл вывода назван хешем исходника эталона,
+// входа и профиля сборки, исполняемый файл — хешем профиля. Эталон
+// компилируется и запускается только на входах без сохранённого вывода;
+// когда его исходник меняется, все старые выводы этого эталона удаляются.
+class ReferenceResolver : public QObject
+{
+    Q_OBJECT
+
+public:
+    ReferenceResolver(const QList<TestDefinition> &tests, const BuildProfile &profile, QObject *parent = nullptr);
+
+    static bool isNeeded(const QList<TestDefinition> &tests);
+    static QString defaultDirectory();
+
+    void setDirectory(const QString &directory) { cacheDir = directory; }
+    void setCompileCache(CompileCache *cache) { compileCache = cache; }
+    void setMaxParallel(int count) { maxParallel = qMax(1, count); }
+
+    const QList<TestDefinition> &tests() const { return resolved; }
+    int cachedCount() const { return cached; }
+    int computedCount() const { return computed; }
+    bool isRunning() const { return running; }
+    bool wasCancelled() const { return cancelled; }
+    QString errorMessage() const { return error; }
+
+public slots:
+    void start();
+    void cancel();
+
+signals:
+    void message(const QString &text);
+    void finished(bool ok);
+
+private:
+    struct Reference
+    {
+        QString source;
+        QString directory;
+        QByteArray sourceHash;
+        QString executable;
+        CompileJob *job = nullptr;
+    };
+
+    struct Pending
+    {
+        int testIndex;
+        int caseIndex;
+        QString key;
+    };
+
+    bool prepareReference(const QString &source, Reference *reference);
+    QString outputKey(const Reference &reference, const QByteArray &input) const;
+    void compileReferences();
+    void startRuns();
+    void runFinished(QProcess *process, const Pending &pending, bool timedOut);
+    void finish(bool ok);
+
+    QList<TestDefinition> resolved;
+    BuildProfile profile;
+    QString cacheDir;
+    CompileCache *compileCache = nullptr;
+    int maxParallel;
+    QHash<QString, Reference> references;
+    QHash<QString, QList<Pending>> pendingByReference;
+    QList<Pending> queue;
+    QList<QProcess *> active;
+    int compiling = 0;
+    int cached = 0;
+    int computed = 0;
+    bool running = false;
+    bool cancelled = false;
+    QString error;
+};
+
+#endif // REFERENCERESOLVER_H
@@ -0,0 +1,232 @@
+#include "resourcelimits.h"
+#include <QProcess>
+
+#ifdef Q_OS_LINUX
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/prctl.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+struct UsageRecord
+{
+    int status;
+    long long userUs;
+    long long systemUs;
+    long long maxRssKb;
+};
+
+void setLimit(int resource, rlim_t value)
+{
+    struct rlimit limit;
+    limit.rlim_cur = value;
+    limit.rlim_max = value;
+    setrlimit(resource, &limit);
+}
+
+// Закрывает все дескрипторы от first и выше, кроме keep.
+void closeDescriptorsExcept(int first, int keep)
+{
+#ifdef SYS_close_range
+    // close_range есть начиная с Linux 5.9, на старых ядрах — обход по одному.
+    if (syscall(SYS_close_range, unsigned(qMax(first, keep + 1)), ~0u, 0u) == 0) {
+        if (keep > first)
+            syscall(SYS_close_range, unsigned(first), unsigned(keep - 1), 0u);
+        return;
+    }
+#endif
+    struct rlimit limit;
+    rlim_t end = 1024;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY)
+        end = limit.rlim_cur;
+    for (rlim_t fd = rlim_t(first); fd < end; ++fd) {
+        if (int(fd) != keep)
+            close(int(fd));
+    }
+}
+
+// Выполняется в дочернем процессе между fork() и exec(), поэтому здесь
+// допустимы только async-signal-safe вызовы.
+void superviseChild(const ResourceLimits &limits, int usageFd)
+{
+    pid_t supervisor = getpid();
+    signal(SIGCHLD, SIG_DFL);
+
+    pid_t pid = fork();
+    if (pid < 0)
+        return;
+
+    if (pid == 0) {
+        prctl(PR_SET_PDEATHSIG, SIGKILL);
+        if (getppid() != supervisor)
+            _exit(127);
+
+        sigset_t mask;
+        sigemptyset(&mask);
+        sigprocmask(SIG_SETMASK, &mask, nullptr);
+
+        if (limits.cpuLimitMs > 0)
+            setLimit(RLIMIT_CPU, rlim_t((limits.cpuLimitMs + 999) / 1000));
+        if (limits.memoryLimitMb > 0 && limits.limitAddressSpace)
+            setLimit(RLIMIT_AS, rlim_t(limits.memoryLimitMb) * 1024 * 1024);
+        if (limits.outputLimitKb > 0)
+            setLimit(RLIMIT_FSIZE, rlim_t(limits.outputLimitKb) * 1024);
+        if (limits.processLimit > 0)
+            setLimit(RLIMIT_NPROC, rlim_t(limits.processLimit));
+        setLimit(RLIMIT_CORE, 0);
+
+        if (limits.pinnedCpu >= 0 && limits.pinnedCpu < CPU_SETSIZE) {
+            cpu_set_t cpus;
+            CPU_ZERO(&cpus);
+            CPU_SET(limits.pinnedCpu, &cpus);
+            sched_setaffinity(0, sizeof(cpus), &cpus);
+        }
+        return;
+    }
+
+    // Промежуточный процесс не должен держать открытыми каналы программы,
+    // иначе QProcess не увидит конец вывода раньше его завершения. Это
+    // касается и служебного канала запуска с O_CLOEXEC: промежуточный
+    // процесс не вызывает exec, и пока канал открыт у него, QProcess не
+    // выдаёт started — не запускает таймер и не пишет в stdin.
+    close(STDIN_FILENO);
+    close(STDOUT_FILENO);
+    close(STDERR_FILENO);
+    closeDescriptorsExcept(STDERR_FILENO + 1, usageFd);
+
+    int status = 0;
+    struct rusage usage;
+    while (wait4(pid, &status, 0, &usage) < 0) {
+        if (errno != EINTR)
+            _exit(127);
+    }
+
+    UsageRecord record;
+    record.status = status;
+    record.userUs = (long long)usage.ru_utime.tv_sec * 1000000 + usage.ru_utime.tv_usec;
+    record.systemUs = (long long)usage.ru_stime.tv_sec * 1000000 + usage.ru_stime.tv_usec;
+    record.maxRssKb = usage.ru_maxrss;
+    ssize_t written = write(usageFd, &record, sizeof(record));
+    (void)written;
+
+    if (WIFSIGNALED(status)) {
+        int sig = WTERMSIG(status);
+        setLimit(RLIMIT_CORE, 0);
+        signal(sig, SIG_DFL);
+        sigset_t mask;
+        sigemptyset(&mask);
+        sigprocmask(SIG_SETMASK, &mask, nullptr);
+        kill(getpid(), sig);
+    }
+    _exit(WIFEXITED(status) ? WEXITSTATUS(status) : 127);
+}
+
+}
+#endif
+
+
+ResourceLimits ResourceLimits::fromJson(const QJsonObject &obj, const ResourceLimits &defaults)
+{
+    ResourceLimits limits;
+    limits.timeLimitMs = obj.value("timeLimit").toInt(defaults.timeLimitMs);
+    limits.cpuLimitMs = obj.value("cpuLimit").toInt(defaults.cpuLimitMs);
+    limits.memoryLimitMb = obj.value("memoryLimit").toInt(defaults.memoryLimitMb);
+    limits.outputLimitKb = obj.value("outputLimit").toInt(defaults.outputLimitKb);
+    limits.processLimit = obj.value("processLimit").toInt(defaults.processLimit);
+    if (limits.timeLimitMs <= 0)
+        limits.timeLimitMs = defaults.timeLimitMs;
+    return limits;
+}
+
+
+void ResourceLimits::writeJson(QJsonObject &obj, const ResourceLimits *defaults) const
+{
+    // С defaults записываются только поля, отличающиеся от общих значений теста.
+    if (!defaults || timeLimitMs != defaults->timeLimitMs)
+        obj["timeLimit"] = timeLimitMs;
+    if (!defaults || cpuLimitMs != defaults->cpuLimitMs)
+        obj["cpuLimit"] = cpuLimitMs;
+    if (!defaults || memoryLimitMb != defaults->memoryLimitMb)
+        obj["memoryLimit"] = memoryLimitMb;
+    if (!defaults || outputLimitKb != defaults->outputLimitKb)
+        obj["outputLimit"] = outputLimitKb;
+    if (!defaults || processLimit != defaults->processLimit)
+        obj["processLimit"] = processLimit;
+}
+
+
+ResourceMonitor::ResourceMonitor()
+{
+}
+
+
+ResourceMonitor::~ResourceMonitor()
+{
+#ifdef Q_OS_LINUX
+    if (readFd >= 0)
+        close(readFd);
+    if (writeFd >= 0)
+        close(writeFd);
+#endif
+}
+
+
+void ResourceMonitor::attach(QProcess *process, const ResourceLimits &limits)
+{
+#ifdef Q_OS_LINUX
+    int fds[2];
+    if (pipe2(fds, O_CLOEXEC | O_NONBLOCK) != 0)
+        return;
+
+    readFd = fds[0];
+    writeFd = fds[1];
+
+    int usageFd = writeFd;
+    process->setChildProcessModifier([limits, usageFd] {
+        superviseChild(limits, usageFd);
+    });
+#else
+    Q_UNUSED(process);
+    Q_UNUSED(limits);
+#endif
+}
+
+
+void ResourceMonitor::processStarted()
+{
+#ifdef Q_OS_LINUX
+    if (writeFd >= 0) {
+        close(writeFd);
+        writeFd = -1;
+    }
+#endif
+}
+
+
+ResourceUsage ResourceMonitor::collect()
+{
+    ResourceUsage result;
+#ifdef Q_OS_LINUX
+    if (readFd < 0)
+        return result;
+
+    UsageRecord record;
+    if (read(readFd, &record, sizeof(record)) != ssize_t(sizeof(record)))
+        return result;
+
+    result.valid = true;
+    result.userUs = record.userUs;
+    result.systemUs = record.systemUs;
+    result.userMs = record.userUs / 1000;
+    result.systemMs = record.systemUs / 1000;
+    result.peakRssKb = record.maxRssKb;
+    result.signal = WIFSIGNALED(record.status) ? WTERMSIG(record.status) : 0;
+#endif
+    return result;
+}
@@ -0,0 +1,64 @@
+#ifndef RESOURCELIMITS_H
+#define RESOURCELIMITS_H
+
+#include <QJsonObject>
+
+class QProcess;
+
+// Ограничения для одного запуска. Ноль означает «без ограничения»;
+// timeLimitMs (реальное время) действует всегда и на всех платформах.
+struct ResourceLimits
+{
+    int timeLimitMs = 10000;
+    int cpuLimitMs = 0;
+    int memoryLimitMb = 0;
+    int outputLimitKb = 0;
+    // RLIMIT_NPROC: ядро считает все процессы пользователя, а не только
+    // запущенную программу и её потомков, поэтому лимит должен оставлять
+    // запас на уже работающие процессы (в том числе на саму среду).
+    int processLimit = 0;
+
+    // Не сохраняется в файл теста. AddressSanitizer резервирует терабайты
+    // адресного пространства, поэтому для таких сборок память проверяется
+    // только по пиковому RSS.
+    bool limitAddressSpace = true;
+    // Не сохраняется. Номер ядра, к которому привязывается программа (Linux); -1 — без привязки.
+    int pinnedCpu = -1;
+
+    static ResourceLimits fromJson(const QJsonObject &obj, const ResourceLimits &defaults = ResourceLimits());
+    void writeJson(QJsonObject &obj, const ResourceLimits *defaults = nullptr) const;
+};
+
+struct ResourceUsage
+{
+    bool valid = false;
+    qint64 userMs = -1;
+    qint64 systemMs = -1;
+    qint64 userUs = -1;
+    qint64 systemUs = -1;
+    qint64 peakRssKb = -1;
+    int signal = 0;
+
+    qint64 cpuMs() const { return valid ? userMs + systemMs : -1; }
+    qint64 cpuUs() const { return valid ? userUs + systemUs : -1; }
+};
+
+// Запускает процесс через промежуточный fork: внук получает setrlimit и
+// выполняет программу, а промежуточный процесс ждёт его через wait4() и
+// передаёт rusage по каналу. Вне Linux ничего не делает.
+class ResourceMonitor
+{
+public:
+    ResourceMonitor();
+    ~ResourceMonitor();
+
+    void attach(QProcess *process, const ResourceLimits &limits);
+    void processStarted();
+    ResourceUsage collect();
+
+private:
+    int readFd = -1;
+    int writeFd = -1;
+};
+
+#endif // RESOURCELIMITS_H
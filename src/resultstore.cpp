@@ -0,0 +1,450 @@
+#include "resultstore.h"
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QTimer>
+#include <QtConcurrent>
+#include <QtEndian>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+const char Magic[8] = {'P', 'S', 'T', 'U', 'R', 'S', 'L', 'T'};
+const quint32 FormatVersion = 1;
+
+// Magic, версия и размер записи.
+const qint64 HeaderSize = 8 + 4 + 4;
+
+// Время записи, хеш исходника, номера файла, профиля и теста, номер
+// случая, вердикт, резерв, время, CPU и пик памяти.
+const qint64 RecordSize = 8 + ResultStore::SourceHashSize + 4 + 4 + 4 + 2 + 1 + 1 + 8 + 8 + 8;
+
+const char LogFileName[] = "results.log";
+const char NamesFileName[] = "names.txt";
+const char LockFileName[] = "results.lock";
+
+// Запуск всех тестов даёт сотни записей подряд: они копятся и уходят на
+// диск одной пачкой, но не дольше этой паузы и не больше MaxBatchRecords.
+const int FlushDelayMs = 500;
+const int MaxBatchRecords = 4096;
+
+quint64 statsKey(quint32 testId, quint16 caseIndex)
+{
+    return (quint64(testId) << 16) | caseIndex;
+}
+
+}
+
+
+quint32 ResultStore::Data::intern(const QString &name, bool *added)
+{
+    // Словарь построчный, поэтому переводы строк в именах заменяются.
+    QString line = name;
+    line.replace('\n', ' ').replace('\r', ' ');
+
+    auto it = nameIds.constFind(line);
+    if (it != nameIds.constEnd()) {
+        if (added)
+            *added = false;
+        return it.value();
+    }
+
+    quint32 id = quint32(names.size());
+    names.append(line);
+    nameIds.insert(line, id);
+    if (added)
+        *added = true;
+    return id;
+}
+
+
+void ResultStore::Data::add(const Row &row)
+{
+    int index = rows.size();
+    rows.append(row);
+
+    Stats &caseStats = stats[statsKey(row.testId, row.caseIndex)];
+    ++caseStats.runs;
+    if (row.verdict != quint8(TestResult::Verdict::Passed))
+        ++caseStats.failures;
+    else if (caseStats.fastestRow < 0 || row.wallUs < rows.at(caseStats.fastestRow).wallUs)
+        caseStats.fastestRow = index;
+
+    pathRows[row.pathId].append(index);
+}
+
+
+QString ResultStore::Data::name(quint32 id) const
+{
+    return id < quint32(names.size()) ? names.at(id) : QString("?");
+}
+
+
+ResultStore::ResultStore(const QString &directory, QObject *parent)
+    : QObject(parent),
+      storeDir(directory),
+      lockFile(QDir(directory).filePath(LockFileName)),
+      flushTimer(new QTimer(this))
+{
+    // Блокировка держится, пока открыто хранилище, поэтому устаревшей она
+    // считается только после смерти владельца, а не по возрасту файла.
+    QDir().mkpath(storeDir);
+    lockFile.setStaleLockTime(0);
+    bool owner = lockFile.tryLock(0);
+
+    flushTimer->setSingleShot(true);
+    flushTimer->setInterval(FlushDelayMs);
+
+    connect(flushTimer, &QTimer::timeout, this, &ResultStore::flush);
+    connect(&loadWatcher, &QFutureWatcher<Data>::finished, this, &ResultStore::applyLoad);
+    connect(&writeWatcher, &QFutureWatcher<QString>::finished, this, &ResultStore::writeFinished);
+
+    loadWatcher.setFuture(QtConcurrent::run(&ResultStore::load, storeDir, owner));
+}
+
+
+ResultStore::~ResultStore()
+{
+    blockSignals(true);
+    loadWatcher.waitForFinished();
+    if (!loaded)
+        applyLoad();
+    writeWatcher.waitForFinished();
+    if (data.writable && !pendingRecords.isEmpty())
+        writeBatch(storeDir, pendingNames, pendingRecords);
+}
+
+
+QString ResultStore::defaultDirectory()
+{
+    return QCoreApplication::applicationDirPath() + "/results";
+}
+
+
+QByteArray ResultStore::hashSource(const QByteArray &code)
+{
+    return QCryptographicHash::hash(code, QCryptographicHash::Sha256).left(SourceHashSize);
+}
+
+
+void ResultStore::record(const QByteArray &sourceHash, const QString &sourcePath, const QString &profile,
+                         const QString &test, const TestResult &result)
+{
+    if (result.verdict == TestResult::Verdict::Cancelled)
+        return;
+
+    Run run;
+    run.timestampMs = QDateTime::currentMSecsSinceEpoch();
+    run.sourceHash = sourceHash;
+    run.sourcePath = sourcePath;
+    run.profile = profile;
+    run.test = test;
+    run.caseIndex = result.caseIndex;
+    run.verdict = result.verdict;
+    run.wallUs = result.wallUs > 0 ? result.wallUs : result.wallMs * 1000;
+    run.cpuUs = result.usage.cpuUs();
+    run.peakRssKb = result.usage.valid ? result.usage.peakRssKb : -1;
+    append(run);
+}
+
+
+void ResultStore::append(const Run &run)
+{
+    // До окончания загрузки номера строк в словаре ещё неизвестны.
+    if (!loaded) {
+        early.append(run);
+        return;
+    }
+    addRun(run);
+}
+
+
+void ResultStore::addRun(const Run &run)
+{
+    auto intern = [this](const QString &name) {
+        bool added = false;
+        quint32 id = data.intern(name, &added);
+        if (added)
+            pendingNames += data.names.last().toUtf8() + '\n';
+        return id;
+    };
+
+    Row row;
+    row.timestampMs = run.timestampMs;
+    row.wallUs = run.wallUs;
+    row.cpuUs = run.cpuUs;
+    row.peakRssKb = run.peakRssKb;
+    row.pathId = intern(run.sourcePath);
+    row.profileId = intern(run.profile);
+    row.testId = intern(run.test);
+    row.caseIndex = quint16(qBound(0, run.caseIndex, 0xffff));
+    row.verdict = quint8(run.verdict);
+    std::memset(row.sourceHash, 0, SourceHashSize);
+    std::memcpy(row.sourceHash, run.sourceHash.constData(), qMin<qsizetype>(run.sourceHash.size(), SourceHashSize));
+    data.add(row);
+
+    uchar record[RecordSize];
+    qToLittleEndian<qint64>(row.timestampMs, record);
+    std::memcpy(record + 8, row.sourceHash, SourceHashSize);
+    qToLittleEndian<quint32>(row.pathId, record + 24);
+    qToLittleEndian<quint32>(row.profileId, record + 28);
+    qToLittleEndian<quint32>(row.testId, record + 32);
+    qToLittleEndian<quint16>(row.caseIndex, record + 36);
+    record[38] = row.verdict;
+    record[39] = 0;
+    qToLittleEndian<qint64>(row.wallUs, record + 40);
+    qToLittleEndian<qint64>(row.cpuUs, record + 48);
+    qToLittleEndian<qint64>(row.peakRssKb, record + 56);
+    pendingRecords.append(reinterpret_cast<const char *>(record), RecordSize);
+
+    if (pendingRecords.size() >= MaxBatchRecords * RecordSize)
+        flush();
+    else if (!flushTimer->isActive())
+        flushTimer->start();
+}
+
+
+void ResultStore::flush()
+{
+    flushTimer->stop();
+    if (!loaded)
+        return;
+    if (!pendingRecords.isEmpty())
+        emit changed();
+
+    if (pendingRecords.isEmpty() || writeWatcher.isRunning())
+        return;
+    if (!data.writable) {
+        pendingNames.clear();
+        pendingRecords.clear();
+        return;
+    }
+
+    writeWatcher.setFuture(QtConcurrent::run(&ResultStore::writeBatch, storeDir, pendingNames, pendingRecords));
+    pendingNames.clear();
+    pendingRecords.clear();
+}
+
+
+void ResultStore::writeFinished()
+{
+    QString error = writeWatcher.result();
+    if (!error.isEmpty()) {
+        // После неудачной записи номера в словаре на диске могут разойтись
+        // с индексом, поэтому дальше история ведётся только в памяти.
+        data.writable = false;
+        pendingNames.clear();
+        pendingRecords.clear();
+        emit errorOccurred(error);
+        return;
+    }
+
+    if (pendingRecords.size() >= MaxBatchRecords * RecordSize)
+        flush();
+    else if (!pendingRecords.isEmpty() && !flushTimer->isActive())
+        flushTimer->start();
+}
+
+
+void ResultStore::applyLoad()
+{
+    data = loadWatcher.result();
+    loaded = true;
+    if (!data.error.isEmpty())
+        emit errorOccurred(data.error);
+    if (!lockFile.isLocked() && data.writable) {
+        data.writable = false;
+        emit errorOccurred("История запусков " + storeDir + " открыта другим процессом: новые запуски "
+                           "видны только до закрытия программы.");
+    }
+
+    const QList<Run> runs = early;
+    early.clear();
+    for (const Run &run : runs)
+        addRun(run);
+
+    emit loadFinished();
+}
+
+
+ResultStore::Data ResultStore::load(const QString &directory, bool owner)
+{
+    // Чинить файлы может только владелец блокировки: остальные читают их,
+    // пока владелец дописывает, и обрезка оборвала бы его незаконченную
+    // запись. Поэтому без блокировки неполный хвост пропускается только в
+    // памяти.
+    const QIODevice::OpenMode mode = owner ? QIODevice::ReadWrite : QIODevice::ReadOnly;
+    Data result;
+    QDir().mkpath(directory);
+    QDir dir(directory);
+
+    auto fail = [&result](const QString &message) {
+        result.error = message;
+        result.writable = false;
+        return result;
+    };
+
+    QFile namesFile(dir.filePath(NamesFileName));
+    if (namesFile.open(mode)) {
+        QByteArray text = namesFile.readAll();
+        // Строка, оборванная при аварийном завершении, отбрасывается, чтобы
+        // следующая дописанная не склеилась с ней.
+        qsizetype complete = text.lastIndexOf('\n') + 1;
+        if (owner && complete < text.size())
+            namesFile.resize(complete);
+
+        // Номер строки — её позиция в файле, даже если такая строка уже
+        // встречалась: повтор не должен сдвигать номера следующих.
+        qsizetype start = 0;
+        while (start < complete) {
+            qsizetype end = text.indexOf('\n', start);
+            QString name = QString::fromUtf8(text.constData() + start, end - start);
+            result.nameIds.insert(name, quint32(result.names.size()));
+            result.names.append(name);
+            start = end + 1;
+        }
+    }
+
+    QFile logFile(dir.filePath(LogFileName));
+    if (!logFile.exists())
+        return result;
+    if (!logFile.open(mode))
+        return fail("Не удалось открыть историю запусков " + logFile.fileName() + ".");
+
+    qint64 fileSize = logFile.size();
+    if (fileSize < HeaderSize) {
+        // Заголовок не успел записаться целиком: журнал начинается заново.
+        if (owner)
+            logFile.resize(0);
+        return result;
+    }
+
+    uchar *map = logFile.map(0, fileSize);
+    if (!map)
+        return fail("Не удалось отобразить историю запусков в память.");
+
+    if (std::memcmp(map, Magic, sizeof(Magic)) != 0 || qFromLittleEndian<quint32>(map + 12) != RecordSize) {
+        logFile.unmap(map);
+        return fail("Неверный формат истории запусков " + logFile.fileName() + ".");
+    }
+    if (qFromLittleEndian<quint32>(map + 8) != FormatVersion) {
+        logFile.unmap(map);
+        return fail("Неподдерживаемая версия истории запусков.");
+    }
+
+    qint64 count = (fileSize - HeaderSize) / RecordSize;
+    result.rows.reserve(count);
+    for (qint64 i = 0; i < count; ++i) {
+        const uchar *record = map + HeaderSize + i * RecordSize;
+        Row row;
+        row.timestampMs = qFromLittleEndian<qint64>(record);
+        std::memcpy(row.sourceHash, record + 8, SourceHashSize);
+        row.pathId = qFromLittleEndian<quint32>(record + 24);
+        row.profileId = qFromLittleEndian<quint32>(record + 28);
+        row.testId = qFromLittleEndian<quint32>(record + 32);
+        row.caseIndex = qFromLittleEndian<quint16>(record + 36);
+        row.verdict = record[38];
+        row.wallUs = qFromLittleEndian<qint64>(record + 40);
+        row.cpuUs = qFromLittleEndian<qint64>(record + 48);
+        row.peakRssKb = qFromLittleEndian<qint64>(record + 56);
+        result.add(row);
+    }
+    logFile.unmap(map);
+
+    // Хвост неполной записи остаётся от аварийного завершения.
+    qint64 validSize = HeaderSize + count * RecordSize;
+    if (owner && validSize < fileSize)
+        logFile.resize(validSize);
+    return result;
+}
+
+
+QString ResultStore::writeBatch(const QString &directory, const QByteArray &names, const QByteArray &records)
+{
+    QDir dir(directory);
+
+    // Сначала словарь: запись на диске не должна ссылаться на строку,
+    // которой там ещё нет.
+    if (!names.isEmpty()) {
+        QFile namesFile(dir.filePath(NamesFileName));
+        if (!namesFile.open(QIODevice::WriteOnly | QIODevice::Append) || namesFile.write(names) != names.size())
+            return "Не удалось записать " + namesFile.fileName() + ": " + namesFile.errorString();
+    }
+
+    QFile logFile(dir.filePath(LogFileName));
+    if (!logFile.open(QIODevice::WriteOnly | QIODevice::Append))
+        return "Не удалось открыть " + logFile.fileName() + ": " + logFile.errorString();
+
+    if (logFile.size() == 0) {
+        uchar header[HeaderSize];
+        std::memcpy(header, Magic, sizeof(Magic));
+        qToLittleEndian<quint32>(FormatVersion, header + 8);
+        qToLittleEndian<quint32>(quint32(RecordSize), header + 12);
+        if (logFile.write(reinterpret_cast<const char *>(header), HeaderSize) != HeaderSize)
+            return "Не удалось записать " + logFile.fileName() + ": " + logFile.errorString();
+    }
+
+    if (logFile.write(records) != records.size())
+        return "Не удалось записать " + logFile.fileName() + ": " + logFile.errorString();
+    return QString();
+}
+
+
+ResultStore::Run ResultStore::toRun(const Row &row) const
+{
+    Run run;
+    run.timestampMs = row.timestampMs;
+    run.sourceHash = QByteArray(row.sourceHash, SourceHashSize);
+    run.sourcePath = data.name(row.pathId);
+    run.profile = data.name(row.profileId);
+    run.test = data.name(row.testId);
+    run.caseIndex = row.caseIndex;
+    run.verdict = TestResult::Verdict(row.verdict);
+    run.wallUs = row.wallUs;
+    run.cpuUs = row.cpuUs;
+    run.peakRssKb = row.peakRssKb;
+    return run;
+}
+
+
+QList<ResultStore::CaseStats> ResultStore::caseStats() const
+{
+    QList<CaseStats> result;
+    result.reserve(data.stats.size());
+    for (auto it = data.stats.constBegin(); it != data.stats.constEnd(); ++it) {
+        const Stats &stats = it.value();
+        CaseStats caseStats;
+        caseStats.test = data.name(quint32(it.key() >> 16));
+        caseStats.caseIndex = int(it.key() & 0xffff);
+        caseStats.runs = stats.runs;
+        caseStats.failures = stats.failures;
+        caseStats.hasPassed = stats.fastestRow >= 0;
+        if (caseStats.hasPassed)
+            caseStats.fastest = toRun(data.rows.at(stats.fastestRow));
+        result.append(caseStats);
+    }
+
+    std::sort(result.begin(), result.end(), [](const CaseStats &a, const CaseStats &b) {
+        if (a.test != b.test)
+            return a.test < b.test;
+        return a.caseIndex < b.caseIndex;
+    });
+    return result;
+}
+
+
+QList<ResultStore::Run> ResultStore::history(const QString &sourcePath, int limit) const
+{
+    QList<Run> result;
+    auto id = data.nameIds.constFind(sourcePath);
+    if (id == data.nameIds.constEnd())
+        return result;
+
+    const QList<int> rows = data.pathRows.value(id.value());
+    for (qsizetype i = qMax<qsizetype>(0, rows.size() - limit); i < rows.size(); ++i)
+        result.append(toRun(data.rows.at(rows.at(i))));
+    return result;
+}
@@ -0,0 +1,149 @@
+#ifndef RESULTSTORE_H
+#define RESULTSTORE_H
+
+#include <QObject>
+#include <QFutureWatcher>
+#include <QHash>
+#include <QList>
+#include <QLockFile>
+#include <QStringList>
+#include "testrunner.h"
+
+class QTimer;
+
+// Локальная история запусков: по записи на каждый случай с хешем исходника,
+// профилем сборки, тестом, вердиктом, временем и памятью. На диске это
+// журнал только для дописывания — заголовок и записи фиксированного размера
+// (results.log) — и словарь строк, на которые записи ссылаются по номеру
+// (names.txt). При открытии журнал читается в фоне и по нему строится
+// индекс в памяти: по каждому случаю теста число запусков, ошибок и самый
+// быстрый пройденный запуск, по каждому файлу — номера его записей. Индекс
+// обновляется при каждой новой записи, поэтому запросы не обходят журнал.
+// Новые записи копятся и дописываются пачками в фоновом потоке.
+//
+// Номера строк словаря раздаются в памяти, поэтому писать в каталог может
+// только один процесс: хранилище держит results.lock всё время работы, а
+// без блокировки (каталог открыт другим процессом) только читает историю.
+class ResultStore : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr int SourceHashSize = 16;
+
+    struct Run
+    {
+        qint64 timestampMs = 0;
+        QByteArray sourceHash; // SourceHashSize байт, см. hashSource()
+        QString sourcePath;
+        QString profile;
+        QString test;
+        int caseIndex = 0;
+        TestResult::Verdict verdict = TestResult::Verdict::Cancelled;
+        qint64 wallUs = 0;
+        qint64 cpuUs = -1;
+        qint64 peakRssKb = -1;
+
+        bool passed() const { return verdict == TestResult::Verdict::Passed; }
+    };
+
+    struct CaseStats
+    {
+        QString test;
+        int caseIndex = 0;
+        int runs = 0;
+        int failures = 0;
+        bool hasPassed = false;
+        Run fastest; // самый быстрый пройденный запуск, если hasPassed
+
+        double failureRate() const { return runs > 0 ? double(failures) / runs : 0.0; }
+    };
+
+    explicit ResultStore(const QString &directory, QObject *parent = nullptr);
+    ~ResultStore() override;
+
+    static QString defaultDirectory();
+    static QByteArray hashSource(const QByteArray &code);
+
+    QString directory() const { return storeDir; }
+    bool isLoaded() const { return loaded; }
+    // Каталог заблокирован этим хранилищем, и новые записи попадут на диск.
+    bool ownsDirectory() const { return lockFile.isLocked(); }
+    int runCount() const { return data.rows.size(); }
+
+    // Отменённые случаи не записываются: вердикта у них нет.
+    void record(const QByteArray &sourceHash, const QString &sourcePath, const QString &profile,
+                const QString &test, const TestResult &result);
+    void append(const Run &run);
+
+    // Статистика по всем случаям всех тестов, по названию теста и номеру случая.
+    QList<CaseStats> caseStats() const;
+    // Последние limit запусков файла в порядке записи.
+    QList<Run> history(const QString &sourcePath, int limit = 200) const;
+
+public slots:
+    void flush();
+
+signals:
+    void loadFinished();
+    // Новые записи попали в индекс; приходит не чаще одного раза за пачку.
+    void changed();
+    void errorOccurred(const QString &message);
+
+private:
+    struct Row
+    {
+        qint64 timestampMs;
+        qint64 wallUs;
+        qint64 cpuUs;
+        qint64 peakRssKb;
+        quint32 pathId;
+        quint32 profileId;
+        quint32 testId;
+        quint16 caseIndex;
+        quint8 verdict;
+        char sourceHash[SourceHashSize];
+    };
+
+    struct Stats
+    {
+        int runs = 0;
+        int failures = 0;
+        int fastestRow = -1;
+    };
+
+    struct Data
+    {
+        QStringList names;
+        QHash<QString, quint32> nameIds;
+        QList<Row> rows;
+        QHash<quint64, Stats> stats;           // testId << 16 | caseIndex
+        QHash<quint32, QList<int>> pathRows;   // pathId -> номера записей
+        QString error;
+        bool writable = true;
+
+        quint32 intern(const QString &name, bool *added = nullptr);
+        void add(const Row &row);
+        QString name(quint32 id) const;
+    };
+
+    static Data load(const QString &directory, bool owner);
+    static QString writeBatch(const QString &directory, const QByteArray &names, const QByteArray &records);
+    void applyLoad();
+    void addRun(const Run &run);
+    void writeFinished();
+    Run toRun(const Row &row) const;
+
+    QString storeDir;
+    QLockFile lockFile;
+    Data data;
+    bool loaded = false;
+    QList<Run> early; // записи, пришедшие до окончания загрузки
+    QByteArray pendingNames;
+    QByteArray pendingRecords;
+    QTimer *flushTimer;
+    QFutureWatcher<Data> loadWatcher;
+    QFutureWatcher<QString> writeWatcher;
+};
+
+#endif // RESULTSTORE_H
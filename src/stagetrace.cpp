@@ -0,0 +1,168 @@
+#include "stagetrace.h"
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QJsonDocument>
+#include <QSaveFile>
+
+namespace {
+
+QElapsedTimer &monotonicClock()
+{
+    static QElapsedTimer clock = [] {
+        QElapsedTimer timer;
+        timer.start();
+        return timer;
+    }();
+    return clock;
+}
+
+}
+
+
+StageTrace::Scope::Scope(StageTrace *trace, const char *name, const char *category)
+    : trace(trace),
+      name(name),
+      category(category)
+{
+    if (trace)
+        startUs = nowUs();
+}
+
+
+StageTrace::Scope::~Scope()
+{
+    if (trace)
+        trace->add(QString::fromUtf8(name), QString::fromLatin1(category), startUs, nowUs() - startUs);
+}
+
+
+StageTrace::StageTrace(const QString &title)
+    : runTitle(title)
+{
+}
+
+
+qint64 StageTrace::nowUs()
+{
+    return monotonicClock().nsecsElapsed() / 1000;
+}
+
+
+void StageTrace::add(const QString &name, const QString &category, qint64 startUs, qint64 durationUs, int lane,
+                     const QJsonObject &args)
+{
+    items.append({name, category, startUs, qMax<qint64>(0, durationUs), lane, args});
+}
+
+
+void StageTrace::setLaneName(int lane, const QString &name)
+{
+    laneNames.append({lane, name});
+}
+
+
+qint64 StageTrace::spanUs() const
+{
+    if (items.isEmpty())
+        return 0;
+
+    qint64 first = items.first().startUs;
+    qint64 last = first;
+    for (const Event &event : items) {
+        first = qMin(first, event.startUs);
+        last = qMax(last, event.startUs + event.durationUs);
+    }
+    return last - first;
+}
+
+
+QList<StageTrace::Stage> StageTrace::stages() const
+{
+    // Порядок этапов — порядок их первого появления.
+    QList<Stage> result;
+    QHash<QString, int> indexByName;
+    for (const Event &event : items) {
+        auto it = indexByName.constFind(event.name);
+        if (it == indexByName.constEnd()) {
+            it = indexByName.insert(event.name, result.size());
+            result.append({event.name, 0, 0, 0});
+        }
+        Stage &stage = result[it.value()];
+        ++stage.count;
+        stage.totalUs += event.durationUs;
+        stage.maxUs = qMax(stage.maxUs, event.durationUs);
+    }
+    return result;
+}
+
+
+QJsonArray StageTrace::traceEvents(int pid) const
+{
+    QJsonArray array;
+
+    QJsonObject processName;
+    processName["name"] = "process_name";
+    processName["ph"] = "M";
+    processName["pid"] = pid;
+    processName["args"] = QJsonObject{{"name", runTitle}};
+    array.append(processName);
+
+    for (const auto &lane : laneNames) {
+        QJsonObject threadName;
+        threadName["name"] = "thread_name";
+        threadName["ph"] = "M";
+        threadName["pid"] = pid;
+        threadName["tid"] = lane.first;
+        threadName["args"] = QJsonObject{{"name", lane.second}};
+        array.append(threadName);
+    }
+
+    for (const Event &event : items) {
+        QJsonObject obj;
+        obj["name"] = event.name;
+        obj["cat"] = event.category;
+        obj["ph"] = "X";
+        obj["ts"] = double(event.startUs);
+        obj["dur"] = double(event.durationUs);
+        obj["pid"] = pid;
+        obj["tid"] = event.lane;
+        if (!event.args.isEmpty())
+            obj["args"] = event.args;
+        array.append(obj);
+    }
+    return array;
+}
+
+
+TraceSession::TraceSession(const QString &filePath)
+    : path(filePath)
+{
+}
+
+
+bool TraceSession::append(const StageTrace &trace, QString *error)
+{
+    const QJsonArray runEvents = trace.traceEvents(++runCount);
+    for (const QJsonValue &event : runEvents)
+        events.append(event);
+
+    QJsonObject root;
+    root["traceEvents"] = events;
+    root["displayTimeUnit"] = "ms";
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || file.write(QJsonDocument(root).toJson(QJsonDocument::Compact)) < 0
+        || !file.commit()) {
+        if (error)
+            *error = "Не удалось записать трассу " + path + ".";
+        return false;
+    }
+    return true;
+}
+
+
+QString TraceSession::defaultDirectory()
+{
+    return QCoreApplication::applicationDirPath() + "/traces";
+}
@@ -0,0 +1,93 @@
+#ifndef STAGETRACE_H
+#define STAGETRACE_H
+
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QList>
+#include <QPair>
+#include <QString>
+
+// Этапы одного запуска (диалог сохранения, запись исходника, компиляция,
+// запуск процессов, сравнение вывода) с метками времени общего монотонного
+// таймера. Трасса создаётся, только если замеры включены; с нулевым
+// указателем на трассу Scope ничего не делает и даже не читает часы.
+class StageTrace
+{
+public:
+    struct Event
+    {
+        QString name;
+        QString category;
+        qint64 startUs = 0;
+        qint64 durationUs = 0;
+        int lane = 0; // 0 — интерфейс и компиляция, дальше — по дорожке на случай
+        QJsonObject args;
+    };
+
+    struct Stage
+    {
+        QString name;
+        int count = 0;
+        qint64 totalUs = 0;
+        qint64 maxUs = 0;
+    };
+
+    // RAII-замер синхронного участка; при trace == nullptr не читает часы.
+    class Scope
+    {
+    public:
+        Scope(StageTrace *trace, const char *name, const char *category = "ui");
+        ~Scope();
+
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+    private:
+        StageTrace *trace;
+        const char *name;
+        const char *category;
+        qint64 startUs = 0;
+    };
+
+    explicit StageTrace(const QString &title);
+
+    static qint64 nowUs();
+
+    QString title() const { return runTitle; }
+    const QList<Event> &events() const { return items; }
+
+    void add(const QString &name, const QString &category, qint64 startUs, qint64 durationUs, int lane = 0,
+             const QJsonObject &args = QJsonObject());
+    void setLaneName(int lane, const QString &name);
+
+    qint64 spanUs() const;
+    QList<Stage> stages() const;
+
+    QJsonArray traceEvents(int pid) const;
+
+private:
+    QString runTitle;
+    QList<Event> items;
+    QList<QPair<int, QString>> laneNames;
+};
+
+// Файл в формате Chrome trace_event, в котором каждый запуск сессии
+// записан отдельным процессом. Файл переписывается целиком после каждого
+// добавленного запуска, чтобы его можно было открыть в любой момент.
+class TraceSession
+{
+public:
+    explicit TraceSession(const QString &filePath);
+
+    QString filePath() const { return path; }
+    bool append(const StageTrace &trace, QString *error = nullptr);
+
+    static QString defaultDirectory();
+
+private:
+    QString path;
+    QJsonArray events;
+    int runCount = 0;
+};
+
+#endif // STAGETRACE_H
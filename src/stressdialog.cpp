@@ -0,0 +1,169 @@
+#include "stressdialog.h"
+#include <QComboBox>
+#include <QDir>
+#include <QFileDialog>
+#include <QFormLayout>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QLineEdit>
+#include <QPushButton>
+#include <QRandomGenerator>
+#include <QSpinBox>
+#include <QThread>
+#include <QVBoxLayout>
+#include <climits>
+
+StressDialog::StressDialog(QWidget *parent)
+    : QDialog(parent)
+{
+    setWindowTitle("Стресс-тестирование");
+    auto *layout = new QVBoxLayout(this);
+    auto *form = new QFormLayout();
+
+    editorProgramEdit = new QComboBox(this);
+    editorProgramEdit->addItem("Решение", int(Program::Candidate));
+    editorProgramEdit->addItem("Генератор", int(Program::Generator));
+    editorProgramEdit->addItem("Эталонное решение", int(Program::Reference));
+    editorProgramEdit->addItem("Не используется", -1);
+    form->addRow("Код в редакторе:", editorProgramEdit);
+
+    const QStringList labels = QStringList() << "Генератор:" << "Эталонное решение:" << "Решение:";
+    for (int i = 0; i < 3; ++i) {
+        sourceEdits[i] = new QLineEdit(this);
+        sourceEdits[i]->setPlaceholderText("файл *.cpp");
+        browseButtons[i] = new QPushButton("Обзор…", this);
+
+        auto *row = new QHBoxLayout();
+        row->addWidget(sourceEdits[i]);
+        row->addWidget(browseButtons[i]);
+        form->addRow(labels.at(i), row);
+
+        QLineEdit *edit = sourceEdits[i];
+        connect(browseButtons[i], &QPushButton::clicked, this, [this, edit] {
+            QString start = edit->text().isEmpty() ? QDir::homePath() : edit->text();
+            QString filePath = QFileDialog::getOpenFileName(this, "Исходный файл", start, "C++ Files (*.cpp *.cc *.cxx)");
+            if (!filePath.isEmpty())
+                edit->setText(filePath);
+        });
+    }
+    sourceEdits[int(Program::Generator)]->setToolTip("Генератор получает seed первым аргументом и печатает вход.");
+
+    maxCasesEdit = new QSpinBox(this);
+    maxCasesEdit->setRange(0, 10000000);
+    maxCasesEdit->setValue(10000);
+    maxCasesEdit->setSpecialValueText("без ограничения");
+
+    timeBudgetEdit = new QSpinBox(this);
+    timeBudgetEdit->setRange(0, 24 * 3600);
+    timeBudgetEdit->setValue(60);
+    timeBudgetEdit->setSuffix(" с");
+    timeBudgetEdit->setSpecialValueText("без ограничения");
+
+    parallelEdit = new QSpinBox(this);
+    parallelEdit->setRange(1, qMax(1, QThread::idealThreadCount()) * 2);
+    parallelEdit->setValue(qMax(1, QThread::idealThreadCount()));
+
+    seedEdit = new QSpinBox(this);
+    seedEdit->setRange(0, INT_MAX);
+    seedEdit->setValue(QRandomGenerator::global()->bounded(1000000));
+
+    timeLimitEdit = new QSpinBox(this);
+    timeLimitEdit->setRange(1, 600000);
+    timeLimitEdit->setValue(2000);
+    timeLimitEdit->setSuffix(" мс");
+
+    checkerModeEdit = new QComboBox(this);
+    for (OutputChecker::Mode mode : {OutputChecker::Mode::Exact, OutputChecker::Mode::Tokens,
+                                     OutputChecker::Mode::Float})
+        checkerModeEdit->addItem(OutputChecker::Options::modeName(mode), int(mode));
+    checkerModeEdit->setCurrentIndex(checkerModeEdit->findData(int(OutputChecker::Mode::Tokens)));
+
+    form->addRow("Случаев:", maxCasesEdit);
+    form->addRow("Бюджет времени:", timeBudgetEdit);
+    form->addRow("Параллельно:", parallelEdit);
+    form->addRow("Первый seed:", seedEdit);
+    form->addRow("Время на запуск:", timeLimitEdit);
+    form->addRow("Сравнение вывода:", checkerModeEdit);
+    layout->addLayout(form);
+
+    runButton = new QPushButton("Запустить", this);
+    cancelButton = new QPushButton("Отменить", this);
+    cancelButton->setEnabled(false);
+    auto *buttonLayout = new QHBoxLayout();
+    buttonLayout->addStretch();
+    buttonLayout->addWidget(runButton);
+    buttonLayout->addWidget(cancelButton);
+    layout->addLayout(buttonLayout);
+
+    progressLabel = new QLabel(this);
+    outcomeLabel = new QLabel(this);
+    outcomeLabel->setWordWrap(true);
+    outcomeLabel->setTextInteractionFlags(Qt::TextSelectableByMouse);
+    layout->addWidget(progressLabel);
+    layout->addWidget(outcomeLabel);
+    layout->addStretch();
+
+    connect(editorProgramEdit, &QComboBox::currentIndexChanged, this, &StressDialog::updateSourceEdits);
+    connect(runButton, &QPushButton::clicked, this, &StressDialog::runRequested);
+    connect(cancelButton, &QPushButton::clicked, this, &StressDialog::cancelRequested);
+    updateSourceEdits();
+    resize(600, sizeHint().height());
+}
+
+
+QString StressDialog::sourceFile(Program program) const
+{
+    return usesEditor(program) ? QString() : sourceEdits[int(program)]->text().trimmed();
+}
+
+
+bool StressDialog::usesEditor(Program program) const
+{
+    return editorProgramEdit->currentData().toInt() == int(program);
+}
+
+
+StressTester::Options StressDialog::options() const
+{
+    StressTester::Options options;
+    options.maxCases = maxCasesEdit->value();
+    options.timeBudgetMs = timeBudgetEdit->value() * 1000;
+    options.parallel = parallelEdit->value();
+    options.firstSeed = seedEdit->value();
+    options.limits.timeLimitMs = timeLimitEdit->value();
+    options.checker.mode = OutputChecker::Mode(checkerModeEdit->currentData().toInt());
+    return options;
+}
+
+
+void StressDialog::setRunning(bool running)
+{
+    runButton->setEnabled(!running);
+    cancelButton->setEnabled(running);
+    if (running) {
+        progressLabel->clear();
+        outcomeLabel->clear();
+    }
+}
+
+
+void StressDialog::setProgress(int passedCases, qint64 elapsedMs)
+{
+    progressLabel->setText(QString("Пройдено случаев: %1 за %2 с.").arg(passedCases).arg(elapsedMs / 1000.0, 0, 'f', 1));
+}
+
+
+void StressDialog::showOutcome(const QString &text)
+{
+    outcomeLabel->setText(text);
+}
+
+
+void StressDialog::updateSourceEdits()
+{
+    for (int i = 0; i < 3; ++i) {
+        bool fromEditor = usesEditor(Program(i));
+        sourceEdits[i]->setEnabled(!fromEditor);
+        browseButtons[i]->setEnabled(!fromEditor);
+    }
+}
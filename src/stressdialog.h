@@ -0,0 +1,55 @@
+#ifndef STRESSDIALOG_H
+#define STRESSDIALOG_H
+
+#include <QDialog>
+#include "stresstester.h"
+
+class QComboBox;
+class QLabel;
+class QLineEdit;
+class QSpinBox;
+class QPushButton;
+
+// Настройки стресс-тестирования. Одна из трёх программ может браться из
+// редактора, остальные — из файлов.
+class StressDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    enum class Program { Generator, Reference, Candidate };
+
+    explicit StressDialog(QWidget *parent = nullptr);
+
+    // Пустая строка — программа берётся из редактора.
+    QString sourceFile(Program program) const;
+    bool usesEditor(Program program) const;
+    StressTester::Options options() const;
+
+    void setRunning(bool running);
+    void setProgress(int passedCases, qint64 elapsedMs);
+    void showOutcome(const QString &text);
+
+signals:
+    void runRequested();
+    void cancelRequested();
+
+private:
+    void updateSourceEdits();
+
+    QComboBox *editorProgramEdit;
+    QLineEdit *sourceEdits[3];
+    QPushButton *browseButtons[3];
+    QSpinBox *maxCasesEdit;
+    QSpinBox *timeBudgetEdit;
+    QSpinBox *parallelEdit;
+    QSpinBox *seedEdit;
+    QSpinBox *timeLimitEdit;
+    QComboBox *checkerModeEdit;
+    QPushButton *runButton;
+    QPushButton *cancelButton;
+    QLabel *progressLabel;
+    QLabel *outcomeLabel;
+};
+
+#endif // STRESSDIALOG_H
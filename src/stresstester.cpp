@@ -0,0 +1,222 @@
+#include "stresstester.h"
+#include <QFileInfo>
+#include <QTimer>
+
+StressTester::StressTester(const QString &generator, const QString &reference, const QString &candidate,
+                           const Options &options, QObject *parent)
+    : QObject(parent),
+      generator(generator),
+      reference(reference),
+      candidate(candidate),
+      options(options)
+{
+    this->options.parallel = qMax(1, options.parallel);
+}
+
+
+TestDefinition StressTester::failingTest() const
+{
+    TestDefinition test;
+    test.name = QString("Стресс-тест, seed %1").arg(mismatchSeed);
+    test.description = QString("Найден стресс-тестом: генератор %1 с seed %2, эталон %3.")
+                           .arg(QFileInfo(generator).fileName())
+                           .arg(mismatchSeed)
+                           .arg(QFileInfo(reference).fileName());
+    test.limits = options.limits;
+    test.checker = options.checker;
+
+    TestCase testCase;
+    testCase.input = mismatchInput;
+    testCase.expected = mismatchExpected;
+    testCase.limits = options.limits;
+    test.cases.append(testCase);
+    return test;
+}
+
+
+void StressTester::start()
+{
+    if (running)
+        return;
+
+    running = true;
+    stopping = false;
+    nextSeed = options.firstSeed;
+    startedCount = 0;
+    passed = 0;
+    elapsed.start();
+    startJobs();
+}
+
+
+void StressTester::cancel()
+{
+    if (running)
+        stop(Outcome::Cancelled);
+}
+
+
+void StressTester::startJobs()
+{
+    while (!stopping && jobs.size() < options.parallel) {
+        if (options.maxCases > 0 && startedCount >= options.maxCases)
+            break;
+        if (options.timeBudgetMs > 0 && elapsed.elapsed() >= options.timeBudgetMs)
+            break;
+
+        auto *job = new Job;
+        job->seed = nextSeed++;
+        ++startedCount;
+        jobs.append(job);
+
+        runHelper(job, generator, QStringList() << QString::number(job->seed), QByteArray(), "Генератор",
+                  [this, job](const QByteArray &output) {
+            job->input = output;
+            runHelper(job, reference, QStringList(), job->input, "Эталонное решение",
+                      [this, job](const QByteArray &output) {
+                job->expected = output;
+                runCandidate(job);
+            });
+        });
+    }
+
+    if (jobs.isEmpty() && !stopping) {
+        bool budgetExhausted = options.timeBudgetMs > 0 && elapsed.elapsed() >= options.timeBudgetMs;
+        stop(budgetExhausted ? Outcome::BudgetExhausted : Outcome::CaseLimitReached);
+    }
+}
+
+
+void StressTester::runHelper(Job *job, const QString &program, const QStringList &arguments,
+                             const QByteArray &input, const QString &role,
+                             const std::function<void(const QByteArray &)> &next)
+{
+    auto *process = new QProcess(this);
+    auto *timer = new QTimer(process);
+    timer->setSingleShot(true);
+    process->setWorkingDirectory(QFileInfo(program).path());
+    job->process = process;
+
+    connect(timer, &QTimer::timeout, process, &QProcess::kill);
+    connect(process, &QProcess::started, this, [process, timer, input, this] {
+        timer->start(options.limits.timeLimitMs);
+        process->write(input);
+        process->closeWriteChannel();
+    });
+
+    connect(process, &QProcess::finished, this,
+            [this, job, process, timer, role, next](int exitCode, QProcess::ExitStatus exitStatus) {
+        bool timedOut = !timer->isActive();
+        timer->stop();
+        job->process = nullptr;
+        process->deleteLater();
+
+        if (stopping) {
+            finishJob(job);
+            return;
+        }
+        if (exitStatus != QProcess::NormalExit || exitCode != 0) {
+            QString reason = timedOut ? QString("не завершился за %1 мс").arg(options.limits.timeLimitMs)
+                                      : QString("завершился с кодом %1").arg(exitCode);
+            error = QString("%1 (seed %2) %3.").arg(role).arg(job->seed).arg(reason);
+            QByteArray errorOutput = process->readAllStandardError().trimmed();
+            if (!errorOutput.isEmpty())
+                error += "\n" + QString::fromLocal8Bit(errorOutput);
+            finishJob(job);
+            stop(Outcome::Failed);
+            return;
+        }
+        next(process->readAllStandardOutput());
+    });
+
+    connect(process, &QProcess::errorOccurred, this, [this, job, process, program](QProcess::ProcessError processError) {
+        if (processError != QProcess::FailedToStart)
+            return;
+        job->process = nullptr;
+        process->deleteLater();
+        if (!stopping)
+            error = "Не удалось запустить " + program + ": " + process->errorString();
+        finishJob(job);
+        stop(Outcome::Failed);
+    });
+
+    process->start(program, arguments);
+}
+
+
+void StressTester::runCandidate(Job *job)
+{
+    TestDefinition test;
+    test.checker = options.checker;
+    TestCase testCase;
+    testCase.input = job->input;
+    testCase.expected = job->expected;
+    testCase.limits = options.limits;
+    test.cases.append(testCase);
+
+    auto *runner = new TestRunner(candidate, test, 0, this);
+    job->runner = runner;
+
+    connect(runner, &TestRunner::finished, this, [this, job, runner] {
+        job->runner = nullptr;
+        runner->deleteLater();
+
+        const TestResult &testResult = runner->result();
+        if (!stopping) {
+            if (testResult.passed()) {
+                ++passed;
+                emit progress(passed, elapsed.elapsed());
+            } else {
+                mismatchSeed = job->seed;
+                mismatchInput = job->input;
+                mismatchExpected = job->expected;
+                mismatchResult = testResult;
+                finishJob(job);
+                stop(Outcome::MismatchFound);
+                return;
+            }
+        }
+        finishJob(job);
+        if (!stopping)
+            startJobs();
+    });
+
+    runner->start();
+}
+
+
+void StressTester::finishJob(Job *job)
+{
+    if (!jobs.removeOne(job))
+        return;
+    delete job;
+
+    if (stopping && jobs.isEmpty() && running) {
+        running = false;
+        emit finished(result);
+    }
+}
+
+
+void StressTester::stop(Outcome outcome)
+{
+    if (stopping)
+        return;
+
+    stopping = true;
+    result = outcome;
+    if (jobs.isEmpty()) {
+        running = false;
+        emit finished(result);
+        return;
+    }
+
+    // Остальные случаи прерываются; finished() придёт, когда завершится последний.
+    const QList<Job *> active = jobs;
+    for (Job *job : active) {
+        if (job->process)
+            job->process->kill();
+        else if (job->runner)
+            job->runner->cancel();
+    }
+}
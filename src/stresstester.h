@@ -0,0 +1,90 @@
+#ifndef STRESSTESTER_H
+#define STRESSTESTER_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QProcess>
+#include <functional>
+#include "testrunner.h"
+
+// Стресс-тестирование: генератор получает номер случая (seed) первым
+// аргументом и печатает вход, эталонное решение даёт по нему ожидаемый
+// вывод, а решение проверяется как обычный случай теста. Одновременно
+// обрабатывается до parallel случаев; при первом расхождении всё
+// останавливается.
+class StressTester : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Options
+    {
+        int maxCases = 10000;     // 0 — без ограничения
+        int timeBudgetMs = 60000; // 0 — без ограничения
+        int parallel = 1;
+        quint64 firstSeed = 1;
+        ResourceLimits limits;
+        OutputChecker::Options checker;
+    };
+
+    enum class Outcome { CaseLimitReached, BudgetExhausted, MismatchFound, Failed, Cancelled };
+
+    StressTester(const QString &generator, const QString &reference, const QString &candidate,
+                 const Options &options, QObject *parent = nullptr);
+
+    int passedCount() const { return passed; }
+    qint64 elapsedMs() const { return elapsed.elapsed(); }
+    bool isRunning() const { return running; }
+    Outcome outcome() const { return result; }
+    QString errorMessage() const { return error; }
+
+    // Заполнены, только если найдено расхождение.
+    quint64 failingSeed() const { return mismatchSeed; }
+    const TestResult &failingResult() const { return mismatchResult; }
+    TestDefinition failingTest() const;
+
+public slots:
+    void start();
+    void cancel();
+
+signals:
+    void progress(int passedCases, qint64 elapsedMs);
+    void finished(StressTester::Outcome outcome);
+
+private:
+    struct Job
+    {
+        quint64 seed = 0;
+        QByteArray input;
+        QByteArray expected;
+        QProcess *process = nullptr;
+        TestRunner *runner = nullptr;
+    };
+
+    void startJobs();
+    void runHelper(Job *job, const QString &program, const QStringList &arguments, const QByteArray &input,
+                   const QString &role, const std::function<void(const QByteArray &)> &next);
+    void runCandidate(Job *job);
+    void finishJob(Job *job);
+    void stop(Outcome outcome);
+
+    QString generator;
+    QString reference;
+    QString candidate;
+    Options options;
+    QList<Job *> jobs;
+    QElapsedTimer elapsed;
+    quint64 nextSeed = 0;
+    int startedCount = 0;
+    int passed = 0;
+    bool running = false;
+    bool stopping = false;
+    Outcome result = Outcome::Cancelled;
+    QString error;
+    quint64 mismatchSeed = 0;
+    QByteArray mismatchInput;
+    QByteArray mismatchExpected;
+    TestResult mismatchResult;
+};
+
+#endif // STRESSTESTER_H
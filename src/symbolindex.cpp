@@ -0,0 +1,330 @@
+#include "symbolindex.h"
+#include "cpplexer.h"
+#include <QHash>
+#include <QSet>
+#include <QTextBlock>
+#include <QTextDocument>
+#include <QtConcurrent>
+#include <algorithm>
+
+namespace {
+
+// Однобуквенные переменные дополнять незачем.
+const int MinSymbolLength = 2;
+
+struct HeaderSymbols
+{
+    const char *header;
+    const char *symbols;
+};
+
+// Разбирать настоящие заголовки стандартной библиотеки при каждом наборе
+// #include слишком дорого, поэтому для частых заголовков здесь имена, которые
+// встречаются в учебных решениях.
+const HeaderSymbols StandardHeaders[] = {
+    {"iostream", "std cin cout cerr clog endl flush ios ios_base sync_with_stdio tie getline istream ostream "
+                 "iostream ws boolalpha noboolalpha hex dec oct fixed scientific"},
+    {"cstdio", "printf scanf puts gets getchar putchar fgets fputs fprintf fscanf sprintf snprintf sscanf "
+               "fopen fclose freopen fflush fread fwrite stdin stdout stderr EOF FILE"},
+    {"string", "std string wstring to_string to_wstring stoi stol stoll stoul stoull stof stod stold getline "
+               "npos size length substr find rfind find_first_of find_last_of replace insert erase append "
+               "push_back pop_back c_str compare empty clear begin end front back reserve resize"},
+    {"vector", "std vector push_back emplace_back pop_back size empty clear resize reserve capacity insert "
+               "erase begin end rbegin rend front back data at assign swap shrink_to_fit"},
+    {"algorithm", "std sort stable_sort partial_sort nth_element lower_bound upper_bound equal_range "
+                  "binary_search reverse rotate unique remove remove_if find find_if count count_if min max "
+                  "min_element max_element minmax_element next_permutation prev_permutation fill copy "
+                  "copy_if transform for_each all_of any_of none_of merge swap shuffle is_sorted"},
+    {"map", "std map multimap insert emplace erase find count lower_bound upper_bound begin end size empty "
+            "clear first second at contains"},
+    {"set", "std set multiset insert emplace erase find count lower_bound upper_bound begin end size empty "
+            "clear contains"},
+    {"unordered_map", "std unordered_map unordered_multimap insert emplace erase find count begin end size "
+                      "empty clear reserve bucket_count first second at contains"},
+    {"unordered_set", "std unordered_set unordered_multiset insert emplace erase find count begin end size "
+                      "empty clear reserve contains"},
+    {"queue", "std queue priority_queue push emplace pop front back top size empty greater less"},
+    {"stack", "std stack push emplace pop top size empty"},
+    {"deque", "std deque push_back push_front emplace_back emplace_front pop_back pop_front front back size "
+              "empty clear begin end at"},
+    {"list", "std list push_back push_front pop_back pop_front front back size empty clear begin end "
+             "insert erase splice sort reverse unique merge"},
+    {"utility", "std pair make_pair swap move forward first second exchange"},
+    {"tuple", "std tuple make_tuple get tie tuple_size apply"},
+    {"array", "std array size empty fill begin end front back data at"},
+    {"bitset", "std bitset set reset flip test count any none all size to_string to_ulong to_ullong"},
+    {"numeric", "std accumulate iota gcd lcm partial_sum adjacent_difference inner_product reduce"},
+    {"functional", "std function greater less equal_to plus minus multiplies hash bind"},
+    {"memory", "std unique_ptr shared_ptr weak_ptr make_unique make_shared"},
+    {"cmath", "std abs fabs sqrt cbrt pow exp log log2 log10 sin cos tan asin acos atan atan2 floor ceil "
+              "round trunc hypot fmod INFINITY NAN"},
+    {"cstring", "memset memcpy memmove memcmp strlen strcmp strncmp strcpy strncpy strcat strchr strstr"},
+    {"cstdlib", "std abs rand srand malloc calloc realloc free exit atoi atol atoll atof qsort RAND_MAX "
+                "EXIT_SUCCESS EXIT_FAILURE"},
+    {"climits", "INT_MAX INT_MIN LLONG_MAX LLONG_MIN UINT_MAX ULLONG_MAX CHAR_BIT LONG_MAX LONG_MIN"},
+    {"limits", "std numeric_limits max min lowest infinity epsilon"},
+    {"iomanip", "std setw setprecision setfill fixed scientific left right"},
+    {"sstream", "std stringstream istringstream ostringstream str"},
+    {"fstream", "std ifstream ofstream fstream open close is_open getline"},
+    {"chrono", "std chrono steady_clock high_resolution_clock system_clock now duration duration_cast "
+               "milliseconds microseconds nanoseconds seconds count"},
+    {"random", "std mt19937 mt19937_64 random_device uniform_int_distribution uniform_real_distribution "
+               "normal_distribution shuffle"},
+    {"cassert", "assert"},
+};
+
+const QHash<QString, QStringList> &headerTable()
+{
+    static const QHash<QString, QStringList> table = [] {
+        QHash<QString, QStringList> result;
+        QStringList all;
+        for (const HeaderSymbols &entry : StandardHeaders) {
+            QStringList symbols = QString::fromLatin1(entry.symbols).split(' ', Qt::SkipEmptyParts);
+            result.insert(QString::fromLatin1(entry.header), symbols);
+            all += symbols;
+        }
+        all.removeDuplicates();
+        result.insert("bits/stdc++.h", all);
+        return result;
+    }();
+    return table;
+}
+
+}
+
+
+struct SymbolIndex::Model
+{
+    struct Line
+    {
+        QString text;
+        QStringList words; // без повторов внутри строки
+        QString header;    // заголовок из #include <...>
+        CppLexer::State startState;
+        CppLexer::State endState;
+        bool tokenized = false;
+    };
+
+    QList<Line> lines;
+    QHash<QString, int> wordCounts;
+    QHash<QString, int> headerCounts;
+    bool changed = false;
+
+    void unindex(const Line &line);
+    void tokenize(Line &line, const CppLexer::State &start);
+    QStringList symbols() const;
+};
+
+
+void SymbolIndex::Model::unindex(const Line &line)
+{
+    for (const QString &word : line.words) {
+        auto it = wordCounts.find(word);
+        if (it != wordCounts.end() && --it.value() == 0) {
+            wordCounts.erase(it);
+            changed = true;
+        }
+    }
+
+    if (!line.header.isEmpty()) {
+        auto it = headerCounts.find(line.header);
+        if (it != headerCounts.end() && --it.value() == 0) {
+            headerCounts.erase(it);
+            changed = true;
+        }
+    }
+}
+
+
+void SymbolIndex::Model::tokenize(Line &line, const CppLexer::State &start)
+{
+    line.startState = start;
+    line.endState = start;
+    line.words.clear();
+    line.header.clear();
+    line.tokenized = true;
+
+    QList<CppLexer::Token> tokens;
+    CppLexer::tokenizeLine(line.text, line.endState, tokens);
+
+    QSet<QString> seen;
+    for (const CppLexer::Token &token : std::as_const(tokens)) {
+        if (token.kind == CppLexer::TokenKind::HeaderName) {
+            if (token.length > 2 && line.text.at(token.start) == '<')
+                line.header = line.text.mid(token.start + 1, token.length - 2).trimmed();
+            continue;
+        }
+        if (token.kind != CppLexer::TokenKind::Identifier || token.length < MinSymbolLength)
+            continue;
+
+        QString word = line.text.mid(token.start, token.length);
+        if (seen.contains(word))
+            continue;
+        seen.insert(word);
+        line.words.append(word);
+        if (++wordCounts[word] == 1)
+            changed = true;
+    }
+
+    if (!line.header.isEmpty() && ++headerCounts[line.header] == 1)
+        changed = true;
+}
+
+
+QStringList SymbolIndex::Model::symbols() const
+{
+    QStringList result;
+    result.reserve(wordCounts.size());
+    for (auto it = wordCounts.constBegin(); it != wordCounts.constEnd(); ++it)
+        result.append(it.key());
+    for (auto it = headerCounts.constBegin(); it != headerCounts.constEnd(); ++it)
+        result += headerSymbols(it.key());
+
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+}
+
+
+SymbolIndex::SymbolIndex(QTextDocument *document, QObject *parent)
+    : QObject(parent),
+      document(document),
+      model(new Model)
+{
+    connect(&worker, &QFutureWatcher<Update>::finished, this, &SymbolIndex::workerFinished);
+    if (!document)
+        return;
+
+    connect(document, &QTextDocument::contentsChange, this, &SymbolIndex::onContentsChange);
+
+    QStringList lines;
+    for (QTextBlock block = document->begin(); block.isValid(); block = block.next())
+        lines.append(block.text());
+    lineCount = lines.size();
+    replaceLines(0, 0, lines);
+}
+
+
+SymbolIndex::~SymbolIndex()
+{
+    worker.waitForFinished();
+}
+
+
+QStringList SymbolIndex::headerSymbols(const QString &header)
+{
+    return headerTable().value(header);
+}
+
+
+QStringList SymbolIndex::complete(const QString &prefix, int limit) const
+{
+    QStringList result;
+    auto it = std::lower_bound(symbols.cbegin(), symbols.cend(), prefix);
+    for (; it != symbols.cend() && result.size() < limit && it->startsWith(prefix); ++it) {
+        if (it->size() > prefix.size())
+            result.append(*it);
+    }
+    return result;
+}
+
+
+void SymbolIndex::replaceLines(int first, int removed, const QStringList &lines)
+{
+    // Пока результат прошлого прохода не забран, новый не запускается:
+    // иначе QFutureWatcher потеряет его сигнал finished.
+    pending.append(Edit{first, removed, lines});
+    if (!indexing)
+        startWorker();
+}
+
+
+void SymbolIndex::onContentsChange(int position, int charsRemoved, int charsAdded)
+{
+    Q_UNUSED(charsRemoved);
+
+    // Правка уже внесена: от блока с position до блока с концом вставки
+    // лежат новые строки, а сколько старых они заменили, видно по тому, на
+    // сколько изменилось число блоков.
+    QTextBlock firstBlock = document->findBlock(position);
+    QTextBlock lastBlock = document->findBlock(position + charsAdded);
+    if (!firstBlock.isValid())
+        firstBlock = document->lastBlock();
+    if (!lastBlock.isValid())
+        lastBlock = document->lastBlock();
+
+    QStringList lines;
+    for (QTextBlock block = firstBlock; block.isValid(); block = block.next()) {
+        lines.append(block.text());
+        if (block == lastBlock)
+            break;
+    }
+
+    int blockCount = document->blockCount();
+    int removed = lines.size() - (blockCount - lineCount);
+    lineCount = blockCount;
+    replaceLines(firstBlock.blockNumber(), removed, lines);
+}
+
+
+void SymbolIndex::startWorker()
+{
+    QList<Edit> edits = pending;
+    pending.clear();
+    indexing = true;
+    worker.setFuture(QtConcurrent::run(&SymbolIndex::apply, model.get(), edits));
+}
+
+
+void SymbolIndex::workerFinished()
+{
+    Update update = worker.result();
+    if (update.changed)
+        symbols = update.symbols;
+
+    if (!pending.isEmpty()) {
+        startWorker();
+        return;
+    }
+    indexing = false;
+    emit indexFinished();
+}
+
+
+SymbolIndex::Update SymbolIndex::apply(Model *model, const QList<Edit> &edits)
+{
+    // Правки идут строго по очереди: следующая запускается только после
+    // окончания этой, поэтому модель доступна одному потоку.
+    for (const Edit &edit : edits) {
+        int first = qBound(0, edit.first, int(model->lines.size()));
+        int removed = qBound(0, edit.removed, int(model->lines.size()) - first);
+        for (int i = first; i < first + removed; ++i)
+            model->unindex(model->lines.at(i));
+        model->lines.remove(first, removed);
+
+        QList<Model::Line> inserted(edit.lines.size());
+        for (int i = 0; i < edit.lines.size(); ++i)
+            inserted[i].text = edit.lines.at(i);
+        model->lines.insert(first, edit.lines.size(), Model::Line());
+        std::move(inserted.begin(), inserted.end(), model->lines.begin() + first);
+
+        // Новые строки разбираются всегда, следующие — пока у них меняется
+        // входное состояние лексера.
+        int end = first + int(edit.lines.size());
+        for (int i = first; i < model->lines.size(); ++i) {
+            CppLexer::State start = i > 0 ? model->lines.at(i - 1).endState : CppLexer::State();
+            Model::Line &line = model->lines[i];
+            if (i >= end && line.tokenized && line.startState == start)
+                break;
+            model->unindex(line);
+            model->tokenize(line, start);
+        }
+    }
+
+    Update update;
+    update.changed = model->changed;
+    if (model->changed)
+        update.symbols = model->symbols();
+    model->changed = false;
+    return update;
+}
@@ -0,0 +1,72 @@
+#ifndef SYMBOLINDEX_H
+#define SYMBOLINDEX_H
+
+#include <QObject>
+#include <QFutureWatcher>
+#include <QStringList>
+#include <memory>
+
+class QTextDocument;
+
+// Идентификаторы документа и стандартных заголовков из его #include <...>
+// для автодополнения. Индекс хранит строки документа, слова каждой строки
+// и число вхождений каждого слова; правки приходят из contentsChange и
+// применяются в фоновом потоке: заново разбираются только изменённые
+// строки и те следующие, у которых поменялось состояние лексера (открытый
+// комментарий и т. п.). Когда меняется сам набор слов, поток строит новый
+// отсортированный массив, а поиск по префиксу в потоке интерфейса — это
+// двоичный поиск по последнему готовому массиву, без ожидания потока.
+class SymbolIndex : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit SymbolIndex(QTextDocument *document, QObject *parent = nullptr);
+    ~SymbolIndex() override;
+
+    // Слова, которые начинаются с prefix и длиннее его, по алфавиту.
+    QStringList complete(const QString &prefix, int limit) const;
+    int symbolCount() const { return symbols.size(); }
+    bool isIndexing() const { return indexing; }
+
+    // Строки first .. first + removed - 1 заменяются на lines. Вызывается
+    // из contentsChange документа; без документа — для замеров.
+    void replaceLines(int first, int removed, const QStringList &lines);
+
+    static QStringList headerSymbols(const QString &header);
+
+signals:
+    // Все поступившие правки применены.
+    void indexFinished();
+
+private:
+    struct Edit
+    {
+        int first;
+        int removed;
+        QStringList lines;
+    };
+
+    struct Update
+    {
+        bool changed = false;
+        QStringList symbols;
+    };
+
+    struct Model;
+
+    void onContentsChange(int position, int charsRemoved, int charsAdded);
+    void startWorker();
+    void workerFinished();
+    static Update apply(Model *model, const QList<Edit> &edits);
+
+    QTextDocument *document;
+    int lineCount = 0;
+    bool indexing = false;
+    std::unique_ptr<Model> model;
+    QList<Edit> pending;
+    QStringList symbols;
+    QFutureWatcher<Update> worker;
+};
+
+#endif // SYMBOLINDEX_H
@@ -0,0 +1,193 @@
+#include "testarchive.h"
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QtEndian>
+#include <cstring>
+
+namespace {
+
+const char Magic[8] = {'P', 'S', 'T', 'U', 'S', 'U', 'I', 'T'};
+const quint32 FormatVersion = 1;
+
+// Magic, версия, зарезервированное поле, смещение и размер индекса.
+const qint64 HeaderSize = 8 + 4 + 4 + 8 + 8;
+
+QJsonArray blobRange(qint64 offset, qint64 size)
+{
+    return QJsonArray() << double(offset) << double(size);
+}
+
+}
+
+const char TestArchive::Extension[] = "suite";
+
+
+TestArchive::~TestArchive()
+{
+    if (data)
+        file.unmap(data);
+}
+
+
+bool TestArchive::isArchive(const QString &filePath)
+{
+    return filePath.endsWith(QString(".") + Extension, Qt::CaseInsensitive);
+}
+
+
+bool TestArchive::load(const QString &filePath, QList<TestDefinition> *tests, QString *error)
+{
+    auto fail = [error](const QString &message) {
+        if (error)
+            *error = message;
+        return false;
+    };
+
+    QSharedPointer<TestArchive> archive(new TestArchive);
+    archive->file.setFileName(filePath);
+    if (!archive->file.open(QIODevice::ReadOnly))
+        return fail("Не удалось открыть архив тестов.");
+
+    qint64 fileSize = archive->file.size();
+    if (fileSize < HeaderSize)
+        return fail("Неверный формат архива тестов.");
+
+    archive->data = archive->file.map(0, fileSize);
+    if (!archive->data)
+        return fail("Не удалось отобразить архив тестов в память.");
+
+    const uchar *header = archive->data;
+    if (std::memcmp(header, Magic, sizeof(Magic)) != 0)
+        return fail("Неверный формат архива тестов.");
+    if (qFromLittleEndian<quint32>(header + 8) != FormatVersion)
+        return fail("Неподдерживаемая версия архива тестов.");
+
+    qint64 indexOffset = qint64(qFromLittleEndian<quint64>(header + 16));
+    qint64 indexSize = qint64(qFromLittleEndian<quint64>(header + 24));
+    if (indexOffset < HeaderSize || indexSize < 0 || indexOffset > fileSize - indexSize)
+        return fail("Повреждён индекс архива тестов.");
+
+    QJsonParseError parseError;
+    QJsonDocument doc = QJsonDocument::fromJson(
+        QByteArray::fromRawData(reinterpret_cast<const char *>(archive->data + indexOffset), indexSize), &parseError);
+    if (parseError.error != QJsonParseError::NoError || !doc.isObject())
+        return fail("Повреждён индекс архива тестов.");
+
+    auto blob = [&archive, indexOffset](const QJsonValue &value, QByteArray *bytes) {
+        const QJsonArray range = value.toArray();
+        if (range.size() != 2)
+            return false;
+        qint64 offset = qint64(range.at(0).toDouble(-1));
+        qint64 size = qint64(range.at(1).toDouble(-1));
+        if (offset < HeaderSize || size < 0 || offset > indexOffset - size)
+            return false;
+        *bytes = QByteArray::fromRawData(reinterpret_cast<const char *>(archive->data + offset), size);
+        return true;
+    };
+
+    QList<TestDefinition> loaded;
+    const QJsonArray testsArray = doc.object().value("tests").toArray();
+    for (const QJsonValue &testValue : testsArray) {
+        QJsonObject testObj = testValue.toObject();
+        TestDefinition test = TestDefinition::fromJson(testObj);
+        test.filePath = filePath;
+        if (test.cases.isEmpty())
+            return fail(QString("В тесте \"%1\" архива нет ни одного случая.").arg(test.name));
+
+        const QJsonArray casesArray = testObj.value("cases").toArray();
+        for (int i = 0; i < casesArray.size() && i < test.cases.size(); ++i) {
+            QJsonObject caseObj = casesArray.at(i).toObject();
+            TestCase &testCase = test.cases[i];
+            if (!blob(caseObj.value("input"), &testCase.input)
+                || (caseObj.contains("expected") && !blob(caseObj.value("expected"), &testCase.expected)))
+                return fail(QString("Повреждены данные теста \"%1\" в архиве.").arg(test.name));
+            testCase.storage = archive;
+        }
+        loaded.append(test);
+    }
+
+    *tests = loaded;
+    return true;
+}
+
+
+void TestArchive::detach(QList<TestDefinition> *tests)
+{
+    for (TestDefinition &test : *tests) {
+        for (TestCase &testCase : test.cases) {
+            if (!testCase.storage)
+                continue;
+            testCase.input = QByteArray(testCase.input.constData(), testCase.input.size());
+            testCase.expected = QByteArray(testCase.expected.constData(), testCase.expected.size());
+            testCase.storage.reset();
+        }
+    }
+}
+
+
+bool TestArchive::write(const QString &filePath, const QList<TestDefinition> &tests, QString *error)
+{
+    // Запись через временный файл и переименование. В POSIX уже открытые
+    // отображения старого файла остаются действительными, а в Windows файл,
+    // отображённый в память, заменить нельзя: перед записью поверх архива
+    // все его отображения нужно закрыть (см. detach и TestCatalog::releaseFile).
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        if (error)
+            *error = "Не удалось записать архив тестов " + filePath + ".";
+        return false;
+    }
+
+    file.write(QByteArray(HeaderSize, '\0'));
+    qint64 offset = HeaderSize;
+    auto writeBlob = [&file, &offset](const QByteArray &bytes) {
+        QJsonArray range = blobRange(offset, bytes.size());
+        file.write(bytes);
+        offset += bytes.size();
+        return range;
+    };
+
+    QJsonArray testsArray;
+    for (const TestDefinition &test : tests) {
+        // Описание теста без случаев: их данные идут в блоки, а не в строки JSON.
+        TestDefinition description = test;
+        description.cases.clear();
+        QJsonObject testObj = description.toJson();
+
+        QJsonArray casesArray;
+        for (const TestCase &testCase : test.cases) {
+            QJsonObject caseObj;
+            caseObj["input"] = writeBlob(testCase.input);
+            if (test.reference.isEmpty())
+                caseObj["expected"] = writeBlob(testCase.expected);
+            if (testCase.weight != 1.0)
+                caseObj["weight"] = testCase.weight;
+            testCase.limits.writeJson(caseObj, &test.limits);
+            casesArray.append(caseObj);
+        }
+        testObj["cases"] = casesArray;
+        testsArray.append(testObj);
+    }
+
+    QJsonObject root;
+    root["tests"] = testsArray;
+    QByteArray index = QJsonDocument(root).toJson(QJsonDocument::Compact);
+    file.write(index);
+
+    uchar header[HeaderSize] = {};
+    std::memcpy(header, Magic, sizeof(Magic));
+    qToLittleEndian<quint32>(FormatVersion, header + 8);
+    qToLittleEndian<quint64>(quint64(offset), header + 16);
+    qToLittleEndian<quint64>(quint64(index.size()), header + 24);
+    file.seek(0);
+    file.write(reinterpret_cast<const char *>(header), HeaderSize);
+
+    if (!file.commit()) {
+        if (error)
+            *error = "Не удалось записать архив тестов " + filePath + ".";
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,35 @@
+#ifndef TESTARCHIVE_H
+#define TESTARCHIVE_H
+
+#include <QFile>
+#include <QList>
+#include <QString>
+#include "testdefinition.h"
+
+// Набор тестов в одном файле *.suite: заголовок фиксированного размера,
+// затем входы и ожидаемые выводы подряд как есть, а в конце компактный
+// JSON-индекс с описаниями тестов и смещениями данных каждого случая.
+// Файл отображается в память целиком; input и expected прочитанных случаев
+// указывают прямо в отображение, которое живёт, пока жив хотя бы один случай.
+class TestArchive
+{
+public:
+    static const char Extension[];
+
+    static bool isArchive(const QString &filePath);
+    static bool load(const QString &filePath, QList<TestDefinition> *tests, QString *error = nullptr);
+    static bool write(const QString &filePath, const QList<TestDefinition> &tests, QString *error = nullptr);
+    // Копирует данные случаев из отображений архивов в собственную память,
+    // чтобы тесты не держали файлы архивов открытыми.
+    static void detach(QList<TestDefinition> *tests);
+
+    ~TestArchive();
+
+private:
+    TestArchive() = default;
+
+    QFile file;
+    uchar *data = nullptr;
+};
+
+#endif // TESTARCHIVE_H
@@ -0,0 +1,255 @@
+#include "testcatalog.h"
+#include "testarchive.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QSet>
+#include <QTimer>
+#include <QColor>
+#include <QtConcurrent>
+
+namespace {
+
+// Редакторы часто сохраняют файл в несколько шагов; короткая пауза
+// собирает такие уведомления в один проход.
+const int RefreshDelayMs = 150;
+
+bool lessByFileName(const TestCatalog::Entry &entry, const QString &fileName)
+{
+    return entry.fileName < fileName;
+}
+
+}
+
+
+TestCatalog::TestCatalog(const QString &directory, QObject *parent)
+    : QAbstractListModel(parent),
+      testsDir(directory),
+      watcher(new QFileSystemWatcher(this)),
+      refreshTimer(new QTimer(this))
+{
+    QDir().mkpath(testsDir);
+    watcher->addPath(testsDir);
+
+    refreshTimer->setSingleShot(true);
+    refreshTimer->setInterval(RefreshDelayMs);
+
+    connect(watcher, &QFileSystemWatcher::directoryChanged, refreshTimer, qOverload<>(&QTimer::start));
+    connect(watcher, &QFileSystemWatcher::fileChanged, refreshTimer, qOverload<>(&QTimer::start));
+    connect(refreshTimer, &QTimer::timeout, this, &TestCatalog::refresh);
+    connect(&scanWatcher, &QFutureWatcher<ScanResult>::finished, this, &TestCatalog::applyScan);
+
+    refresh();
+}
+
+
+TestCatalog::~TestCatalog()
+{
+    scanWatcher.waitForFinished();
+}
+
+
+const TestCatalog::Entry *TestCatalog::entryAt(int row) const
+{
+    if (row < 0 || row >= items.size())
+        return nullptr;
+    return &items.at(row);
+}
+
+
+int TestCatalog::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : items.size();
+}
+
+
+QVariant TestCatalog::data(const QModelIndex &index, int role) const
+{
+    const Entry *entry = entryAt(index.row());
+    if (!entry || index.column() != 0)
+        return QVariant();
+
+    switch (role) {
+    case Qt::DisplayRole:
+        if (!entry->isValid())
+            return entry->fileName;
+        if (entry->test.cases.size() > 1)
+            return QString("%1 (%2 сл.)").arg(entry->test.name).arg(entry->test.cases.size());
+        return entry->test.name;
+    case Qt::ToolTipRole:
+        if (!entry->isValid())
+            return entry->fileName + ": " + entry->error;
+        return entry->test.description.isEmpty() ? entry->fileName
+                                                 : entry->fileName + "\n\n" + entry->test.description;
+    case Qt::ForegroundRole:
+        return entry->isValid() ? QVariant() : QVariant(QColor(Qt::red));
+    case FilePathRole:
+        return QDir(testsDir).filePath(entry->fileName);
+    case SearchRole:
+        return entry->fileName + '\n' + entry->test.name + '\n' + entry->test.description;
+    }
+    return QVariant();
+}
+
+
+bool TestCatalog::releaseFile(const QString &filePath)
+{
+    QFileInfo info(filePath);
+    if (QFileInfo(info.absolutePath()).canonicalFilePath() != QFileInfo(testsDir).canonicalFilePath())
+        return false;
+
+    auto first = std::lower_bound(items.begin(), items.end(), info.fileName(), lessByFileName);
+    int row = int(first - items.begin());
+    int count = 0;
+    while (row + count < items.size() && items.at(row + count).fileName == info.fileName())
+        ++count;
+    if (count == 0)
+        return false;
+
+    beginRemoveRows(QModelIndex(), row, row + count - 1);
+    items.remove(row, count);
+    endRemoveRows();
+    return true;
+}
+
+
+void TestCatalog::refresh()
+{
+    if (scanWatcher.isRunning()) {
+        rescanPending = true;
+        return;
+    }
+
+    QHash<QString, Stamp> known;
+    known.reserve(items.size());
+    for (const Entry &entry : std::as_const(items))
+        known.insert(entry.fileName, Stamp{entry.modifiedMs, entry.size});
+
+    scanWatcher.setFuture(QtConcurrent::run(&TestCatalog::scan, testsDir, known));
+}
+
+
+QList<TestCatalog::Entry> TestCatalog::loadDirectory(const QString &directory)
+{
+    return scan(directory, QHash<QString, Stamp>()).changed;
+}
+
+
+TestCatalog::ScanResult TestCatalog::scan(const QString &directory, const QHash<QString, Stamp> &known)
+{
+    ScanResult result;
+    QDir dir(directory);
+    const QStringList patterns = QStringList() << "*.json" << QString("*.") + TestArchive::Extension;
+    const QFileInfoList files = dir.entryInfoList(patterns, QDir::Files, QDir::Name);
+
+    for (const QFileInfo &info : files) {
+        result.fileNames << info.fileName();
+
+        qint64 modifiedMs = info.lastModified().toMSecsSinceEpoch();
+        auto it = known.constFind(info.fileName());
+        if (it != known.constEnd() && it->modifiedMs == modifiedMs && it->size == info.size())
+            continue;
+
+        Entry entry;
+        entry.fileName = info.fileName();
+        entry.modifiedMs = modifiedMs;
+        entry.size = info.size();
+
+        QList<TestDefinition> suite;
+        if (TestArchive::isArchive(info.fileName())
+            && TestArchive::load(info.filePath(), &suite, &entry.error) && !suite.isEmpty()) {
+            for (int i = 0; i < suite.size(); ++i) {
+                entry.suiteIndex = i;
+                entry.test = suite.at(i);
+                if (entry.test.name.isEmpty())
+                    entry.test.name = QString("%1 #%2").arg(info.completeBaseName()).arg(i + 1);
+                result.changed.append(entry);
+            }
+            continue;
+        }
+        if (TestArchive::isArchive(info.fileName())) {
+            if (entry.error.isEmpty())
+                entry.error = "Архив не содержит тестов.";
+        } else if (TestDefinition::load(info.filePath(), &entry.test, &entry.error)) {
+            entry.error.clear();
+            if (entry.test.name.isEmpty())
+                entry.test.name = info.completeBaseName();
+        }
+        result.changed.append(entry);
+    }
+
+    return result;
+}
+
+
+void TestCatalog::applyScan()
+{
+    const ScanResult result = scanWatcher.result();
+    const QSet<QString> present(result.fileNames.cbegin(), result.fileNames.cend());
+
+    QStringList removedPaths;
+    for (int row = items.size() - 1; row >= 0; --row) {
+        if (present.contains(items.at(row).fileName))
+            continue;
+        QString path = QDir(testsDir).filePath(items.at(row).fileName);
+        if (removedPaths.isEmpty() || removedPaths.last() != path)
+            removedPaths << path;
+        beginRemoveRows(QModelIndex(), row, row);
+        items.removeAt(row);
+        endRemoveRows();
+    }
+
+    // Изменённые записи одного файла идут подряд. Если число строк файла
+    // не изменилось, они заменяются на месте, иначе удаляются и вставляются заново.
+    QStringList addedPaths;
+    for (qsizetype begin = 0; begin < result.changed.size();) {
+        const QString &fileName = result.changed.at(begin).fileName;
+        qsizetype end = begin + 1;
+        while (end < result.changed.size() && result.changed.at(end).fileName == fileName)
+            ++end;
+
+        auto first = std::lower_bound(items.begin(), items.end(), fileName, lessByFileName);
+        int row = int(first - items.begin());
+        int oldCount = 0;
+        while (row + oldCount < items.size() && items.at(row + oldCount).fileName == fileName)
+            ++oldCount;
+        int newCount = int(end - begin);
+
+        if (oldCount == newCount) {
+            for (int i = 0; i < newCount; ++i)
+                items[row + i] = result.changed.at(begin + i);
+            emit dataChanged(index(row), index(row + newCount - 1));
+        } else {
+            if (oldCount > 0) {
+                beginRemoveRows(QModelIndex(), row, row + oldCount - 1);
+                items.remove(row, oldCount);
+                endRemoveRows();
+            }
+            beginInsertRows(QModelIndex(), row, row + newCount - 1);
+            for (int i = 0; i < newCount; ++i)
+                items.insert(row + i, result.changed.at(begin + i));
+            endInsertRows();
+        }
+
+        addedPaths << QDir(testsDir).filePath(fileName);
+        begin = end;
+    }
+
+    // Сохранение через переименование снимает наблюдение с файла, поэтому
+    // пути изменённых файлов добавляются заново.
+    if (!removedPaths.isEmpty())
+        watcher->removePaths(removedPaths);
+    const QStringList watched = watcher->files();
+    addedPaths.removeIf([&watched](const QString &path) { return watched.contains(path); });
+    if (!addedPaths.isEmpty())
+        watcher->addPaths(addedPaths);
+
+    loaded = true;
+    emit scanFinished();
+
+    if (rescanPending) {
+        rescanPending = false;
+        refresh();
+    }
+}
+
@@ -0,0 +1,89 @@
+#ifndef TESTCATALOG_H
+#define TESTCATALOG_H
+
+#include <QAbstractListModel>
+#include <QFutureWatcher>
+#include <QHash>
+#include <QList>
+#include "testdefinition.h"
+
+class QFileSystemWatcher;
+class QTimer;
+
+// Разобранные файлы каталога tests. Первичная загрузка и повторные проходы
+// идут в фоне; QFileSystemWatcher сообщает об изменениях, и заново читаются
+// только файлы с другими временем изменения или размером. Архив *.suite
+// даёт по строке на каждый свой тест.
+class TestCatalog : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    enum Role {
+        FilePathRole = Qt::UserRole,
+        SearchRole
+    };
+
+    struct Entry
+    {
+        QString fileName;
+        int suiteIndex = -1; // номер теста в архиве *.suite, -1 — отдельный файл JSON
+        qint64 modifiedMs = 0;
+        qint64 size = -1;
+        QString error;
+        TestDefinition test;
+
+        bool isValid() const { return error.isEmpty(); }
+    };
+
+    explicit TestCatalog(const QString &directory, QObject *parent = nullptr);
+    ~TestCatalog() override;
+
+    QString directory() const { return testsDir; }
+    const QList<Entry> &entries() const { return items; }
+    const Entry *entryAt(int row) const;
+    bool isLoaded() const { return loaded; }
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+    // Убирает записи файла filePath из каталога, чтобы каталог не держал его
+    // отображение (архив перед заменой); следующий проход прочитает файл
+    // заново. Возвращает false, если таких записей нет.
+    bool releaseFile(const QString &filePath);
+
+    // Синхронный проход без модели — для пакетного режима без цикла событий.
+    static QList<Entry> loadDirectory(const QString &directory);
+
+public slots:
+    void refresh();
+
+signals:
+    void scanFinished();
+
+private:
+    struct Stamp
+    {
+        qint64 modifiedMs;
+        qint64 size;
+    };
+
+    struct ScanResult
+    {
+        QStringList fileNames;
+        QList<Entry> changed;
+    };
+
+    static ScanResult scan(const QString &directory, const QHash<QString, Stamp> &known);
+    void applyScan();
+
+    QString testsDir;
+    QList<Entry> items;
+    QFileSystemWatcher *watcher;
+    QTimer *refreshTimer;
+    QFutureWatcher<ScanResult> scanWatcher;
+    bool rescanPending = false;
+    bool loaded = false;
+};
+
+#endif // TESTCATALOG_H
@@ -0,0 +1,150 @@
+#include "testdefinition.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+
+bool TestDefinition::load(const QString &filePath, TestDefinition *test, QString *error)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (error)
+            *error = "Не удалось открыть файл теста.";
+        return false;
+    }
+
+    QJsonParseError parseError;
+    QJsonDocument doc = QJsonDocument::fromJson(file.readAll(), &parseError);
+    file.close();
+
+    if (parseError.error != QJsonParseError::NoError || !doc.isObject()) {
+        if (error)
+            *error = "Неверный формат файла теста.";
+        return false;
+    }
+
+    TestDefinition loaded = fromJson(doc.object());
+    if (loaded.cases.isEmpty()) {
+        // Иначе такой тест «проходился» бы любым решением: 0 из 0 случаев.
+        if (error)
+            *error = "В тесте нет ни одного случая.";
+        return false;
+    }
+
+    *test = loaded;
+    test->filePath = filePath;
+    return true;
+}
+
+
+TestDefinition TestDefinition::fromJson(const QJsonObject &obj)
+{
+    TestDefinition test;
+    test.name = obj.value("name").toString();
+    test.description = obj.value("description").toString();
+    test.reference = obj.value("reference").toString().trimmed();
+
+    const QJsonArray forbiddenArray = obj.value("forbidden").toArray();
+    for (const QJsonValue &val : forbiddenArray) {
+        QString keyword = val.toString().trimmed();
+        if (!keyword.isEmpty())
+            test.forbidden << keyword;
+    }
+
+    test.limits = ResourceLimits::fromJson(obj);
+    test.checker = OutputChecker::Options::fromJson(obj);
+
+    if (!obj.contains("cases")) {
+        TestCase testCase;
+        testCase.input = obj.value("input").toString().toUtf8();
+        testCase.expected = obj.value("expected").toString().toUtf8();
+        testCase.limits = test.limits;
+        test.cases.append(testCase);
+        return test;
+    }
+
+    const QJsonArray casesArray = obj.value("cases").toArray();
+    for (const QJsonValue &val : casesArray) {
+        QJsonObject caseObj = val.toObject();
+        TestCase testCase;
+        testCase.input = caseObj.value("input").toString().toUtf8();
+        testCase.expected = caseObj.value("expected").toString().toUtf8();
+        testCase.limits = ResourceLimits::fromJson(caseObj, test.limits);
+        testCase.weight = caseObj.value("weight").toDouble(1.0);
+        test.cases.append(testCase);
+    }
+    return test;
+}
+
+
+QJsonObject TestDefinition::toJson() const
+{
+    QJsonObject obj;
+    obj["name"] = name;
+    obj["description"] = description;
+    if (!reference.isEmpty())
+        obj["reference"] = reference;
+
+    QJsonArray forbiddenArray;
+    for (const QString &s : forbidden)
+        forbiddenArray.append(s);
+
+    obj["forbidden"] = forbiddenArray;
+    limits.writeJson(obj);
+    checker.writeJson(obj);
+
+    QJsonArray casesArray;
+    for (const TestCase &testCase : cases) {
+        QJsonObject caseObj;
+        caseObj["input"] = QString::fromUtf8(testCase.input);
+        if (reference.isEmpty())
+            caseObj["expected"] = QString::fromUtf8(testCase.expected);
+        if (testCase.weight != 1.0)
+            caseObj["weight"] = testCase.weight;
+        testCase.limits.writeJson(caseObj, &limits);
+        casesArray.append(caseObj);
+    }
+    obj["cases"] = casesArray;
+
+    return obj;
+}
+
+
+bool TestDefinition::save(const QString &filePath, QString *error) const
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        if (error)
+            *error = "Не удалось записать файл теста.";
+        return false;
+    }
+
+    file.write(QJsonDocument(toJson()).toJson(QJsonDocument::Indented));
+    return true;
+}
+
+
+QString TestDefinition::referencePath() const
+{
+    if (reference.isEmpty() || QFileInfo(reference).isAbsolute() || filePath.isEmpty())
+        return reference;
+    return QFileInfo(filePath).dir().filePath(reference);
+}
+
+
+double TestDefinition::totalWeight() const
+{
+    double total = 0;
+    for (const TestCase &testCase : cases)
+        total += testCase.weight;
+    return total;
+}
+
+
+QList<ForbiddenScanner::Violation> TestDefinition::findForbidden(const QString &code) const
+{
+    if (forbidden.isEmpty())
+        return QList<ForbiddenScanner::Violation>();
+    return ForbiddenScanner(forbidden).scan(code);
+}
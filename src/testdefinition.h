@@ -0,0 +1,53 @@
+#ifndef TESTDEFINITION_H
+#define TESTDEFINITION_H
+
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QJsonObject>
+#include <QList>
+#include <QSharedPointer>
+#include "resourcelimits.h"
+#include "outputchecker.h"
+#include "forbiddenscanner.h"
+
+class TestArchive;
+
+struct TestCase
+{
+    QByteArray input;
+    QByteArray expected;
+    ResourceLimits limits;
+    double weight = 1.0;
+    // Для случаев из архива *.suite input и expected не владеют данными,
+    // а указывают в его отображение в память; пусто у тестов из JSON.
+    QSharedPointer<const TestArchive> storage;
+};
+
+// Файл теста: общие название, описание, запрещённые конструкции, способ
+// сравнения и ограничения по умолчанию плюс массив случаев "cases".
+// Старые файлы с единственной парой "input"/"expected" читаются как один случай.
+// Если задан "reference", ожидаемый вывод случаев не хранится в файле, а
+// вычисляется эталонным решением (см. ReferenceResolver).
+struct TestDefinition
+{
+    QString filePath;
+    QString name;
+    QString description;
+    QString reference; // путь к исходнику эталона, относительный — от каталога файла теста
+    QStringList forbidden;
+    ResourceLimits limits;
+    OutputChecker::Options checker;
+    QList<TestCase> cases;
+
+    static bool load(const QString &filePath, TestDefinition *test, QString *error = nullptr);
+    static TestDefinition fromJson(const QJsonObject &obj);
+    QJsonObject toJson() const;
+    bool save(const QString &filePath, QString *error = nullptr) const;
+
+    QString referencePath() const;
+    double totalWeight() const;
+    QList<ForbiddenScanner::Violation> findForbidden(const QString &code) const;
+};
+
+#endif // TESTDEFINITION_H
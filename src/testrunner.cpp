@@ -0,0 +1,298 @@
+#include "testrunner.h"
+#include "stagetrace.h"
+#include <QFileInfo>
+#include <QTimer>
+
+#ifdef Q_OS_LINUX
+#include <csignal>
+#endif
+
+namespace {
+
+// Вывод целиком не хранится: сравнение идёт потоково, а для отчёта
+// достаточно начала.
+const qsizetype OutputPreviewLimit = 64 * 1024;
+
+// Вход отдаётся программе кусками по мере того, как она его читает:
+// QProcess копирует всё записанное в свой буфер, а вход из архива
+// тестов лучше брать прямо из отображения файла.
+const qsizetype InputChunkSize = 256 * 1024;
+
+}
+
+QString TestResult::verdictName(Verdict verdict)
+{
+    switch (verdict) {
+    case Verdict::Passed:
+        return "Пройден";
+    case Verdict::WrongAnswer:
+        return "Неверный ответ";
+    case Verdict::TimeLimit:
+        return "Превышено время (TLE)";
+    case Verdict::MemoryLimit:
+        return "Превышена память (MLE)";
+    case Verdict::OutputLimit:
+        return "Превышен объём вывода (OLE)";
+    case Verdict::RuntimeError:
+        return "Ошибка выполнения (RE)";
+    case Verdict::Forbidden:
+        return "Запрещённая конструкция";
+    case Verdict::Cancelled:
+        return "Отменён";
+    }
+    return QString();
+}
+
+
+QString TestResult::verdictCode(Verdict verdict)
+{
+    switch (verdict) {
+    case Verdict::Passed:
+        return "OK";
+    case Verdict::WrongAnswer:
+        return "WA";
+    case Verdict::TimeLimit:
+        return "TLE";
+    case Verdict::MemoryLimit:
+        return "MLE";
+    case Verdict::OutputLimit:
+        return "OLE";
+    case Verdict::RuntimeError:
+        return "RE";
+    case Verdict::Forbidden:
+        return "FORBIDDEN";
+    case Verdict::Cancelled:
+        return "CANCELLED";
+    }
+    return QString();
+}
+
+
+TestRunner::TestRunner(const QString &executable, const TestDefinition &test, int caseIndex, QObject *parent)
+    : QObject(parent),
+      executable(executable),
+      definition(test),
+      testCaseIndex(caseIndex),
+      process(new QProcess(this)),
+      timeoutTimer(new QTimer(this)),
+      checker(test.cases.at(caseIndex).expected, test.checker)
+{
+    process->setWorkingDirectory(QFileInfo(executable).path());
+    timeoutTimer->setSingleShot(true);
+    runLimits = test.cases.at(caseIndex).limits;
+
+    connect(process, &QProcess::started, this, &TestRunner::onStarted);
+    connect(process, &QProcess::readyReadStandardOutput, this, &TestRunner::onReadyReadStandardOutput);
+    connect(process, &QProcess::bytesWritten, this, &TestRunner::writeInput);
+    connect(process, &QProcess::finished, this, &TestRunner::onProcessFinished);
+    connect(process, &QProcess::errorOccurred, this, &TestRunner::onProcessError);
+    connect(timeoutTimer, &QTimer::timeout, this, &TestRunner::onTimeout);
+}
+
+
+void TestRunner::start()
+{
+    if (running)
+        return;
+
+    running = true;
+    testResult = TestResult();
+    testResult.caseIndex = testCaseIndex;
+    monitor.attach(process, runLimits);
+    wallTimer.start();
+    testResult.startedAtUs = StageTrace::nowUs();
+    process->start(executable, QStringList());
+}
+
+
+void TestRunner::cancel()
+{
+    if (!running)
+        return;
+
+    cancelRequested = true;
+    if (process->state() == QProcess::NotRunning)
+        finish(TestResult::Verdict::Cancelled);
+    else
+        process->kill();
+}
+
+
+void TestRunner::onStarted()
+{
+    monitor.processStarted();
+    testResult.launchUs = wallTimer.nsecsElapsed() / 1000;
+    wallTimer.restart();
+    timeoutTimer->start(runLimits.timeLimitMs);
+
+    inputWritten = 0;
+    inputClosed = false;
+    writeInput();
+}
+
+
+void TestRunner::writeInput()
+{
+    const QByteArray &input = testCase().input;
+    if (inputClosed || process->bytesToWrite() >= InputChunkSize)
+        return;
+
+    qsizetype size = qMin(InputChunkSize, input.size() - inputWritten);
+    if (size > 0)
+        process->write(input.constData() + inputWritten, size);
+    inputWritten += size;
+    if (inputWritten >= input.size()) {
+        inputClosed = true;
+        process->closeWriteChannel();
+    }
+}
+
+
+void TestRunner::onReadyReadStandardOutput()
+{
+    QByteArray chunk = process->readAllStandardOutput();
+    if (chunk.isEmpty())
+        return;
+
+    testResult.outputBytes += chunk.size();
+    if (testResult.output.size() < OutputPreviewLimit)
+        testResult.output += chunk.left(OutputPreviewLimit - testResult.output.size());
+
+    if (!checkerStopped) {
+        qint64 checkStartUs = StageTrace::nowUs();
+        bool matches = checker.feed(chunk);
+        testResult.checkUs += StageTrace::nowUs() - checkStartUs;
+        if (!matches) {
+            checkerStopped = true;
+            process->kill();
+            return;
+        }
+    }
+
+    if (runLimits.outputLimitKb > 0 && !outputExceeded
+        && testResult.outputBytes > qint64(runLimits.outputLimitKb) * 1024) {
+        outputExceeded = true;
+        process->kill();
+    }
+}
+
+
+void TestRunner::onProcessFinished(int exitCode, QProcess::ExitStatus exitStatus)
+{
+    timeoutTimer->stop();
+    testResult.wallUs = wallTimer.nsecsElapsed() / 1000;
+    testResult.wallMs = testResult.wallUs / 1000;
+    onReadyReadStandardOutput();
+    testResult.errorOutput = process->readAllStandardError();
+    testResult.exitCode = exitStatus == QProcess::NormalExit ? exitCode : -1;
+    testResult.usage = monitor.collect();
+
+    if (cancelRequested) {
+        finish(TestResult::Verdict::Cancelled);
+        return;
+    }
+    if (checkerStopped && !timedOut) {
+        testResult.details = checker.report() + "\nПрограмма остановлена на первом расхождении.";
+        finish(TestResult::Verdict::WrongAnswer);
+        return;
+    }
+    if (classifyFailure(testResult, runLimits, timedOut, outputExceeded, exitCode, exitStatus)) {
+        finish(testResult.verdict);
+        return;
+    }
+
+    qint64 checkStartUs = StageTrace::nowUs();
+    bool matches = checker.finish();
+    testResult.checkUs += StageTrace::nowUs() - checkStartUs;
+    if (matches) {
+        finish(TestResult::Verdict::Passed);
+    } else {
+        testResult.details = checker.report();
+        finish(TestResult::Verdict::WrongAnswer);
+    }
+}
+
+
+void TestRunner::onProcessError(QProcess::ProcessError error)
+{
+    if (error != QProcess::FailedToStart)
+        return;
+
+    testResult.details = "Не удалось запустить " + executable + ": " + process->errorString();
+    finish(cancelRequested ? TestResult::Verdict::Cancelled : TestResult::Verdict::RuntimeError);
+}
+
+
+bool TestRunner::classifyFailure(TestResult &result, const ResourceLimits &limits, bool timedOut, bool outputExceeded,
+                                 int exitCode, QProcess::ExitStatus exitStatus)
+{
+    const ResourceUsage &usage = result.usage;
+
+    if (timedOut) {
+        result.details = QString("Программа не завершилась за %1 мс.").arg(limits.timeLimitMs);
+        result.verdict = TestResult::Verdict::TimeLimit;
+        return true;
+    }
+    if (outputExceeded) {
+        result.details = QString("Вывод превысил %1 КБ.").arg(limits.outputLimitKb);
+        result.verdict = TestResult::Verdict::OutputLimit;
+        return true;
+    }
+
+#ifdef Q_OS_LINUX
+    if (usage.signal == SIGXCPU
+        || (usage.signal == SIGKILL && limits.cpuLimitMs > 0 && usage.cpuMs() >= limits.cpuLimitMs)) {
+        result.details = QString("Процессорное время превысило %1 мс.").arg(limits.cpuLimitMs);
+        result.verdict = TestResult::Verdict::TimeLimit;
+        return true;
+    }
+    if (usage.signal == SIGXFSZ) {
+        result.details = QString("Размер записанного файла превысил %1 КБ.").arg(limits.outputLimitKb);
+        result.verdict = TestResult::Verdict::OutputLimit;
+        return true;
+    }
+#endif
+
+    bool failed = exitStatus != QProcess::NormalExit || exitCode != 0;
+    if (limits.memoryLimitMb > 0) {
+        qint64 limitKb = qint64(limits.memoryLimitMb) * 1024;
+        bool allocationFailed = result.errorOutput.contains("bad_alloc")
+                                || result.errorOutput.contains("Cannot allocate memory");
+        if (usage.peakRssKb > limitKb || (failed && allocationFailed)) {
+            result.details = QString("Память превысила %1 МБ.").arg(limits.memoryLimitMb);
+            result.verdict = TestResult::Verdict::MemoryLimit;
+            return true;
+        }
+    }
+
+    if (failed) {
+        if (exitStatus == QProcess::NormalExit)
+            result.details = QString("Код выхода %1.").arg(exitCode);
+        else if (usage.signal != 0)
+            result.details = QString("Программа завершилась по сигналу %1.").arg(usage.signal);
+        else
+            result.details = "Программа завершилась аварийно.";
+        result.verdict = TestResult::Verdict::RuntimeError;
+        return true;
+    }
+
+    return false;
+}
+
+
+void TestRunner::onTimeout()
+{
+    timedOut = true;
+    process->kill();
+}
+
+
+void TestRunner::finish(TestResult::Verdict verdict)
+{
+    if (!running)
+        return;
+
+    running = false;
+    testResult.verdict = verdict;
+    emit finished();
+}
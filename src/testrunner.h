@@ -0,0 +1,101 @@
+#ifndef TESTRUNNER_H
+#define TESTRUNNER_H
+
+#include <QObject>
+#include <QProcess>
+#include <QElapsedTimer>
+#include "testdefinition.h"
+
+class QTimer;
+
+struct TestResult
+{
+    enum class Verdict {
+        Passed,
+        WrongAnswer,
+        TimeLimit,
+        MemoryLimit,
+        OutputLimit,
+        RuntimeError,
+        Forbidden,
+        Cancelled
+    };
+
+    Verdict verdict = Verdict::Cancelled;
+    int caseIndex = 0;
+    int exitCode = -1;
+    qint64 wallMs = 0;
+    qint64 wallUs = 0;
+    qint64 startedAtUs = 0; // по часам StageTrace::nowUs()
+    qint64 launchUs = 0;    // от вызова start() до сигнала started
+    qint64 checkUs = 0;     // суммарное время сравнения вывода
+    QByteArray output;
+    qint64 outputBytes = 0;
+    QByteArray errorOutput;
+    QString details;
+    ResourceUsage usage;
+
+    bool passed() const { return verdict == Verdict::Passed; }
+    static QString verdictName(Verdict verdict);
+    static QString verdictCode(Verdict verdict);
+};
+
+class TestRunner : public QObject
+{
+    Q_OBJECT
+
+public:
+    TestRunner(const QString &executable, const TestDefinition &test, int caseIndex, QObject *parent = nullptr);
+
+    const TestDefinition &test() const { return definition; }
+    int caseIndex() const { return testCaseIndex; }
+    const TestCase &testCase() const { return definition.cases.at(testCaseIndex); }
+    const TestResult &result() const { return testResult; }
+    bool isRunning() const { return running; }
+
+    void setLimits(const ResourceLimits &limits) { runLimits = limits; }
+
+    // Вердикт по тому, как завершилась программа: TLE, OLE, MLE или RE.
+    // Возвращает false, если программа завершилась нормально и осталось
+    // только сравнить вывод.
+    static bool classifyFailure(TestResult &result, const ResourceLimits &limits, bool timedOut, bool outputExceeded,
+                                int exitCode, QProcess::ExitStatus exitStatus);
+
+public slots:
+    void start();
+    void cancel();
+
+signals:
+    void finished();
+
+private slots:
+    void onStarted();
+    void writeInput();
+    void onReadyReadStandardOutput();
+    void onProcessFinished(int exitCode, QProcess::ExitStatus exitStatus);
+    void onProcessError(QProcess::ProcessError error);
+    void onTimeout();
+
+private:
+    void finish(TestResult::Verdict verdict);
+
+    QString executable;
+    TestDefinition definition;
+    int testCaseIndex;
+    TestResult testResult;
+    QProcess *process;
+    QTimer *timeoutTimer;
+    QElapsedTimer wallTimer;
+    ResourceLimits runLimits;
+    qsizetype inputWritten = 0;
+    bool inputClosed = false;
+    ResourceMonitor monitor;
+    OutputChecker checker;
+    bool checkerStopped = false;
+    bool running = false;
+    bool timedOut = false;
+    bool outputExceeded = false;
+    bool cancelRequested = false;
+};
+
+#endif // TESTRUNNER_H
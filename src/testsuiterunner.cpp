@@ -0,0 +1,242 @@
+#include "testsuiterunner.h"
+#include "compilejob.h"
+#include "forkserver.h"
+#include <QFile>
+#include <QThread>
+
+TestSuiteRunner::TestSuiteRunner(const QString &executable, const QList<TestDefinition> &tests, QObject *parent)
+    : QObject(parent),
+      executable(executable),
+      tests(tests),
+      maxParallel(qMax(1, QThread::idealThreadCount()))
+{
+    for (int testIndex = 0; testIndex < tests.size(); ++testIndex) {
+        const TestDefinition &test = tests.at(testIndex);
+        TestProgress testProgress;
+        testProgress.remaining = test.cases.size();
+        progress.append(testProgress);
+
+        for (int caseIndex = 0; caseIndex < test.cases.size(); ++caseIndex)
+            jobs.append({testIndex, caseIndex});
+        totalWeight += test.totalWeight();
+    }
+}
+
+
+void TestSuiteRunner::start()
+{
+    if (running)
+        return;
+
+    running = true;
+    timer.start();
+    if (jobs.isEmpty()) {
+        running = false;
+        emit allFinished();
+        return;
+    }
+
+    if (!forkServerCompiler.isEmpty() && ForkServer::isSupported()) {
+        usingForkServer = true;
+        startForkServers();
+        return;
+    }
+    startNext();
+}
+
+
+void TestSuiteRunner::setMaxParallel(int count)
+{
+    maxParallel = qMax(1, count);
+    if (running)
+        startNext();
+}
+
+
+void TestSuiteRunner::cancel()
+{
+    if (!running)
+        return;
+
+    cancelled = true;
+    const QList<TestRunner *> runners = active;
+    for (TestRunner *runner : runners)
+        runner->cancel();
+    const QList<ForkServer *> forkServers = servers;
+    for (ForkServer *server : forkServers)
+        server->cancel();
+    if (shimJob)
+        shimJob->cancel();
+}
+
+
+void TestSuiteRunner::startNext()
+{
+    if (usingForkServer)
+        return;
+
+    while (!cancelled && active.size() < maxParallel && nextIndex < jobs.size()) {
+        Job job = jobs.at(nextIndex++);
+        auto *runner = new TestRunner(executable, tests.at(job.testIndex), job.caseIndex, this);
+        if (!addressSpaceLimit) {
+            ResourceLimits limits = runner->testCase().limits;
+            limits.limitAddressSpace = false;
+            runner->setLimits(limits);
+        }
+        active.append(runner);
+
+        connect(runner, &TestRunner::finished, this, [this, runner, job] {
+            active.removeOne(runner);
+            runner->deleteLater();
+
+            recordResult(job, runner->result());
+            startNext();
+            finishIfDone();
+        });
+
+        runner->start();
+    }
+}
+
+
+void TestSuiteRunner::startForkServers()
+{
+    QString shim = ForkServer::shimPath(forkServerCompiler);
+    if (QFile::exists(shim)) {
+        launchForkServers(shim);
+        return;
+    }
+
+    QString error;
+    shimJob = ForkServer::createShimJob(forkServerCompiler, this, &error);
+    if (!shimJob) {
+        fallBack(error);
+        return;
+    }
+
+    connect(shimJob, &CompileJob::finished, this, [this, shim] {
+        CompileJob *job = shimJob;
+        shimJob = nullptr;
+        job->deleteLater();
+
+        QString error;
+        bool installed = ForkServer::installShim(job, forkServerCompiler, &error);
+        if (cancelled) {
+            finishIfDone();
+            return;
+        }
+        if (!installed) {
+            fallBack(error);
+            return;
+        }
+        launchForkServers(shim);
+    });
+
+    emit message("Сборка прослойки fork-server...\n");
+    shimJob->start();
+}
+
+
+void TestSuiteRunner::launchForkServers(const QString &shim)
+{
+    int count = qMin(maxParallel, int(jobs.size() - nextIndex));
+    for (int i = 0; i < count; ++i) {
+        auto *server = new ForkServer(executable, shim, this);
+        servers.append(server);
+
+        connect(server, &ForkServer::started, this, [this, server] {
+            dispatch(server);
+        });
+        connect(server, &ForkServer::caseFinished, this, [this, server](const TestResult &result) {
+            Job job = serverJobs.take(server);
+            ++forkServerCases;
+            recordResult(job, result);
+            dispatch(server);
+        });
+        connect(server, &ForkServer::exited, this, [this, server](const QString &reason) {
+            forkServerExited(server, reason);
+        });
+
+        server->start();
+    }
+}
+
+
+void TestSuiteRunner::dispatch(ForkServer *server)
+{
+    if (!server->isReady())
+        return;
+    if (cancelled || nextIndex >= jobs.size()) {
+        server->stop();
+        return;
+    }
+
+    Job job = jobs.at(nextIndex++);
+    serverJobs.insert(server, job);
+    ResourceLimits limits = tests.at(job.testIndex).cases.at(job.caseIndex).limits;
+    if (!addressSpaceLimit)
+        limits.limitAddressSpace = false;
+    server->run(tests.at(job.testIndex), job.caseIndex, limits);
+}
+
+
+void TestSuiteRunner::forkServerExited(ForkServer *server, const QString &reason)
+{
+    servers.removeOne(server);
+    serverJobs.remove(server);
+    server->deleteLater();
+
+    if (!reason.isEmpty() && !cancelled && nextIndex < jobs.size()) {
+        // Остальные серверы продолжают работу; обычный путь — только когда
+        // не осталось ни одного.
+        if (servers.isEmpty())
+            fallBack(reason);
+        else
+            emit message(reason + "\n");
+        return;
+    }
+    finishIfDone();
+}
+
+
+void TestSuiteRunner::fallBack(const QString &reason)
+{
+    emit message(reason + " Случаи запускаются через обычный QProcess.\n");
+    usingForkServer = false;
+    startNext();
+    finishIfDone();
+}
+
+
+void TestSuiteRunner::recordResult(const Job &job, const TestResult &result)
+{
+    const TestDefinition &test = tests.at(job.testIndex);
+    const TestCase &testCase = test.cases.at(job.caseIndex);
+    TestProgress &testProgress = progress[job.testIndex];
+    --testProgress.remaining;
+    ++finished;
+    if (result.passed()) {
+        ++passed;
+        testProgress.score += testCase.weight;
+        totalScore += testCase.weight;
+    } else {
+        testProgress.passed = false;
+    }
+
+    emit caseFinished(job.testIndex, test, result);
+    if (testProgress.remaining == 0)
+        emit testFinished(job.testIndex, test, testProgress.score, testProgress.passed);
+}
+
+
+void TestSuiteRunner::finishIfDone()
+{
+    if (!running || !active.isEmpty() || !servers.isEmpty() || shimJob)
+        return;
+    if (!cancelled && nextIndex < jobs.size())
+        return;
+
+    running = false;
+    elapsed = timer.elapsed();
+    emit allFinished();
+}
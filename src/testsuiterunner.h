@@ -0,0 +1,100 @@
+#ifndef TESTSUITERUNNER_H
+#define TESTSUITERUNNER_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include "testrunner.h"
+
+class CompileJob;
+class ForkServer;
+
+// Прогоняет все случаи набора тестов против одного исполняемого файла:
+// каждый случай в своём QProcess, одновременно не больше maxParallel процессов.
+// С fork-server программа запускается maxParallel раз, а случаи выполняются
+// в fork() её инициализированного процесса; если сервер не поднялся,
+// оставшиеся случаи идут обычным путём.
+class TestSuiteRunner : public QObject
+{
+    Q_OBJECT
+
+public:
+    TestSuiteRunner(const QString &executable, const QList<TestDefinition> &tests, QObject *parent = nullptr);
+
+    // Во время прогона новые места занимаются сразу; число серверов
+    // fork-server задаётся при старте и потом не меняется.
+    void setMaxParallel(int count);
+    void setAddressSpaceLimit(bool enabled) { addressSpaceLimit = enabled; }
+    // Пустой compiler — обычный запуск; иначе им собирается прослойка fork-server.
+    void setForkServer(const QString &compiler) { forkServerCompiler = compiler; }
+    int testCount() const { return tests.size(); }
+    int caseCount() const { return jobs.size(); }
+    int finishedCount() const { return finished; }
+    int passedCount() const { return passed; }
+    double score() const { return totalScore; }
+    double maxScore() const { return totalWeight; }
+    bool isRunning() const { return running; }
+    bool wasCancelled() const { return cancelled; }
+    bool usedForkServer() const { return forkServerCases > 0; }
+    int forkServerCaseCount() const { return forkServerCases; }
+    qint64 elapsedMs() const { return elapsed; }
+
+public slots:
+    void start();
+    void cancel();
+
+signals:
+    void caseFinished(int testIndex, const TestDefinition &test, const TestResult &result);
+    void testFinished(int testIndex, const TestDefinition &test, double score, bool passed);
+    void allFinished();
+    void message(const QString &text);
+
+private:
+    struct Job
+    {
+        int testIndex;
+        int caseIndex;
+    };
+
+    struct TestProgress
+    {
+        int remaining = 0;
+        double score = 0;
+        bool passed = true;
+    };
+
+    void startNext();
+    void startForkServers();
+    void launchForkServers(const QString &shim);
+    void dispatch(ForkServer *server);
+    void forkServerExited(ForkServer *server, const QString &reason);
+    void fallBack(const QString &reason);
+    void recordResult(const Job &job, const TestResult &result);
+    void finishIfDone();
+
+    QString executable;
+    QList<TestDefinition> tests;
+    QList<Job> jobs;
+    QList<TestProgress> progress;
+    QList<TestRunner *> active;
+    int maxParallel;
+    bool addressSpaceLimit = true;
+    QString forkServerCompiler;
+    bool usingForkServer = false;
+    CompileJob *shimJob = nullptr;
+    QList<ForkServer *> servers;
+    QHash<ForkServer *, Job> serverJobs;
+    int forkServerCases = 0;
+    QElapsedTimer timer;
+    qint64 elapsed = 0;
+    int nextIndex = 0;
+    int finished = 0;
+    int passed = 0;
+    double totalScore = 0;
+    double totalWeight = 0;
+    bool running = false;
+    bool cancelled = false;
+};
+
+#endif // TESTSUITERUNNER_H